@@ -96,6 +96,8 @@ void vw_opts::usage()
 "       mirrors; axes, mirrors and rot-reflection planes; none\n"
 "   O - show/hide orientation, toggle colouring of the front side of \n"
 "       faces white and the back side black\n"
+"   i - show/hide frame time, toggle display in the window title of the\n"
+"       time taken to draw a frame\n"
 "   r - reset, reset to the initial viewing options \n"
 "   Q - Quit\n"
 "\n"
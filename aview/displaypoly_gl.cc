@@ -43,6 +43,7 @@
 #include <OpenGL/glu.h>
 #endif
 
+#include <map>
 #include <string.h>
 #include <vector>
 
@@ -50,6 +51,7 @@
 #include "displaypoly_gl.h"
 #include "gl_writer.h"
 
+using std::map;
 using std::vector;
 
 using namespace anti;
@@ -73,115 +75,286 @@ void gl_set_material(Color col, bool trans, int sides)
     glPolygonStipple(stippleMask[int(cv[3] * 16 + 0.5)]);
 }
 
-void DisplayPoly_gl::gl_verts(const Scene &scen)
+unsigned int GlLists::get(unsigned int idx)
 {
-  double v_rad = get_vert_rad();
-  double extra = 10 * v_rad / scen.get_width();
-  int long_div = int(11 * (1 + extra));
-  int lat_div = int(7 * (1 + extra));
-  GLUquadric *quad = gluNewQuadric();
-  GLuint sph = glGenLists(1);
-  glNewList(sph, GL_COMPILE);
-  gluSphere(quad, v_rad, long_div, lat_div);
-  glEndList();
+  if (idx >= lists.size())
+    lists.resize(idx + 1, List{0, vector<double>()});
+  if (!lists[idx].name)
+    lists[idx].name = glGenLists(1);
+  return lists[idx].name;
+}
 
-  const vector<Vec3d> &verts = disp_geom.verts();
-  for (unsigned int i = 0; i < verts.size(); i++) {
-    Color col = disp_geom.colors(VERTS).get((int)i);
-    if (col.is_index())
-      col = clrng(VERTS).get_col(col.get_index());
-    if (!col.is_value())
-      col = def_col(VERTS); // use default
-    if (col.is_invisible())
-      continue;
+bool GlLists::set_vals(unsigned int idx, const vector<double> &vals)
+{
+  get(idx);
+  if (lists[idx].vals == vals)
+    return true;
+  lists[idx].vals = vals;
+  return false;
+}
+
+void GlLists::changed()
+{
+  for (auto &list : lists)
+    list.vals.clear();
+}
+
+void GlLists::clear()
+{
+  for (auto &list : lists)
+    if (list.name)
+      glDeleteLists(list.name, 1);
+  lists.clear();
+}
+
+namespace {
+
+// Triangles, with a normal for each vertex, to draw with a single call
+class GlMesh {
+private:
+  vector<GLfloat> coords;
+  vector<GLfloat> norms;
+  vector<GLuint> tris;
+
+public:
+  GLuint num_verts() const { return coords.size() / 3; }
+  GLuint add_vert(const Vec3d &pt, const Vec3d &norm);
+  void add_tri(GLuint v0, GLuint v1, GLuint v2);
+  void add(const GlMesh &mesh, const Trans3d &trans, const Trans3d &rot);
+  void draw() const;
+};
+
+} // namespace
 
-    gl_set_material(col, get_elem_trans(), GL_FRONT);
-    glPushMatrix();
-    glTranslated(verts[i][0], verts[i][1], verts[i][2]);
-    glCallList(sph);
-    glPopMatrix();
+GLuint GlMesh::add_vert(const Vec3d &pt, const Vec3d &norm)
+{
+  for (int i = 0; i < 3; i++) {
+    coords.push_back(pt[i]);
+    norms.push_back(norm[i]);
   }
-  glDeleteLists(sph, 1);
-  gluDeleteQuadric(quad);
+  return num_verts() - 1;
 }
 
-static void edge_cyl_trans(Vec3d p1, Vec3d p2)
+void GlMesh::add_tri(GLuint v0, GLuint v1, GLuint v2)
 {
-  Vec3d p1to2 = p2 - p1;
-  glTranslated(p1[0], p1[1], p1[2]);
-  Trans3d rot = Trans3d::rotate(Vec3d(0, 0, 1), p1to2);
-  glMultMatrixd(rot.transpose().get_m());
-  glScaled(1, 1, p1to2.len());
+  tris.push_back(v0);
+  tris.push_back(v1);
+  tris.push_back(v2);
 }
 
-void DisplayPoly_gl::gl_edges(const Scene &scen)
+// Add a transformed copy of a mesh, rot is the rotation part of trans
+void GlMesh::add(const GlMesh &mesh, const Trans3d &trans, const Trans3d &rot)
 {
-  double e_rad = get_edge_rad();
-  double extra = 10 * e_rad / scen.get_width();
-  int long_div = int(11 * (1 + extra));
-  int lat_div = 1;
+  GLuint start = num_verts();
+  for (GLuint i = 0; i < 3 * mesh.num_verts(); i += 3) {
+    const GLfloat *pt = &mesh.coords[i];
+    const GLfloat *norm = &mesh.norms[i];
+    for (int r = 0; r < 3; r++) {
+      coords.push_back(trans[4 * r] * pt[0] + trans[4 * r + 1] * pt[1] +
+                       trans[4 * r + 2] * pt[2] + trans[4 * r + 3]);
+      norms.push_back(rot[4 * r] * norm[0] + rot[4 * r + 1] * norm[1] +
+                      rot[4 * r + 2] * norm[2]);
+    }
+  }
+  for (GLuint idx : mesh.tris)
+    tris.push_back(start + idx);
+}
 
-  GLUquadric *quad = gluNewQuadric();
-  GLuint cyl = glGenLists(1);
-  glNewList(cyl, GL_COMPILE);
-  gluCylinder(quad, e_rad, e_rad, 1, long_div, lat_div);
-  glEndList();
+void GlMesh::draw() const
+{
+  if (tris.empty())
+    return;
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, coords.data());
+  glNormalPointer(GL_FLOAT, 0, norms.data());
+  glDrawElements(GL_TRIANGLES, tris.size(), GL_UNSIGNED_INT, tris.data());
+  glPopClientAttrib();
+}
 
-  const vector<Vec3d> &verts = disp_geom.verts();
-  const vector<vector<int>> &edges = disp_geom.edges();
-  for (unsigned int i = 0; i < edges.size(); i++) {
-    Color col = disp_geom.colors(EDGES).get((int)i);
+// Unit sphere, as drawn by gluSphere
+static GlMesh sphere_mesh(int slices, int stacks)
+{
+  GlMesh mesh;
+  for (int i = 0; i <= stacks; i++)
+    for (int j = 0; j < slices; j++) {
+      double phi = M_PI * i / stacks;
+      double theta = 2 * M_PI * j / slices;
+      Vec3d pt(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi));
+      mesh.add_vert(pt, pt);
+    }
+  for (int i = 0; i < stacks; i++)
+    for (int j = 0; j < slices; j++) {
+      int j1 = (j + 1) % slices;
+      if (i < stacks - 1) // not at the bottom pole
+        mesh.add_tri(i * slices + j, (i + 1) * slices + j,
+                     (i + 1) * slices + j1);
+      if (i > 0) // not at the top pole
+        mesh.add_tri(i * slices + j, (i + 1) * slices + j1, i * slices + j1);
+    }
+  return mesh;
+}
+
+// Unit cylinder on the z-axis from 0 to 1, with open ends, as drawn by
+// gluCylinder
+static GlMesh cylinder_mesh(int slices)
+{
+  GlMesh mesh;
+  for (int i = 0; i < 2; i++)
+    for (int j = 0; j < slices; j++) {
+      double theta = 2 * M_PI * j / slices;
+      Vec3d norm(cos(theta), sin(theta), 0);
+      mesh.add_vert(norm + Vec3d(0, 0, i), norm);
+    }
+  for (int j = 0; j < slices; j++) {
+    int j1 = (j + 1) % slices;
+    mesh.add_tri(j, j1, slices + j1);
+    mesh.add_tri(j, slices + j1, slices + j);
+  }
+  return mesh;
+}
+
+map<Color, vector<int>> DisplayPoly_gl::elems_by_color(int type)
+{
+  map<Color, vector<int>> elems;
+  int num = (type == VERTS)   ? disp_geom.verts().size()
+            : (type == EDGES) ? disp_geom.edges().size()
+                              : disp_geom.faces().size();
+  for (int i = 0; i < num; i++) {
+    Color col = disp_geom.colors(type).get(i);
     if (col.is_index())
-      col = clrng(EDGES).get_col(col.get_index());
+      col = clrng(type).get_col(col.get_index());
     if (!col.is_value())
-      col = def_col(EDGES); // use default
+      col = def_col(type); // use default
     if (col.is_invisible())
       continue;
+    elems[col].push_back(i);
+  }
+  return elems;
+}
+
+// Approximate size in pixels of a length at the centre of the view
+static double pixel_size(const Scene &scen, double len)
+{
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  // the viewer is 1.57 times the camera distance away, with a 30 degree
+  // field of view (see gl_writer and reshape_cb)
+  double view_ht =
+      2 * tan(deg2rad(15)) * 1.57 * scen.cur_camera().get_distance();
+  return len * viewport[3] / view_ht;
+}
+
+// Below this radius in pixels vertex and edge elements are drawn with
+// fewer polygons
+static const double small_elem_pixels = 3;
 
-    gl_set_material(col, get_elem_trans(), GL_FRONT);
-    glPushMatrix();
-    edge_cyl_trans(verts[edges[i][0]], verts[edges[i][1]]);
-    glCallList(cyl);
-    glPopMatrix();
+void DisplayPoly_gl::gl_verts(const Scene &scen)
+{
+  double v_rad = get_vert_rad();
+  double extra = 10 * v_rad / scen.get_width();
+  int long_div = int(11 * (1 + extra));
+  int lat_div = int(7 * (1 + extra));
+  if (pixel_size(scen, v_rad) < small_elem_pixels) {
+    long_div = 6;
+    lat_div = 4;
   }
-  glDeleteLists(cyl, 1);
-  gluDeleteQuadric(quad);
+
+  GLuint list = gl_lists.get(VERTS);
+  if (!gl_lists.set_vals(VERTS, {v_rad, (double)long_div, (double)lat_div,
+                                 (double)get_elem_trans()})) {
+    const GlMesh sph = sphere_mesh(long_div, lat_div);
+    const vector<Vec3d> &verts = disp_geom.verts();
+    glNewList(list, GL_COMPILE);
+    for (const auto &kp : elems_by_color(VERTS)) {
+      GlMesh mesh;
+      for (int idx : kp.second)
+        mesh.add(sph, Trans3d::translate(verts[idx]) * Trans3d::scale(v_rad),
+                 Trans3d());
+      gl_set_material(kp.first, get_elem_trans(), GL_FRONT);
+      mesh.draw();
+    }
+    glEndList();
+  }
+  glCallList(list);
+}
+
+void DisplayPoly_gl::gl_edges(const Scene &scen)
+{
+  double e_rad = get_edge_rad();
+  double extra = 10 * e_rad / scen.get_width();
+  int long_div = int(11 * (1 + extra));
+  if (pixel_size(scen, e_rad) < small_elem_pixels)
+    long_div = 6;
+
+  GLuint list = gl_lists.get(EDGES);
+  if (!gl_lists.set_vals(EDGES, {e_rad, (double)long_div,
+                                 (double)get_elem_trans()})) {
+    const GlMesh cyl = cylinder_mesh(long_div);
+    const vector<Vec3d> &verts = disp_geom.verts();
+    const vector<vector<int>> &edges = disp_geom.edges();
+    glNewList(list, GL_COMPILE);
+    for (const auto &kp : elems_by_color(EDGES)) {
+      GlMesh mesh;
+      for (int idx : kp.second) {
+        const Vec3d &p1 = verts[edges[idx][0]];
+        Vec3d p1to2 = verts[edges[idx][1]] - p1;
+        Trans3d rot = Trans3d::rotate(Vec3d(0, 0, 1), p1to2);
+        mesh.add(cyl,
+                 Trans3d::translate(p1) * rot *
+                     Trans3d::scale(e_rad, e_rad, p1to2.len()),
+                 rot);
+      }
+      gl_set_material(kp.first, get_elem_trans(), GL_FRONT);
+      mesh.draw();
+    }
+    glEndList();
+  }
+  glCallList(list);
 }
 
 void DisplayPoly_gl::gl_faces(const Scene &)
 {
-  const vector<Vec3d> &verts = disp_geom.verts();
-  const vector<vector<int>> &faces = disp_geom.faces();
-  for (unsigned int i = 0; i < faces.size(); i++) {
-    if (faces[i].size() < 3)
-      continue;
-    Color col = disp_geom.colors(FACES).get((int)i);
-    if (col.is_index())
-      col = clrng(FACES).get_col(col.get_index());
-    if (!col.is_value())
-      col = def_col(FACES); // use default
-    if (col.is_invisible())
-      continue;
+  GLuint list = gl_lists.get(FACES);
+  if (!gl_lists.set_vals(FACES, {(double)show_orientation,
+                                 (double)transparency_type,
+                                 (double)get_elem_trans()})) {
+    const vector<Vec3d> &verts = disp_geom.verts();
+    const vector<vector<int>> &faces = disp_geom.faces();
+    glNewList(list, GL_COMPILE);
     if (show_orientation) {
       gl_set_material(Color(1.0, 1.0, 1.0), get_elem_trans(), GL_FRONT);
       gl_set_material(Color(0.0, 0.0, 0.0), get_elem_trans(), GL_BACK);
     }
-    else {
-      if (get_transparency_type() == trans_50pc)
-        col.set_rgba(col[0], col[1], col[2], 128);
-      else if (get_transparency_type() == trans_0pc)
-        col.set_rgba(col[0], col[1], col[2], 255);
-
-      gl_set_material(col, get_elem_trans());
+    for (const auto &kp : elems_by_color(FACES)) {
+      // triangles in a fan, as for a native polygon display
+      GlMesh mesh;
+      for (int idx : kp.second) {
+        const vector<int> &face = faces[idx];
+        if (face.size() < 3)
+          continue;
+        Vec3d norm = face_norm(verts, face);
+        GLuint start = mesh.num_verts();
+        for (int v_idx : face)
+          mesh.add_vert(verts[v_idx], norm);
+        for (GLuint j = 1; j < face.size() - 1; j++)
+          mesh.add_tri(start, start + j, start + j + 1);
+      }
+      if (!show_orientation) {
+        Color col = kp.first;
+        if (get_transparency_type() == trans_50pc)
+          col.set_rgba(col[0], col[1], col[2], 128);
+        else if (get_transparency_type() == trans_0pc)
+          col.set_rgba(col[0], col[1], col[2], 255);
+
+        gl_set_material(col, get_elem_trans());
+      }
+      mesh.draw();
     }
-
-    glBegin(GL_POLYGON);
-    Vec3d norm = face_norm(verts, faces[i]);
-    glNormal3dv(norm.get_v());
-    for (unsigned int j = 0; j < faces[i].size(); j++)
-      glVertex3dv(verts[faces[i][j]].get_v());
-    glEnd();
+    glEndList();
   }
+  glCallList(list);
 }
 
 DisplayPoly_gl::DisplayPoly_gl()
@@ -189,6 +362,22 @@ DisplayPoly_gl::DisplayPoly_gl()
 {
 }
 
+void DisplayPoly_gl::gl_lists_changed() { gl_lists.changed(); }
+
+void DisplayPoly_gl::geom_changed()
+{
+  DisplayPoly::geom_changed();
+  gl_lists_changed();
+}
+
+int DisplayPoly_gl::animate()
+{
+  int num_changes = DisplayPoly::animate();
+  if (num_changes)
+    gl_lists_changed();
+  return num_changes;
+}
+
 void DisplayPoly_gl::gl_geom(const Scene &scen)
 {
   if (elem(VERTS).get_show())
@@ -349,6 +538,12 @@ void DisplayNumLabels_gl::gl_geom(const Scene &scen)
     gl_edges(scen);
 }
 
+void DisplaySymmetry_gl::disp_changed()
+{
+  DisplaySymmetry::disp_changed();
+  gl_lists_changed();
+}
+
 void DisplaySymmetry_gl::gl_geom(const Scene &scen)
 {
   DisplayPoly_gl::gl_geom(scen);
@@ -29,25 +29,81 @@
 #ifndef DISP_POLY_GL_H
 #define DISP_POLY_GL_H
 
+#include <map>
+#include <vector>
+
 #include "../base/antiprism.h"
 
 using namespace anti;
 
+/// OpenGL display lists, deleted with the object
+/** Each list records the values it was compiled with. A copy has no lists,
+ *  so that each list is only deleted once. */
+class GlLists {
+private:
+  struct List {
+    unsigned int name;
+    std::vector<double> vals;
+  };
+  std::vector<List> lists;
+
+public:
+  GlLists() = default;
+  GlLists(const GlLists &) {}
+  GlLists &operator=(const GlLists &)
+  {
+    clear();
+    return *this;
+  }
+  ~GlLists() { clear(); }
+
+  /// Get a list, creating it if necessary
+  /**\param idx the index of the list.
+   * \return The list name. */
+  unsigned int get(unsigned int idx);
+
+  /// Set the values a list is compiled with
+  /**\param idx the index of the list.
+   * \param vals the values.
+   * \return \c true if the list was compiled with these values and
+   *  has not changed since, otherwise \c false. */
+  bool set_vals(unsigned int idx, const std::vector<double> &vals);
+
+  /// Mark all the lists as needing to be compiled
+  void changed();
+
+  /// Delete all the lists
+  void clear();
+};
+
 class DisplayPoly_gl : public virtual DisplayPoly {
 private:
   bool show_orientation;
   int transparency_type;
 
+  // Each element type is compiled into a display list when it is first
+  // drawn, and again when the display geometry, or one of the values the
+  // list was made with, changes. The list draws all the elements of a
+  // colour with a single call, with vertex and edge elements made from
+  // copies of a sphere or cylinder mesh
+  GlLists gl_lists;
+  std::map<Color, std::vector<int>> elems_by_color(int type);
+
 protected:
   void gl_verts(const Scene &scen);
   void gl_edges(const Scene &scen);
   void gl_faces(const Scene &scen);
 
+  /// Mark the display lists as needing to be compiled again
+  void gl_lists_changed();
+
 public:
   enum { trans_model = 0, trans_50pc, trans_0pc };
   DisplayPoly_gl();
 
   GeometryDisplay *clone() const { return new DisplayPoly_gl(*this); };
+  void geom_changed();
+  int animate();
   void gl_geom(const Scene &scen);
   void set_show_orientation(bool show = true) { show_orientation = show; }
   bool get_show_orientation() { return show_orientation; }
@@ -76,8 +132,12 @@ public:
 
 class DisplaySymmetry_gl : public virtual DisplaySymmetry,
                            public virtual DisplayPoly_gl {
+protected:
+  void disp_changed();
+
 public:
   GeometryDisplay *clone() const { return new DisplaySymmetry_gl(*this); }
+  void geom_changed() { DisplaySymmetry::geom_changed(); }
   void gl_geom(const Scene &scen);
 };
 
@@ -26,6 +26,7 @@
    \brief antiview - interface with GLUT
 */
 
+#include <chrono>
 #include <vector>
 
 #include "displaypoly_gl.h"
@@ -50,6 +51,7 @@ void glut_state::make_menu()
   glutAddMenuEntry("Transparency 'T'", 'T');
   glutAddMenuEntry("Sym Elems 'Y'", 'Y');
   glutAddMenuEntry("Orientation 'O'", 'O');
+  glutAddMenuEntry("Frame Time 'i'", 'i');
 
   glutCreateMenu(menu_cb);
   glutAddMenuEntry("Rotate  'r'", 'r');
@@ -107,6 +109,26 @@ void glut_state::change_transparency_disp()
   }
 }
 
+void glut_state::toggle_frame_time()
+{
+  show_frame_time = !show_frame_time;
+  frame_msecs = 0;
+  if (!show_frame_time)
+    glutSetWindowTitle("Antiview");
+}
+
+void glut_state::add_frame_time(double msecs)
+{
+  // average over recent frames, so the value can be read while rotating
+  frame_msecs = (frame_msecs) ? 0.9 * frame_msecs + 0.1 * msecs : msecs;
+  if (show_frame_time) {
+    char title[64];
+    snprintf(title, sizeof(title), "Antiview - %.1f ms per frame",
+             frame_msecs);
+    glutSetWindowTitle(title);
+  }
+}
+
 static void toggle(char elem)
 {
   vector<SceneGeometry>::const_iterator geo;
@@ -220,6 +242,10 @@ void keyboard_cb(unsigned char key, int /*x*/, int /*y*/)
   case 'O':
     toggle('O');
     break;
+  case 'I':
+  case 'i':
+    glut_s.toggle_frame_time();
+    break;
   case 'V':
   case 'v':
     toggle('v');
@@ -391,8 +417,16 @@ void mouse_cb(int button, int state, int x, int y)
 
 void display_cb()
 {
+  ProfileScope prof("frame");
+  auto start = std::chrono::steady_clock::now();
   glut_s.write();
   glutSwapBuffers();
+  if (glut_s.get_show_frame_time() || profiling_enabled()) {
+    glFinish(); // include the drawing in the time
+    std::chrono::duration<double, std::milli> msecs =
+        std::chrono::steady_clock::now() - start;
+    glut_s.add_frame_time(msecs.count());
+  }
 }
 
 void reshape_cb(int w, int h)
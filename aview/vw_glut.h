@@ -90,6 +90,8 @@ class glut_state {
 private:
   int cur_op;
   double fps; // frames per second
+  bool show_frame_time;
+  double frame_msecs; // average time to draw a frame
   Camera saved_camera;
   gl_writer gl_wrtr;
 
@@ -108,9 +110,10 @@ public:
   Scene scen;
 
   glut_state()
-      : cur_op(tr_rot), fps(50), start_x(0), start_y(0), l_button(GLUT_UP),
-        trans_scale(0.005), slice_scale(0.003), persp_proj(true),
-        sym_disp_type(0), transparency_disp_type(0)
+      : cur_op(tr_rot), fps(50), show_frame_time(false), frame_msecs(0),
+        start_x(0), start_y(0), l_button(GLUT_UP), trans_scale(0.005),
+        slice_scale(0.003), persp_proj(true), sym_disp_type(0),
+        transparency_disp_type(0)
   {
   }
   void make_menu();
@@ -126,6 +129,9 @@ public:
   void restore_camera() { scen.cur_camera() = saved_camera; }
   void change_sym_disp();
   void change_transparency_disp();
+  void toggle_frame_time();
+  bool get_show_frame_time() { return show_frame_time; }
+  void add_frame_time(double msecs);
 };
 
 #endif // VW_GLUT_H
@@ -32,7 +32,8 @@
  * The Antiprism library provides a framework for working
  * with polyhedra. It includes:
  * - import of OFF, LG3D and simple text coordinate files
- * - export of OFF, VRML, POV, LG3D and text coordinate files
+ * - export of OFF, VRML, POV, LG3D and text coordinate files, and PNG
+ *   and PPM images
  * - vector and matrix operations
  * - geometric utilities
  * - analysis of polyhedra
@@ -46,6 +47,7 @@
 #ifndef ANTIPRISM_H
 #define ANTIPRISM_H
 
+#include "archive.h"
 #include "boundbox.h"
 #include "color.h"
 #include "coloring.h"
@@ -57,12 +59,16 @@
 #include "geometryinfo.h"
 #include "geometryutils.h"
 #include "getopt.h"
+#include "kdtree.h"
 #include "mathutils.h"
 #include "normal.h"
+#include "parallel.h"
 #include "planar.h"
 #include "polygon.h"
 #include "povwriter.h"
+#include "profile.h"
 #include "random.h"
+#include "rasterwriter.h"
 #include "scene.h"
 #include "status.h"
 #include "symmetry.h"
@@ -0,0 +1,468 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/* \file archive.cc
+   \brief Archive files holding several named models
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define ARCHIVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "archive.h"
+#include "private_off_file.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+namespace anti {
+
+// The first line of an archive
+static const char *archive_header = "# antiprism archive 1\n";
+
+// The last line of an archive has a fixed length, and holds the position
+// of the index
+static const char *index_offset_fmt = "# index_offset %020ld\n";
+static const int index_offset_len = 36;
+
+ArchiveWriter::~ArchiveWriter()
+{
+  if (file)
+    close();
+}
+
+#ifndef HAVE_FTRUNCATE
+// Copy the first len bytes of a file to another file
+static bool copy_file_start(FILE *from, FILE *to, long len)
+{
+  char buf[BUFSIZ];
+  while (len > 0) {
+    size_t num = fread(buf, 1, std::min((long)sizeof(buf), len), from);
+    if (num == 0 || fwrite(buf, 1, num, to) != num)
+      return false;
+    len -= num;
+  }
+  return true;
+}
+#endif
+
+Status ArchiveWriter::open(const string &fname, bool append)
+{
+  if (file)
+    close();
+
+  index.clear();
+  tmp_name.clear();
+  file_name = fname;
+  if (file_name == "" || file_name == "-") {
+    file = stdout;
+    file_name = "";
+  }
+  else if (append && Archive::is_archive(file_name)) {
+    // continue from the start of the existing index, which is rewritten
+    // when the archive is closed
+    Archive arc;
+    Status stat = arc.open(file_name);
+    if (stat.is_error())
+      return stat;
+    index = arc.get_index();
+    pos = (index.size()) ? index.back().offset + index.back().size
+                         : (long)strlen(archive_header);
+    arc.close();
+#ifdef HAVE_FTRUNCATE
+    if (!(file = fopen(file_name.c_str(), "r+b")))
+      return Status::error(
+          msg_str("could not open archive '%s' for appending",
+                  file_name.c_str()));
+    fflush(file);
+    if (fseek(file, pos, SEEK_SET) != 0 ||
+        ftruncate(fileno(file), pos) != 0) {
+      fclose(file);
+      file = nullptr;
+      return Status::error(msg_str("could not truncate archive '%s' index",
+                                   file_name.c_str()));
+    }
+#else
+    // the old index cannot be cut off, so the models are copied to a new
+    // file, which replaces the archive when it is closed
+    tmp_name = file_name + ".tmp";
+    FILE *ifile = fopen(file_name.c_str(), "rb");
+    file = (ifile) ? fopen(tmp_name.c_str(), "wb") : nullptr;
+    bool copied = file && copy_file_start(ifile, file, pos);
+    if (ifile)
+      fclose(ifile);
+    if (!copied) {
+      if (file) {
+        fclose(file);
+        file = nullptr;
+        remove(tmp_name.c_str());
+      }
+      return Status::error(
+          msg_str("could not open archive '%s' for appending",
+                  file_name.c_str()));
+    }
+#endif
+    return Status::ok();
+  }
+  else if (!(file = fopen(file_name.c_str(), "wb")))
+    return Status::error(
+        msg_str("could not open output file '%s'", file_name.c_str()));
+
+  fputs(archive_header, file);
+  pos = strlen(archive_header);
+  return Status::ok();
+}
+
+// Write a model, and return the number of bytes written. If the file
+// cannot report its position (e.g. a pipe) the model is staged in a
+// temporary file to find its length.
+static long write_model(FILE *file, long pos, const Geometry &geom,
+                        int sig_dgts)
+{
+  if (ftell(file) == pos) {
+    off_file_write(file, geom, sig_dgts);
+    return ftell(file) - pos;
+  }
+
+  FILE *tmp = tmpfile();
+  if (!tmp)
+    return -1;
+  off_file_write(tmp, geom, sig_dgts);
+  long size = ftell(tmp);
+  rewind(tmp);
+  char buf[BUFSIZ];
+  size_t num_read;
+  while ((num_read = fread(buf, 1, sizeof(buf), tmp)))
+    fwrite(buf, 1, num_read, file);
+  fclose(tmp);
+  return size;
+}
+
+Status ArchiveWriter::add(const string &name, const Geometry &geom,
+                          int sig_dgts)
+{
+  if (!file)
+    return Status::error("archive is not open for writing");
+  if (name.find('\n') != string::npos)
+    return Status::error(
+        msg_str("model name '%s' includes a newline", name.c_str()));
+
+  string name_line = "# model " + name + "\n";
+  fputs(name_line.c_str(), file);
+  pos += name_line.size();
+
+  long size = write_model(file, pos, geom, sig_dgts);
+  if (size < 0)
+    return Status::error(
+        msg_str("could not write model '%s' to archive", name.c_str()));
+
+  index.push_back({name, pos, size});
+  pos += size;
+  return Status::ok();
+}
+
+Status ArchiveWriter::close()
+{
+  if (!file)
+    return Status::error("archive is not open for writing");
+
+  long index_pos = pos;
+  fprintf(file, "# index %lu\n", (unsigned long)index.size());
+  for (const auto &entry : index)
+    fprintf(file, "# %ld %ld %s\n", entry.offset, entry.size,
+            entry.name.c_str());
+  // fixed length, so it can be read from the end of the file
+  fprintf(file, index_offset_fmt, index_pos);
+
+  bool write_err = ferror(file);
+  if (file != stdout)
+    write_err = (fclose(file) != 0) || write_err;
+  else
+    write_err = (fflush(file) != 0) || write_err;
+  file = nullptr;
+
+  Status stat;
+  if (tmp_name != "") {
+    // replace the archive with the appended copy, removing the archive
+    // first if rename() does not replace an existing file
+    if (write_err)
+      remove(tmp_name.c_str());
+    else if (rename(tmp_name.c_str(), file_name.c_str()) != 0 &&
+             (remove(file_name.c_str()) != 0 ||
+              rename(tmp_name.c_str(), file_name.c_str()) != 0))
+      write_err = true; // the appended archive is left in tmp_name
+    tmp_name.clear();
+  }
+  if (write_err)
+    stat.set_error(msg_str("error writing archive '%s'",
+                           (file_name != "") ? file_name.c_str() : "stdout"));
+  return stat;
+}
+
+void Archive::close()
+{
+  if (data) {
+#ifdef ARCHIVE_MMAP
+    if (mapped)
+      munmap(data, data_size);
+    else
+#endif
+      free(data);
+  }
+  data = nullptr;
+  data_size = 0;
+  mapped = false;
+  index.clear();
+  name_idxs.clear();
+  file_name.clear();
+}
+
+Status Archive::open(const string &fname)
+{
+  close();
+  file_name = fname;
+
+#ifdef ARCHIVE_MMAP
+  int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        data = (char *)addr;
+        data_size = st.st_size;
+        mapped = true;
+      }
+    }
+    ::close(fd);
+  }
+#endif
+
+  if (!data) { // read the whole file into memory
+    FILE *file = fopen(file_name.c_str(), "rb");
+    if (!file)
+      return Status::error(
+          msg_str("could not open archive '%s'", file_name.c_str()));
+    if (fseek(file, 0, SEEK_END) == 0 && (data_size = ftell(file)) > 0) {
+      rewind(file);
+      data = (char *)malloc(data_size);
+      if (data && fread(data, 1, data_size, file) != (size_t)data_size) {
+        free(data);
+        data = nullptr;
+      }
+    }
+    fclose(file);
+    if (!data) {
+      data_size = 0;
+      return Status::error(
+          msg_str("could not read archive '%s'", file_name.c_str()));
+    }
+  }
+
+  Status stat = read_index();
+  if (stat.is_error()) {
+    string arc_name = file_name;
+    close();
+    return Status::error(
+        msg_str("archive '%s': %s", arc_name.c_str(), stat.c_msg()));
+  }
+
+  return Status::ok();
+}
+
+Status Archive::read_index()
+{
+  long header_len = strlen(archive_header);
+  if (data_size < header_len + index_offset_len ||
+      strncmp(data, archive_header, header_len) != 0)
+    return Status::error("not an archive file");
+
+  // the index position, from the fixed length last line
+  string last_line(data + data_size - index_offset_len, index_offset_len);
+  long index_pos;
+  if (sscanf(last_line.c_str(), "# index_offset %ld", &index_pos) != 1 ||
+      index_pos < header_len || index_pos > data_size - index_offset_len)
+    return Status::error("index position not found");
+
+  // the data is not null terminated, so lines are copied before parsing
+  const char *p = data + index_pos;
+  const char *end = data + data_size - index_offset_len;
+  const char *eol = (const char *)memchr(p, '\n', end - p);
+  unsigned long num_models;
+  if (!eol ||
+      sscanf(string(p, eol - p).c_str(), "# index %lu", &num_models) != 1)
+    return Status::error("index not found");
+  p = eol + 1;
+
+  // an entry line has at least "# 0 0 \n", so the reserved size is not
+  // larger than the index could hold
+  index.reserve(std::min(num_models, (unsigned long)(end - p) / 7));
+  while (p < end) {
+    eol = (const char *)memchr(p, '\n', end - p);
+    if (!eol)
+      break;
+    string line(p, eol - p);
+    ArchiveEntry entry;
+    int name_pos = 0;
+    if (sscanf(line.c_str(), "# %ld %ld %n", &entry.offset, &entry.size,
+               &name_pos) < 2 ||
+        !name_pos)
+      return Status::error(msg_str("index entry %lu: invalid entry",
+                                   (unsigned long)index.size()));
+    if (entry.offset < header_len || entry.size < 0 ||
+        entry.offset + entry.size > index_pos)
+      return Status::error(
+          msg_str("index entry %lu: model data is outside of the archive",
+                  (unsigned long)index.size()));
+    entry.name = line.substr(name_pos);
+    name_idxs[entry.name] = index.size();
+    index.push_back(entry);
+    p = eol + 1;
+  }
+
+  if (p != end || index.size() != num_models)
+    return Status::error(
+        msg_str("index has %lu entries, expected %lu",
+                (unsigned long)index.size(), num_models));
+
+  return Status::ok();
+}
+
+int Archive::find(const string &name) const
+{
+  auto mi = name_idxs.find(name);
+  return (mi != name_idxs.end()) ? mi->second : -1;
+}
+
+Status Archive::read(int idx, Geometry &geom) const
+{
+  geom.clear_all();
+  if (idx < 0 || idx >= size())
+    return Status::error(
+        msg_str("archive '%s': model index %d is out of range (there are %d "
+                "models)",
+                file_name.c_str(), idx, size()));
+
+  const ArchiveEntry &entry = index[idx];
+#ifdef HAVE_FMEMOPEN
+  FILE *file = fmemopen(data + entry.offset, entry.size, "r");
+#else
+  FILE *file = tmpfile();
+  if (file) {
+    fwrite(data + entry.offset, 1, entry.size, file);
+    rewind(file);
+  }
+#endif
+  if (!file)
+    return Status::error(msg_str("archive '%s': model '%s': could not read",
+                                 file_name.c_str(), entry.name.c_str()));
+
+  Status stat = geom.read(file);
+  fclose(file);
+  string msg = msg_str("archive '%s': model '%s': %s", file_name.c_str(),
+                       entry.name.c_str(), stat.c_msg());
+  if (stat.is_error())
+    stat.set_error(msg);
+  else if (stat.is_warning())
+    stat.set_warning(msg);
+  return stat;
+}
+
+Status Archive::read(const string &name, Geometry &geom) const
+{
+  int idx = find(name);
+  if (idx < 0) {
+    geom.clear_all();
+    return Status::error(msg_str("archive '%s': model '%s' not found",
+                                 file_name.c_str(), name.c_str()));
+  }
+  return read(idx, geom);
+}
+
+bool Archive::is_archive(const string &fname)
+{
+  FILE *file = fopen(fname.c_str(), "rb");
+  if (!file)
+    return false;
+  size_t header_len = strlen(archive_header);
+  char buf[64];
+  bool is_arc = fread(buf, 1, header_len, file) == header_len &&
+                strncmp(buf, archive_header, header_len) == 0;
+  fclose(file);
+  return is_arc;
+}
+
+static bool file_exists(const string &fname)
+{
+  FILE *file = fopen(fname.c_str(), "rb");
+  if (file)
+    fclose(file);
+  return file != nullptr;
+}
+
+bool split_archive_ref(const string &ref, string &arc_name,
+                       string &model_name, bool for_writing)
+{
+  size_t pos = ref.rfind('#');
+  if (pos == string::npos || pos == 0 || pos == ref.size() - 1)
+    return false;
+
+  string name = ref.substr(0, pos);
+  if (for_writing) {
+    size_t ext_len = 5; // ".offa"
+    if (!Archive::is_archive(name) &&
+        (file_exists(name) || name.size() <= ext_len ||
+         name.compare(name.size() - ext_len, ext_len, ".offa") != 0))
+      return false;
+  }
+  else if (file_exists(ref) || !file_exists(name))
+    return false;
+
+  arc_name = name;
+  model_name = ref.substr(pos + 1);
+  return true;
+}
+
+} // namespace anti
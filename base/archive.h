@@ -0,0 +1,193 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+
+/**\file archive.h
+   \brief Archive files holding several named models
+*/
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdio.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "geometry.h"
+#include "status.h"
+
+namespace anti {
+
+/// An entry in the index of an archive
+struct ArchiveEntry {
+  std::string name; ///< the name of the model
+  long offset;      ///< the position of the model OFF data in the file
+  long size;        ///< the length of the model OFF data in bytes
+};
+
+/// Write models to an archive file
+/** An archive is a text file. Each model is written in OFF format,
+ *  preceded by a comment line holding its name. The models are followed
+ *  by an index of comment lines, giving the position, length and name of
+ *  each model, and a final fixed length line holding the position of the
+ *  index. */
+class ArchiveWriter {
+private:
+  FILE *file;
+  std::string file_name;
+  long pos; // number of bytes written
+  std::vector<ArchiveEntry> index;
+  std::string tmp_name; // file written when appending, renamed on close
+
+public:
+  /// Constructor
+  ArchiveWriter() : file(nullptr), pos(0) {}
+
+  /// Destructor, closes the archive if it is open
+  ~ArchiveWriter();
+
+  /// Open an archive file for writing
+  /**\param fname the name of the file, or "" or "-" for standard output.
+   * \param append if \c true and the file is an existing archive then
+   *  new models are added after the models already in the archive.
+   * \return status, evaluates to \c true if the file was opened,
+   *  otherwise \c false. */
+  Status open(const std::string &fname, bool append = false);
+
+  /// Add a model to the archive
+  /**\param name the name of the model, which cannot include a newline.
+   * \param geom the model.
+   * \param sig_dgts the number of significant digits to write.
+   * \return status, evaluates to \c true if the model was added,
+   *  otherwise \c false. */
+  Status add(const std::string &name, const Geometry &geom,
+             int sig_dgts = DEF_SIG_DGTS);
+
+  /// Write the index and close the archive
+  /**\return status, evaluates to \c true if the archive was completed,
+   *  otherwise \c false. */
+  Status close();
+
+  /// Get the index of the models written so far
+  /**\return The index entries, in the order the models were added. */
+  const std::vector<ArchiveEntry> &get_index() const { return index; }
+};
+
+/// Read models from an archive file
+/** The file is memory mapped, where this is supported, and only the index
+ *  and the models that are read are accessed. Models may be read
+ *  concurrently from several threads. If several models have the same
+ *  name then the name refers to the last of these models. */
+class Archive {
+private:
+  std::string file_name;
+  char *data;     // the file contents
+  long data_size; // the file length
+  bool mapped;    // data is memory mapped, rather than allocated
+  std::vector<ArchiveEntry> index;
+  std::unordered_map<std::string, int> name_idxs;
+
+  Status read_index();
+
+public:
+  /// Constructor
+  Archive() : data(nullptr), data_size(0), mapped(false) {}
+
+  /// Destructor, closes the archive if it is open
+  ~Archive() { close(); }
+
+  Archive(const Archive &) = delete;
+  Archive &operator=(const Archive &) = delete;
+
+  /// Open an archive file for reading
+  /**\param fname the name of the file.
+   * \return status, evaluates to \c true if the file was opened and it
+   *  has a valid index, otherwise \c false. */
+  Status open(const std::string &fname);
+
+  /// Close the archive
+  void close();
+
+  /// Get the number of models
+  /**\return The number of models in the archive. */
+  int size() const { return index.size(); }
+
+  /// Get the index of the models
+  /**\return The index entries, in the order the models were added. */
+  const std::vector<ArchiveEntry> &get_index() const { return index; }
+
+  /// Find a model by name
+  /**\param name the name of the model.
+   * \return The index number of the model, or \c -1 if there is no model
+   *  with this name. */
+  int find(const std::string &name) const;
+
+  /// Get the OFF data of a model
+  /**\param idx the index number of the model.
+   * \return The OFF data, which is not null terminated, and has the length
+   *  given in the index entry. */
+  const char *get_off_data(int idx) const { return data + index[idx].offset; }
+
+  /// Read a model
+  /**\param idx the index number of the model.
+   * \param geom used to return the model.
+   * \return status, evaluates to \c true if the model was read,
+   *  otherwise \c false. */
+  Status read(int idx, Geometry &geom) const;
+
+  /// Read a model
+  /**\param name the name of the model.
+   * \param geom used to return the model.
+   * \return status, evaluates to \c true if the model was read,
+   *  otherwise \c false. */
+  Status read(const std::string &name, Geometry &geom) const;
+
+  /// Check whether a file is an archive
+  /**\param fname the name of the file.
+   * \return \c true if the file starts with an archive header,
+   *  otherwise \c false. */
+  static bool is_archive(const std::string &fname);
+};
+
+/// Split a reference to a model in an archive
+/** A reference has the form \c archive#name, and is split at the last
+ *  \c #. For reading, the archive file must exist, and there must not
+ *  be a file with the whole reference as its name. For writing, the
+ *  archive file must be an existing archive or have the extension
+ *  \c .offa
+ * \param ref the reference.
+ * \param arc_name used to return the archive file name.
+ * \param model_name used to return the model name.
+ * \param for_writing whether the model will be written.
+ * \return \c true if \a ref is a reference to a model in an archive,
+ *  otherwise \c false. */
+bool split_archive_ref(const std::string &ref, std::string &arc_name,
+                       std::string &model_name, bool for_writing = false);
+
+} // namespace anti
+
+#endif // ARCHIVE_H
@@ -38,13 +38,13 @@
 #include "boundbox.h"
 #include "geometry.h"
 #include "geometryutils.h"
+#include "kdtree.h"
 #include "mathutils.h"
+#include "profile.h"
 #include "utils.h"
 
 #include "qhull/qhull_ra.h"
 
-#define NUM_TO_USE_DELAUNAY 20
-
 using std::map;
 using std::pair;
 using std::string;
@@ -62,6 +62,7 @@ static void qhull_cleanup(qhT *qh)
 
 static bool make_hull(Geometry &geom, bool append, string qh_args, char *errmsg)
 {
+  ProfileScope prof("make_hull");
   vector<Vec3d> verts = geom.verts();
   Vec3d cent = geom.centroid();
 
@@ -433,35 +434,10 @@ Status get_delaunay_edges(const vector<Vec3d> &verts,
 
 double get_min_vert_to_vert_dist(const vector<Vec3d> &verts, double sig_dist)
 {
-  double sig_dist2 = sig_dist * sig_dist;
-  double min_sig_dist = 1e100;
-  double mag2;
-
   if (!verts.size())
-    min_sig_dist = 0;
-  else if (verts.size() < NUM_TO_USE_DELAUNAY) {
-    Vec3d dvec;
-    for (unsigned int i = 0; i < verts.size() - 1; i++)
-      for (unsigned int j = i + 1; j < verts.size(); j++) {
-        mag2 = (verts[j] - verts[i]).len2();
-        if (mag2 >= sig_dist2 && mag2 < min_sig_dist)
-          min_sig_dist = mag2;
-      }
-  }
-  else {
-    map<pair<int, int>, int> edges;
-    if (!get_delaunay_edges(verts, edges, ""))
-      return -1; // error
-
-    map<pair<int, int>, int>::iterator mi;
-    for (mi = edges.begin(); mi != edges.end(); ++mi) {
-      mag2 = (verts[mi->first.second] - verts[mi->first.first]).len2();
-      if (mag2 >= sig_dist2 && mag2 < min_sig_dist)
-        min_sig_dist = mag2;
-    }
-  }
-
-  return (min_sig_dist < 1e99) ? sqrt(min_sig_dist) : sig_dist;
+    return 0;
+  double min_dist = KDTree(verts).min_pair_dist(sig_dist);
+  return (min_dist >= 0) ? min_dist : sig_dist;
 }
 
 Status get_voronoi_cells(const vector<Vec3d> &verts, vector<Geometry> *cells,
@@ -42,6 +42,7 @@
 #include "geometry.h"
 #include "geometryinfo.h"
 #include "planar.h"
+#include "profile.h"
 
 using std::map;
 using std::string;
@@ -123,6 +124,7 @@ bool canonicalize_mm(Geometry &geom, const double edge_factor,
                      const bool alternate_loop, const bool planar_only,
                      const char normal_type, const double eps)
 {
+  ProfileScope prof("canonicalize_mm");
   bool completed = false;
 
   vector<Vec3d> &verts = geom.raw_verts();
@@ -534,6 +536,7 @@ bool canonicalize_bd(Geometry &base, const int num_iters,
                      const char centering, const char normal_type,
                      const double eps)
 {
+  ProfileScope prof("canonicalize_bd");
   bool completed = false;
 
   Geometry dual;
@@ -49,7 +49,11 @@ using std::vector;
 
 namespace anti {
 
-Coloring::Coloring(Geometry *geo) : geom(geo), cycle_msecs(0) {}
+Coloring::Coloring(Geometry *geo)
+    : geom(geo), cycle_msecs(0), proper_seed(0), proper_iters(100000),
+      proper_secs(0), proper_num_cols(0), proper_lower_bound(0)
+{
+}
 
 Coloring::~Coloring() = default;
 
@@ -61,11 +65,28 @@ Coloring &Coloring::operator=(const Coloring &clrng)
     ColorMapMulti::operator=(clrng);
     geom = clrng.geom;
     cycle_msecs = clrng.cycle_msecs;
+    proper_seed = clrng.proper_seed;
+    proper_iters = clrng.proper_iters;
+    proper_secs = clrng.proper_secs;
+    proper_num_cols = clrng.proper_num_cols;
+    proper_lower_bound = clrng.proper_lower_bound;
   }
 
   return *this;
 }
 
+// Find a proper colouring with the settings, and record the result
+static void find_proper_colors(ProperColor &prop, unsigned int seed,
+                               long iters, double secs, int &num_cols,
+                               int &lower_bound)
+{
+  prop.set_seed(seed);
+  prop.set_max_iters(iters);
+  prop.set_max_secs(secs);
+  num_cols = prop.find_colors();
+  lower_bound = prop.get_lower_bound();
+}
+
 void Coloring::cycle_map_cols() { set_shift(get_shift() + 1); }
 
 void Coloring::set_all_idx_to_val(map<int, Color> &cols)
@@ -184,7 +205,8 @@ void Coloring::v_proper(bool apply_map)
     for (unsigned int j = 0; j < get_geom()->faces(i).size(); ++j)
       prop.set_adj(get_geom()->faces(i, j), get_geom()->faces_mod(i, j + 1));
 
-  prop.find_colors();
+  find_proper_colors(prop, proper_seed, proper_iters, proper_secs,
+                     proper_num_cols, proper_lower_bound);
   for (unsigned int i = 0; i < get_geom()->verts().size(); i++)
     if (apply_map)
       get_geom()->colors(VERTS).set(i, get_col(prop.get_color(i)));
@@ -326,7 +348,8 @@ void Coloring::f_proper(bool apply_map)
         prop.set_adj(f_idxs[i], f_idxs[j]);
   }
 
-  prop.find_colors();
+  find_proper_colors(prop, proper_seed, proper_iters, proper_secs,
+                     proper_num_cols, proper_lower_bound);
   for (unsigned int i = 0; i < get_geom()->faces().size(); i++)
     if (apply_map)
       get_geom()->colors(FACES).set(i, get_col(prop.get_color(i)));
@@ -468,12 +491,20 @@ void Coloring::e_proper(bool apply_map)
     }
   }
 
-  prop.find_colors();
+  find_proper_colors(prop, proper_seed, proper_iters, proper_secs,
+                     proper_num_cols, proper_lower_bound);
+  // look up existing edges once, rather than searching for each edge
+  map<vector<int>, int> edge_idxs;
+  for (unsigned int i = 0; i < get_geom()->edges().size(); i++)
+    edge_idxs.emplace(get_geom()->edges(i), i);
   for (mi = edges.begin(); mi != edges.end(); ++mi) {
-    int e_idx = edges[mi->first][0];
-    int col_idx = prop.get_color(e_idx);
+    int col_idx = prop.get_color(mi->second[0]);
     Color col = (apply_map) ? get_col(col_idx) : Color(col_idx);
-    get_geom()->add_edge(mi->first[0], mi->first[1], col);
+    auto ei = edge_idxs.find(mi->first);
+    if (ei != edge_idxs.end())
+      get_geom()->colors(EDGES).set(ei->second, col);
+    else
+      get_geom()->add_edge_raw(mi->first, col);
   }
 }
 
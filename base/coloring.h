@@ -44,6 +44,13 @@ private:
 
   unsigned int cycle_msecs;
 
+  // Proper colouring settings and the result of the last one
+  unsigned int proper_seed;
+  long proper_iters;
+  double proper_secs;
+  int proper_num_cols;
+  int proper_lower_bound;
+
   void face_edge_color(const std::vector<std::vector<int>> &elems,
                        const ElemProps<Color> &cols);
 
@@ -119,6 +126,33 @@ public:
    * \return The number of milliseconds between colour map cycles. */
   unsigned int get_cycle_msecs() const { return cycle_msecs; }
 
+  /// Set the options for proper colourings
+  /** After a colouring is found, searches try to use fewer colours.
+   * \param seed the seed for the random choices of the searches, the same
+   *  seed gives the same colouring.
+   * \param iters the maximum number of steps of each search for a
+   *  colouring with fewer colours, \c 0 to not search.
+   * \param secs a time limit for the searches in seconds, or \c 0 for no
+   *  limit. A time limit makes the colouring depend on the speed of the
+   *  machine. */
+  void set_proper_opts(unsigned int seed, long iters = 100000,
+                       double secs = 0)
+  {
+    proper_seed = seed;
+    proper_iters = iters;
+    proper_secs = secs;
+  }
+
+  /// Get the number of colours used by the last proper colouring
+  /**\return The number of colours. */
+  int get_proper_num_cols() const { return proper_num_cols; }
+
+  /// Get a lower bound for the colours of the last proper colouring
+  /**\return The size of the largest clique of elements found, which all
+   *  need different colours. If the number of colours is the same then it
+   *  is the minimum. */
+  int get_proper_lower_bound() const { return proper_lower_bound; }
+
   /// Colour vertices with a single colour
   /**\param col colour for the vertices. */
   void v_one_col(Color col);
@@ -762,10 +762,11 @@ static bool parse_gimp_file(FILE *cfile, map<int, Color> *cmap,
     }
 
     // stage == 3
-    char *r = strtok(line, WHITESPACE);
-    char *g = (r) ? strtok(nullptr, WHITESPACE) : nullptr;
-    char *b = (g) ? strtok(nullptr, WHITESPACE) : nullptr;
-    // char *name = (b) ? strtok(NULL, WHITESPACE) : 0;
+    char *tok_ptr; // memory pointer for strtok_r
+    char *r = strtok_r(line, WHITESPACE, &tok_ptr);
+    char *g = (r) ? strtok_r(nullptr, WHITESPACE, &tok_ptr) : nullptr;
+    char *b = (g) ? strtok_r(nullptr, WHITESPACE, &tok_ptr) : nullptr;
+    // char *name = (b) ? strtok_r(NULL, WHITESPACE, &tok_ptr) : 0;
 
     if (!b) {
       if (errmsg)
@@ -27,6 +27,7 @@
    with element number labels
 */
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <string.h>
@@ -50,7 +51,7 @@ namespace anti {
 
 DisplayPoly::DisplayPoly()
     : triangulate(true), winding_rule(TESS_WINDING_NONZERO), face_alpha(-1),
-      use_lines(false)
+      use_lines(false), vrml_compact(false), pov_mesh(false)
 {
 }
 
@@ -133,6 +134,46 @@ int DisplayPoly::animate()
   return num_changes;
 }
 
+namespace {
+
+// Text written to a file in large blocks, rather than with an fprintf
+// call for each element
+class TextBuffer {
+private:
+  FILE *ofile;
+  string buf;
+  static const size_t block_sz = 1 << 16;
+
+public:
+  TextBuffer(FILE *file) : ofile(file) { buf.reserve(block_sz + MSG_SZ); }
+  ~TextBuffer() { flush(); }
+
+  void flush()
+  {
+    fwrite(buf.data(), 1, buf.size(), ofile);
+    buf.clear();
+  }
+
+  TextBuffer &operator<<(const char *str)
+  {
+    buf += str;
+    if (buf.size() > block_sz)
+      flush();
+    return *this;
+  }
+
+  TextBuffer &operator<<(const string &str) { return *this << str.c_str(); }
+
+  TextBuffer &operator<<(long num)
+  {
+    char num_str[32];
+    snprintf(num_str, sizeof(num_str), "%ld", num);
+    return *this << num_str;
+  }
+};
+
+} // namespace
+
 // --------------------------------------------------------------
 // DisplayPoly - vrml
 
@@ -463,6 +504,209 @@ void DisplayPoly::vrml_faces(FILE *ofile)
   fprintf(ofile, "\n\n\n");
 }
 
+// Visible element colours, with unset colours replaced by the default
+// colour, so that the elements can be grouped by colour
+static vector<Color> vrml_elem_cols(DisplayPoly &disp, int type, int num)
+{
+  const Coloring &clrng = disp.get_clrngs()[type];
+  vector<Color> cols(num);
+  for (int i = 0; i < num; i++) {
+    Color col = disp.get_disp_geom().colors(type).get(i);
+    if (col.is_index())
+      col = clrng.get_col(col.get_index());
+    if (!col.is_set())
+      col = disp.def_col(type);
+    cols[i] = col;
+  }
+  return cols;
+}
+
+// Colours with fewer elements than this use the general element prototype,
+// with the colour given in each element
+static const size_t min_proto_elems = 8;
+
+// Colour fields of the general element prototypes
+static string vrml_col_fields(const Color &col)
+{
+  char trn[32];
+  snprintf(trn, sizeof(trn), "%.4f", col.get_transparency_d());
+  return "clr " + vrml_col(col) + " trn " + trn;
+}
+
+// Prototype for the elements of one colour, which only need the fields
+// that position them
+static string vrml_elem_proto(const string &name, const string &fields,
+                              const string &trans, const Color &col,
+                              const string &geom)
+{
+  char trn[32];
+  snprintf(trn, sizeof(trn), "%.4f", col.get_transparency_d());
+  return "PROTO " + name + " [\n" + fields + "]\n" +
+         "{\n"
+         "   Transform {\n" +
+         trans +
+         "      children [\n"
+         "         Shape {\n"
+         "            appearance Appearance {\n"
+         "               material Material {\n"
+         "                  diffuseColor " +
+         vrml_col(col) + "\n                  transparency " + trn +
+         "\n"
+         "               }\n"
+         "            }\n"
+         "            geometry " +
+         geom +
+         "\n"
+         "         }\n"
+         "      ]\n"
+         "   }\n"
+         "}\n";
+}
+
+void DisplayPoly::vrml_verts_inst(FILE *ofile, int sig_digits)
+{
+  fprintf(ofile, "# Vertex elements\n");
+
+  const vector<Vec3d> &vs = disp_geom.verts();
+  vector<Color> cols = vrml_elem_cols(*this, VERTS, vs.size());
+  map<Color, vector<int>> v_grps;
+  for (unsigned int i = 0; i < vs.size(); i++)
+    if (!cols[i].is_invisible())
+      v_grps[cols[i]].push_back(i);
+
+  char sphere[MSG_SZ];
+  snprintf(sphere, MSG_SZ, "Sphere { radius %g }", get_vert_rad());
+  string name = dots2underscores(sc_geom->get_name());
+  TextBuffer buf(ofile);
+  long grp_no = 0;
+  for (const auto &grp : v_grps) {
+    string proto_name = "V" + get_id_label() + "_" + name;
+    string col_fields = " " + vrml_col_fields(grp.first);
+    if (grp.second.size() >= min_proto_elems) {
+      proto_name += "_" + std::to_string(grp_no++);
+      col_fields = "";
+      buf << "\n"
+          << vrml_elem_proto(proto_name, "   field SFVec3f C 0 0 0\n",
+                             "      translation IS C\n", grp.first, sphere)
+          << "\n";
+    }
+    for (int v_idx : grp.second)
+      buf << proto_name << "{C " << vrml_vec(vs[v_idx], sig_digits)
+          << col_fields << "}\n";
+  }
+  buf << "\n\n\n";
+}
+
+void DisplayPoly::vrml_edges_inst(FILE *ofile)
+{
+  fprintf(ofile, "# Edge elements\n");
+
+  const vector<Vec3d> &vs = disp_geom.verts();
+  const vector<vector<int>> &es = disp_geom.edges();
+  vector<Color> cols = vrml_elem_cols(*this, EDGES, es.size());
+  map<Color, vector<int>> e_grps;
+  for (unsigned int i = 0; i < es.size(); i++) {
+    // skip edges of zero length, which have no direction
+    if (!cols[i].is_invisible() && (vs[es[i][0]] - vs[es[i][1]]).len2() > 0)
+      e_grps[cols[i]].push_back(i);
+  }
+
+  char cylinder[MSG_SZ];
+  snprintf(cylinder, MSG_SZ, "Cylinder { radius %g height IS ht }",
+           get_edge_rad());
+  string name = dots2underscores(sc_geom->get_name());
+  TextBuffer buf(ofile);
+  long grp_no = 0;
+  for (const auto &grp : e_grps) {
+    string proto_name = "E" + get_id_label() + "_" + name;
+    string col_fields = " " + vrml_col_fields(grp.first);
+    if (grp.second.size() >= min_proto_elems) {
+      proto_name += "_" + std::to_string(grp_no++);
+      col_fields = "";
+      buf << "\n"
+          << vrml_elem_proto(proto_name,
+                             "   field SFVec3f C 0 0 0\n"
+                             "   field SFRotation R 1 0 0 0\n"
+                             "   field SFFloat ht 1\n",
+                             "      translation IS C\n"
+                             "      rotation IS R\n",
+                             grp.first, cylinder)
+          << "\n";
+    }
+    for (int e_idx : grp.second) {
+      Vec3d mid = (vs[es[e_idx][0]] + vs[es[e_idx][1]]) / 2.0;
+      Vec3d dir = vs[es[e_idx][0]] - vs[es[e_idx][1]];
+      double ht = dir.len();
+      dir /= ht;                                 // to unit
+      double ang = -acos(safe_for_trig(dir[1])); // angle between dir and y
+      Vec3d axis = vcross(dir, Vec3d(0, 1, 0)).unit();
+      char rot_ht[MSG_SZ];
+      snprintf(rot_ht, MSG_SZ, " %g ht %g", ang, ht);
+      buf << proto_name << "{C " << vrml_vec(mid, 8) << " R "
+          << vrml_vec(axis, 8) << rot_ht << col_fields << "}\n";
+    }
+  }
+  buf << "\n\n\n";
+}
+
+void DisplayPoly::vrml_faces_idx(FILE *ofile)
+{
+  fprintf(ofile, "# Face elements\n");
+
+  // A shape for each transparency, as this is part of the material, with
+  // each face colour given as an index into a table of its colours
+  const vector<vector<int>> &fs = disp_geom.faces();
+  vector<Color> cols = vrml_elem_cols(*this, FACES, fs.size());
+  map<int, vector<int>> f_alpha;
+  for (unsigned int i = 0; i < fs.size(); i++)
+    if (fs[i].size() >= 3 && !cols[i].is_invisible()) // skip degenerate
+      f_alpha[cols[i][3]].push_back(i);
+
+  TextBuffer buf(ofile);
+  for (const auto &alpha_fs : f_alpha) {
+    map<Color, long> col_idxs;
+    for (int f_idx : alpha_fs.second)
+      col_idxs.emplace(cols[f_idx], col_idxs.size());
+    vector<Color> col_tab(col_idxs.size());
+    for (const auto &col_idx : col_idxs)
+      col_tab[col_idx.second] = col_idx.first;
+
+    char trn[32];
+    snprintf(trn, sizeof(trn), "%.4f", 1 - Color::i2f(alpha_fs.first));
+    buf << "Shape {\n"
+           "   appearance Appearance {\n"
+           "      material Material { transparency "
+        << trn
+        << " }\n"
+           "   }\n"
+           "   geometry IndexedFaceSet {\n"
+           "      colorPerVertex FALSE\n"
+           "      solid FALSE\n"
+           "      coord USE CRDS\n"
+           "      color Color { color [\n";
+    for (const auto &col : col_tab)
+      buf << "\t" << vrml_col(col) << ",\n";
+    buf << "      ] }\n"
+           "      colorIndex [";
+    long f_cnt = 0;
+    for (int f_idx : alpha_fs.second)
+      buf << ((f_cnt++ % 16) ? " " : "\n\t") << col_idxs[cols[f_idx]];
+    buf << "\n      ]\n"
+           "      coordIndex [";
+    f_cnt = 0;
+    for (int f_idx : alpha_fs.second) {
+      buf << ((f_cnt++ % 4) ? "  " : "\n\t");
+      for (int v_idx : fs[f_idx])
+        buf << (long)v_idx << " ";
+      buf << "-1";
+    }
+    buf << "\n      ]\n"
+           "   }\n"
+           "}\n";
+  }
+  buf << "\n\n\n";
+}
+
 void DisplayPoly::vrml_geom(FILE *ofile, const Scene &scen, int sig_digits)
 {
   if (disp_geom.verts().size() == 0) // Don't write out empty geometries
@@ -476,17 +720,25 @@ void DisplayPoly::vrml_geom(FILE *ofile, const Scene &scen, int sig_digits)
   if (elem(VERTS).get_show()) {
     if (use_lines)
       vrml_verts_l(ofile);
+    else if (vrml_compact)
+      vrml_verts_inst(ofile, sig_digits);
     else
       vrml_verts(ofile, sig_digits);
   }
   if (elem(EDGES).get_show()) {
     if (use_lines)
       vrml_edges_l(ofile);
+    else if (vrml_compact)
+      vrml_edges_inst(ofile);
     else
       vrml_edges(ofile);
   }
-  if (elem(FACES).get_show())
-    vrml_faces(ofile);
+  if (elem(FACES).get_show()) {
+    if (vrml_compact)
+      vrml_faces_idx(ofile);
+    else
+      vrml_faces(ofile);
+  }
 
   vrml_translation_end(ofile);
 }
@@ -494,6 +746,38 @@ void DisplayPoly::vrml_geom(FILE *ofile, const Scene &scen, int sig_digits)
 // --------------------------------------------------------------
 // DisplayPoly - pov
 
+namespace {
+
+// Group the visible elements of a type by colour, unset colours are
+// grouped under an unset Color
+map<Color, vector<int>> pov_color_groups(const Geometry &geom, int type,
+                                         const Coloring &clrng)
+{
+  map<Color, vector<int>> groups;
+  int num_elems = (type == VERTS)   ? geom.verts().size()
+                  : (type == EDGES) ? geom.edges().size()
+                                    : geom.faces().size();
+  for (int i = 0; i < num_elems; i++) {
+    Color col = geom.colors(type).get(i);
+    if (col.is_index())
+      col = clrng.get_col(col.get_index());
+    if (!col.is_invisible())
+      groups[col].push_back(i);
+  }
+  return groups;
+}
+
+// Texture for a colour, selected in the same way as the element macros
+string pov_tex(const Color &col, const char *elem_name)
+{
+  return string("col_to_tex(") +
+         (col.is_set() ? pov_col(col) : string("NoColour")) + ", " +
+         elem_name + "_tex_map, " + elem_name + "_col_map, " + elem_name +
+         "_tex)";
+}
+
+} // namespace
+
 void DisplayPoly::pov_default_vals(FILE *ofile)
 {
   fprintf(ofile,
@@ -580,7 +864,7 @@ void DisplayPoly::pov_include_files(FILE *ofile)
   fprintf(ofile, "\n");
 }
 
-void DisplayPoly::pov_vert_arrays(FILE *ofile, int sig_digits)
+void DisplayPoly::pov_vert_arrays(FILE *ofile, int sig_digits, bool cols)
 {
   const vector<Vec3d> &vs = disp_geom.verts();
   fprintf(ofile,
@@ -591,11 +875,18 @@ void DisplayPoly::pov_vert_arrays(FILE *ofile, int sig_digits)
   if (!vs.size())
     return;
 
-  fprintf(ofile, "#declare verts = array [num_verts] {\n");
+  TextBuffer buf(ofile);
+  buf << "#declare verts = array [num_verts] {\n";
   for (unsigned int i = 0; i < vs.size(); i++)
-    fprintf(ofile, "   %s%s", pov_vec(vs[i], sig_digits).c_str(),
-            (i < vs.size() - 1) ? ",\n" : "");
-  fprintf(ofile, "\n}\n\n");
+    buf << "   " << pov_vec(vs[i], sig_digits)
+        << ((i < vs.size() - 1) ? ",\n" : "");
+  buf << "\n}\n\n";
+  buf.flush();
+
+  if (!cols) {
+    fprintf(ofile, "\n");
+    return;
+  }
 
   fprintf(ofile, "// Array of vertex colours\n"
                  "#declare v_cols = array [num_verts]\n");
@@ -754,16 +1045,155 @@ void DisplayPoly::pov_object(FILE *ofile)
       "#end // (show)\n");
 }
 
+void DisplayPoly::pov_mesh_object(FILE *ofile, int sig_digits)
+{
+  const vector<Vec3d> &vs = disp_geom.verts();
+  const vector<vector<int>> &es = disp_geom.edges();
+  const vector<vector<int>> &fs = disp_geom.faces();
+  TextBuffer buf(ofile);
+  buf << "#if (show)\n"
+         "#declare NoColour = <-1, -1, -1, 0>; // Indicates no colour has "
+         "been set\n"
+         "\n";
+
+  // Vertex balls and edge rods, in a union for each colour
+  buf << "// Display vertex elements\n"
+         "#if (verts_show)\n";
+  for (const auto &grp : pov_color_groups(disp_geom, VERTS, clrngs[VERTS])) {
+    bool grouped = grp.second.size() > 1;
+    if (grouped)
+      buf << "   union {\n";
+    for (int v_idx : grp.second)
+      buf << "   sphere{verts[" << (long)v_idx << "] vert_sz"
+          << (grouped ? "}\n" : " ");
+    buf << "   " << pov_tex(grp.first, "vert") << "\n"
+        << "   }\n";
+  }
+  buf << "#end // (verts_show)\n"
+         "\n";
+
+  buf << "// Display edge elements\n"
+         "#if (edges_show)\n";
+  for (auto &grp : pov_color_groups(disp_geom, EDGES, clrngs[EDGES])) {
+    // POV-Ray does not allow cylinders of zero length
+    vector<int> &e_idxs = grp.second;
+    e_idxs.erase(std::remove_if(e_idxs.begin(), e_idxs.end(),
+                                [&](int e_idx) {
+                                  Vec3d e_vec = vs[es[e_idx][1]] -
+                                                vs[es[e_idx][0]];
+                                  return e_vec.len2() == 0.0;
+                                }),
+                 e_idxs.end());
+    if (e_idxs.empty())
+      continue;
+    bool grouped = e_idxs.size() > 1;
+    if (grouped)
+      buf << "   union {\n";
+    for (int e_idx : e_idxs)
+      buf << "   cylinder{verts[" << (long)es[e_idx][0] << "] verts["
+          << (long)es[e_idx][1] << "] edge_sz" << (grouped ? "}\n" : " ");
+    buf << "   " << pov_tex(grp.first, "edge") << "\n"
+        << "   }\n";
+  }
+  buf << "#end // (edges_show)\n"
+         "\n";
+
+  // Faces as a single mesh, with a texture for each colour. Faces with
+  // more than three vertices are split into triangles around the centroid,
+  // in the same way as the disp_face_triangles macro
+  buf << "// Display face elements\n"
+         "#if (faces_show)\n";
+  auto f_grps = pov_color_groups(disp_geom, FACES, clrngs[FACES]);
+  long num_tris = 0;
+  vector<int> centre_fs;
+  for (const auto &grp : f_grps)
+    for (int f_idx : grp.second) {
+      int f_sz = fs[f_idx].size();
+      if (f_sz > 3) {
+        num_tris += f_sz;
+        centre_fs.push_back(f_idx);
+      }
+      else if (f_sz == 3)
+        num_tris++;
+    }
+
+  if (num_tris) {
+    buf << "   mesh2 {\n"
+           "      vertex_vectors {\n"
+           "         "
+        << (long)(vs.size() + centre_fs.size());
+    for (long i = 0; i < (long)vs.size(); i++)
+      buf << ",\n         verts[" << i << "]";
+    for (int f_idx : centre_fs)
+      buf << ",\n         "
+          << pov_vec(disp_geom.face_cent(f_idx), sig_digits);
+    buf << "\n"
+           "      }\n"
+           "      texture_list {\n"
+           "         "
+        << (long)f_grps.size();
+    for (const auto &grp : f_grps)
+      buf << ",\n         " << pov_tex(grp.first, "face");
+    buf << "\n"
+           "      }\n"
+           "      face_indices {\n"
+           "         "
+        << num_tris;
+    long tex_idx = 0;
+    long centre_idx = vs.size();
+    for (const auto &grp : f_grps) {
+      for (int f_idx : grp.second) {
+        const vector<int> &face = fs[f_idx];
+        int f_sz = face.size();
+        if (f_sz == 3)
+          buf << ",\n         <" << (long)face[0] << ", " << (long)face[1]
+              << ", " << (long)face[2] << ">, " << tex_idx;
+        else if (f_sz > 3) {
+          for (int i = 0; i < f_sz; i++)
+            buf << ",\n         <" << centre_idx << ", " << (long)face[i]
+                << ", " << (long)face[(i + 1) % f_sz] << ">, " << tex_idx;
+          centre_idx++;
+        }
+      }
+      tex_idx++;
+    }
+    buf << "\n"
+           "      }\n"
+           "   }\n";
+  }
+  buf << "#end // (faces_show)\n"
+         "\n"
+         "// Extra object\n"
+         "disp_extra()\n"
+         "\n"
+         "#end // (show)\n";
+}
+
 void DisplayPoly::pov_geom(FILE *ofile, const Scene &, int sig_digits)
 {
   if (disp_geom.verts().size() == 0) // Don't write out empty geometries
     return;
   pov_default_vals(ofile);
   pov_disp_macros(ofile);
-  pov_elements(ofile, sig_digits);
+  if (pov_mesh) {
+    // the elements refer to the vertex array, and the number labels are
+    // positioned using the edge and face arrays
+    pov_vert_arrays(ofile, sig_digits, false);
+    GeometryDisplayLabel *labs = sc_geom->get_label();
+    if (labs &&
+        (labs->elem(EDGES).get_show() || labs->elem(FACES).get_show())) {
+      pov_edge_arrays(ofile);
+      pov_face_arrays(ofile);
+    }
+  }
+  else
+    pov_elements(ofile, sig_digits);
   pov_col_maps(ofile);
   pov_include_files(ofile);
-  pov_object(ofile);
+  if (pov_mesh)
+    pov_mesh_object(ofile, sig_digits);
+  else
+    pov_object(ofile);
 }
 
 #ifdef HAVE_CONFIG_H
@@ -1258,38 +1688,31 @@ void ViewOpts::set_sym_defs(const DisplaySymmetry &defs)
   sym_defs = dynamic_cast<DisplaySymmetry *>(defs.clone());
 }
 
-void ViewOpts::set_view_vals(Scene &scen)
+void ViewOpts::add_view_geom(Scene &scen, Geometry &geom,
+                             const string &name) const
 {
-  scen = scen_defs;
-  scen.add_camera(cam_defs);
-
-  for (unsigned int i = 0; i < ifiles.size(); i++) {
-    Geometry geom;
-    read_or_error(geom, ifiles[i]);
-
-    if ((get_geom_defs().elem(EDGES).get_col() != Color(0, 0, 0, 0)))
-      geom.add_missing_impl_edges();
-
-    SceneGeometry sc_geom;
-    sc_geom.set_scene(&scen);
-    sc_geom.add_disp(get_geom_defs());
-    sc_geom.set_label(*lab_defs);
-    sc_geom.set_sym(*sym_defs);
-    sc_geom.set_geom(geom);
-
-    if (ifiles[i] != "")
-      sc_geom.set_name(basename2(ifiles[i].c_str()));
-    else
-      sc_geom.set_name("stdin");
-
-    scen.add_geom(sc_geom);
+  if ((geom_defs->elem(EDGES).get_col() != Color(0, 0, 0, 0)))
+    geom.add_missing_impl_edges();
+
+  SceneGeometry sc_geom;
+  sc_geom.set_scene(&scen);
+  sc_geom.add_disp(*geom_defs);
+  sc_geom.set_label(*lab_defs);
+  sc_geom.set_sym(*sym_defs);
+  sc_geom.set_geom(geom);
+  sc_geom.set_name(name);
+  scen.add_geom(sc_geom);
+
+  // Use element sizes from first geometry
+  scen.get_geoms().back().get_disps()[0]->elem(EDGES).set_size(
+      scen.get_geoms()[0].get_disps()[0]->get_edge_rad());
+  scen.get_geoms().back().get_disps()[0]->elem(VERTS).set_size(
+      scen.get_geoms()[0].get_disps()[0]->get_vert_rad());
+}
 
-    // Use element sizes from first geometry
-    scen.get_geoms()[i].get_disps()[0]->elem(EDGES).set_size(
-        scen.get_geoms()[0].get_disps()[0]->get_edge_rad());
-    scen.get_geoms()[i].get_disps()[0]->elem(VERTS).set_size(
-        scen.get_geoms()[0].get_disps()[0]->get_vert_rad());
-  }
+Status ViewOpts::check_view_width(Scene &scen) const
+{
+  Status stat;
   if (scen.get_width() < epsilon) {
     if (scen.get_inf_dist() >= 0) {
       BoundSphere bound_sph;
@@ -1303,11 +1726,40 @@ void ViewOpts::set_view_vals(Scene &scen)
     }
 
     if (scen.get_width() < epsilon)
-      warning("scene width is zero and may not be displayed correctly");
+      stat.set_warning("scene width is zero and may not be displayed "
+                       "correctly");
     else
-      warning("geometry assumed to be large, with no infinite vertices "
-              "(set option -I appropriately if this is not correct)");
+      stat.set_warning("geometry assumed to be large, with no infinite "
+                       "vertices (set option -I appropriately if this is "
+                       "not correct)");
   }
+  return stat;
+}
+
+void ViewOpts::set_view_vals(Scene &scen)
+{
+  scen = scen_defs;
+  scen.add_camera(cam_defs);
+
+  for (unsigned int i = 0; i < ifiles.size(); i++) {
+    Geometry geom;
+    read_or_error(geom, ifiles[i]);
+    add_view_geom(scen, geom,
+                  (ifiles[i] != "") ? basename2(ifiles[i].c_str()) : "stdin");
+  }
+
+  Status stat = check_view_width(scen);
+  if (stat.is_warning())
+    warning(stat.msg());
+}
+
+Status ViewOpts::set_view_vals(Scene &scen, Geometry geom,
+                               const string &name) const
+{
+  scen = scen_defs;
+  scen.add_camera(cam_defs);
+  add_view_geom(scen, geom, name);
+  return check_view_width(scen);
 }
 
 const char *ViewOpts::help_view_text =
@@ -43,7 +43,9 @@ private:
   unsigned int winding_rule;
   int face_alpha;
   bool use_lines;                    // vrml
+  bool vrml_compact;                 // vrml
   std::vector<std::string> includes; // pov
+  bool pov_mesh;                     // pov
 
 protected:
   Geometry disp_geom;
@@ -57,16 +59,20 @@ protected:
   void vrml_edges_l(FILE *ofile);
   void vrml_edges(FILE *ofile);
   void vrml_faces(FILE *ofile);
+  void vrml_verts_inst(FILE *ofile, int sig_digits);
+  void vrml_edges_inst(FILE *ofile);
+  void vrml_faces_idx(FILE *ofile);
 
   void pov_default_vals(FILE *ofile);
   void pov_disp_macros(FILE *ofile);
-  void pov_vert_arrays(FILE *ofile, int sig_digits);
+  void pov_vert_arrays(FILE *ofile, int sig_digits, bool cols = true);
   void pov_edge_arrays(FILE *ofile);
   void pov_face_arrays(FILE *ofile);
   void pov_elements(FILE *ofile, int sig_digits);
   void pov_col_maps(FILE *ofile);
   void pov_include_files(FILE *ofile);
   void pov_object(FILE *ofile);
+  void pov_mesh_object(FILE *ofile, int sig_digits);
 
 public:
   DisplayPoly();
@@ -83,9 +89,13 @@ public:
 
   void set_use_lines(bool lines) { use_lines = lines; }
   bool get_use_lines() { return use_lines; }
+  void set_vrml_compact(bool compact) { vrml_compact = compact; }
+  bool get_vrml_compact() const { return vrml_compact; }
   void set_includes(std::vector<std::string> incs) { includes = incs; }
   std::vector<std::string> &get_includes() { return includes; }
   const std::vector<std::string> &get_includes() const { return includes; }
+  void set_pov_mesh(bool mesh) { pov_mesh = mesh; }
+  bool get_pov_mesh() const { return pov_mesh; }
 
   Geometry &get_disp_geom() { return disp_geom; }
   GeometryDisplay *clone() const { return new DisplayPoly(*this); }
@@ -167,6 +177,10 @@ private:
   DisplayNumLabels *lab_defs;
   DisplaySymmetry *sym_defs;
 
+  void add_view_geom(Scene &scen, Geometry &geom,
+                     const std::string &name) const;
+  Status check_view_width(Scene &scen) const;
+
 public:
   Scene scen_defs;
   Camera cam_defs;
@@ -183,6 +197,8 @@ public:
 
   Status read_disp_option(char opt, char *optarg);
   void set_view_vals(Scene &scen);
+  Status set_view_vals(Scene &scen, Geometry geom,
+                       const std::string &name) const;
   void set_geom_defs(const DisplayPoly &defs);
   void set_num_label_defs(const DisplayNumLabels &defs);
   void set_sym_defs(const DisplaySymmetry &defs);
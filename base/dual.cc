@@ -59,11 +59,11 @@ void sym_repeat(Geometry &geom, const Geometry &part, const Transformations &ts,
 
   Geometry symmetry_unit = part;
   geom.clear_all();
+  Geometry sym_unit;
   Transformations::const_iterator si;
   int idx = 0;
   for (si = ts.begin(); si != ts.end(); si++, idx++) {
-    Geometry sym_unit = symmetry_unit;
-    sym_unit.transform(*si);
+    sym_unit.transform(symmetry_unit, *si);
     for (int i = 0; i < 3; i++)
       clrngs[i].set_geom(&sym_unit);
 
@@ -30,7 +30,9 @@
 #define ELEMPROPS_H
 
 #include "color.h"
+#include "profile.h"
 #include <map>
+#include <vector>
 
 namespace anti {
 
@@ -72,6 +74,19 @@ public:
    *           if the new index number is \c -1 then the element index
    *           has been deleted so the property is deleted. */
   void remap(const std::map<int, int> &chg_map);
+
+  /// Map properties to different index numbers.
+  /**Used to maintain properties when index numbers are changed. This
+   * can happen after deletions.
+   * \param chg_map the new index number for each old index number, if
+   *           the new index number is \c -1, or the old index number is
+   *           not included, then the property is deleted. If \a chg_map
+   *           is empty the properties are not changed. */
+  void remap(const std::vector<int> &chg_map);
+
+  /// Estimate the memory used
+  /**\return The estimated memory, in bytes, including the object. */
+  size_t memory_usage() const;
 };
 
 /// Geometry property container
@@ -101,6 +116,10 @@ public:
    * \param f_size number of faces in geometry associated with geomi. */
   void append(const GeomElemProps &geom_props, int v_size, int e_size,
               int f_size);
+
+  /// Estimate the memory used
+  /**\return The estimated memory, in bytes, including the object. */
+  size_t memory_usage() const;
 };
 
 // Implementation
@@ -152,6 +171,27 @@ template <class T> void ElemProps<T>::remap(const std::map<int, int> &chg_map)
   ElemProps = new_props;
 }
 
+template <class T> void ElemProps<T>::remap(const std::vector<int> &chg_map)
+{
+  if (!chg_map.size())
+    return;
+  std::map<int, T> new_props;
+  for (auto &kp : ElemProps) {
+    if (kp.first >= 0 && kp.first < (int)chg_map.size() &&
+        chg_map[kp.first] != -1)
+      // new index numbers are usually in order, so insert at the end
+      new_props.emplace_hint(new_props.end(), chg_map[kp.first],
+                             std::move(kp.second));
+  }
+
+  ElemProps.swap(new_props);
+}
+
+template <class T> size_t ElemProps<T>::memory_usage() const
+{
+  return sizeof(*this) + heap_memory(ElemProps);
+}
+
 template <class T>
 const ElemProps<T> &GeomElemProps<T>::operator[](int type) const
 {
@@ -181,6 +221,14 @@ void GeomElemProps<T>::append(const GeomElemProps &geom_props, int v_size,
   }
 }
 
+template <class T> size_t GeomElemProps<T>::memory_usage() const
+{
+  size_t bytes = sizeof(*this);
+  for (const auto &props : elem_props)
+    bytes += props.memory_usage() - sizeof(props);
+  return bytes;
+}
+
 } // namespace anti
 
 #endif // ELEMPROPS_H
@@ -36,10 +36,14 @@
 
 #include "geometryutils.h"
 #include "mathutils.h"
+#include "parallel.h"
 #include "private_geodesic.h"
 #include "private_misc.h"
+#include "private_off_file.h"
+#include "utils.h"
 
 using std::map;
+using std::string;
 using std::swap;
 using std::vector;
 
@@ -138,12 +142,11 @@ inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
   // polyhedron face interior
   if (pos.is_face()) {
     if (p_idx == noindex) {
-      auto mi = grid_idxs.find(int_pr(i, j));
-      if (mi == grid_idxs.end()) {
-        // fprintf(stderr, "not found in grid_idxs i=%d, j=%d\n", i, j);
+      if (i >= grid_sz || j >= grid_sz)
+        return noindex;
+      p_idx = grid_idxs[i * grid_sz + j];
+      if (p_idx == noindex)
         return noindex;
-      }
-      p_idx = mi->second;
     }
     int indx_no = V_sz + (F - 1) * base.edges().size() +
                   (F * F * (m * m + m * n + n * n) - F * 3 + 2) / 2 * indx[6] +
@@ -152,29 +155,16 @@ inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
   }
 
   if (pos.is_out()) {
-    vector<int> edge(2);
-    if (y < 0) {
-      edge[0] = indx[0];
-      edge[1] = indx[1];
-    }
-    else if (x + y > freq) {
-      edge[0] = indx[1];
-      edge[1] = indx[2];
-    }
-    else { // x<0
-      edge[0] = indx[2];
-      edge[1] = indx[0];
-    }
-
-    int nf_pos = 1;
-    if (edge[0] > edge[1]) {
-      swap(edge[0], edge[1]);
-      nf_pos = 0;
-    }
-
-    auto mi_ef = edge_faces.find(edge);
-    int nf_idx = mi_ef->second[nf_pos]; // index of neighbouring face
-    if (nf_idx == -1)                   // no neighbouring face
+    int side;
+    if (y < 0)
+      side = 0;
+    else if (x + y > freq)
+      side = 1;
+    else // x<0
+      side = 2;
+
+    int nf_idx = face_nbrs[indx[6]][side]; // index of neighbouring face
+    if (nf_idx == -1)                      // no neighbouring face
       return noindex;
 
     const vector<int> &nface = base.faces()[nf_idx];
@@ -195,8 +185,7 @@ inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
     // if(n_crds.second < n/2)
     //   return noindex;
 
-    vector<int> n_indx = make_face_indexes(nf_idx, nface);
-    return index_map(coord_i(n_crds), coord_j(n_crds), n_indx);
+    return index_map(coord_i(n_crds), coord_j(n_crds), face_indxs[nf_idx]);
   }
 
   return noindex; // should never get here!
@@ -228,79 +217,228 @@ void Geodesic::init()
     edge_idx[base.edges(i)] = i;
 
   // fprintf(stderr, "edges.size()=%d\n", edges.size());
-  edge_faces = base.get_edge_face_pairs();
-  map<vector<int>, vector<int>>::iterator mi;
+  int f_sz = base.faces().size();
+  face_indxs.resize(f_sz);
+  for (int i = 0; i < f_sz; i++)
+    face_indxs[i] = make_face_indexes(i, base.faces(i));
+
+  // The neighbouring face across each side, looked up here once rather
+  // than for every grid point that lies outside the face
+  auto edge_faces = base.get_edge_face_pairs();
+  face_nbrs.resize(f_sz, vector<int>(3, -1));
+  for (int i = 0; i < f_sz; i++) {
+    const vector<int> &face = base.faces(i);
+    for (int side = 0; side < 3; side++) {
+      int v0 = face[side];
+      int v1 = face[(side + 1) % 3];
+      auto mi_ef = edge_faces.find(make_edge(v0, v1));
+      if (mi_ef != edge_faces.end())
+        face_nbrs[i][side] = mi_ef->second[v0 < v1];
+    }
+  }
+
+  // Each edge point is set by a single face, the last face with the edge
+  edge_owner.resize(base.edges().size(), -1);
+  for (int i = 0; i < f_sz; i++)
+    for (int side = 0; side < 3; side++)
+      edge_owner[face_indxs[i][3 + side]] = i;
 
   F = freq / (m * m + m * n + n * n);
   make_grid_idxs();
 }
 
-void clear_def_edges(Geometry &geom)
+int Geodesic::num_geo_verts() const
+{
+  return base.faces().size() * (F * F * (m * m + m * n + n * n) - F * 3 + 2) /
+             2 +
+         base.edges().size() * (F - 1) + base.verts().size();
+}
+
+void Geodesic::make_points(vector<Vec3d> &gverts)
+{
+  // gverts holds the base vertices, the rest are set by their grid position
+  gverts.resize(num_geo_verts());
+  parallel_for(0, base.faces().size(),
+               [&](long i) { grid_to_points(face_indxs[i], gverts); });
+}
+
+void Geodesic::make_orig_edges(const vector<vector<vector<int>>> &oes,
+                               vector<vector<int>> &edges, vector<Color> &cols)
 {
-  vector<int> del_edges;
-  int e_sz = geom.edges().size();
-  for (int i = 0; i < e_sz; i++) {
-    if (!geom.colors(EDGES).get(i).is_set())
-      del_edges.push_back(i);
+  // Original edge segments are found from both sides, keep one of each,
+  // in sorted order, and only if the original edge was coloured
+  vector<vector<int>> e_cols;
+  for (const auto &f_oes : oes)
+    for (const auto &oe : f_oes)
+      if (base.colors(EDGES).get(oe[2]).is_set())
+        e_cols.push_back(oe);
+  sort(e_cols.begin(), e_cols.end());
+
+  edges.clear();
+  cols.clear();
+  for (const auto &e_col : e_cols) {
+    vector<int> edge(e_col.begin(), e_col.begin() + 2);
+    if (edges.size() && edges.back() == edge)
+      continue;
+    edges.push_back(edge);
+    cols.push_back(base.colors(EDGES).get(e_col[2]));
   }
-  geom.del(EDGES, del_edges);
 }
 
 void Geodesic::make_geo(Geometry &geo)
 {
-  vector<Vec3d> &gverts = geo.raw_verts();
-
-  gverts = base.verts();
+  geo.clear_all();
+  geo.raw_verts() = base.verts();
   geo.colors(VERTS) = base.colors(VERTS);
 
   if (method == 's')
     project_onto_sphere(geo, centre);
 
-  int num_verts =
-      base.faces().size() * (F * F * (m * m + m * n + n * n) - F * 3 + 2) / 2 +
-      base.edges().size() * (F - 1) + base.verts().size();
-  // fprintf(stderr, "num_verts = %d\n", num_verts);
-  // fprintf(stderr, "num_verts = %d, fs=%d, es=%d, vs=%d, F=%d, m=%d, n=%d,
-  // freq=%d\n", num_verts, faces.size(), edges.size(), verts.size(), F, m, n,
-  // freq);
+  make_points(geo.raw_verts());
+
+  // Count the triangles of each face, so they can be set in place, and
+  // collect the segments of the original edges
+  int f_sz = base.faces().size();
+  vector<long> tri_offs(f_sz + 1, 0);
+  vector<vector<vector<int>>> orig_edges(f_sz);
+  parallel_for(0, f_sz, [&](long i) {
+    tri_offs[i + 1] = grid_to_tris(face_indxs[i], nullptr, &orig_edges[i]);
+  });
+  for (int i = 0; i < f_sz; i++)
+    tri_offs[i + 1] += tri_offs[i];
+
+  vector<vector<int>> &gfaces = geo.raw_faces();
+  gfaces.resize(tri_offs[f_sz]);
+  parallel_for(0, f_sz, [&](long i) {
+    vector<int> tris(3 * (tri_offs[i + 1] - tri_offs[i]));
+    grid_to_tris(face_indxs[i], tris.data(), nullptr);
+    for (long f = tri_offs[i]; f < tri_offs[i + 1]; f++) {
+      const int *tri = &tris[3 * (f - tri_offs[i])];
+      gfaces[f].assign(tri, tri + 3);
+    }
+  });
+
+  for (int i = 0; i < f_sz; i++) {
+    Color f_col = base.colors(FACES).get(i);
+    if (f_col.is_set())
+      for (long f = tri_offs[i]; f < tri_offs[i + 1]; f++)
+        geo.colors(FACES).set(f, f_col);
+  }
 
-  gverts.resize(num_verts);
+  vector<Color> e_cols;
+  make_orig_edges(orig_edges, geo.raw_edges(), e_cols);
+  for (unsigned int i = 0; i < e_cols.size(); i++)
+    geo.colors(EDGES).set(i, e_cols[i]);
+}
 
-  vector<vector<int>> orig_edges;
-  for (unsigned int i = 0; i < base.faces().size(); i++) {
-    vector<int> indx = make_face_indexes(i, base.faces(i));
-    grid_to_points(indx, gverts);
-    vector<vector<int>> new_face_tris;
-    grid_to_tris(indx, new_face_tris, orig_edges);
-    vector<vector<int>> &gfaces = geo.raw_faces();
-    gfaces.insert(gfaces.end(), new_face_tris.begin(), new_face_tris.end());
-    Color f_col = base.colors(FACES).get(int(i));
-    for (unsigned int f = gfaces.size() - new_face_tris.size();
-         f < gfaces.size(); f++)
-      geo.colors(FACES).set(int(f), f_col);
+// Format an index element in the same way as off_file_write
+static void add_off_elem(string &out, const int *elem, int sz, const Color &col)
+{
+  char buf[MSG_SZ];
+  snprintf(buf, MSG_SZ, "%d", sz);
+  out += buf;
+  for (int i = 0; i < sz; i++) {
+    snprintf(buf, MSG_SZ, " %d", elem[i]);
+    out += buf;
   }
+  out += ' ';
+  out += off_col(buf, col);
+  out += '\n';
+}
 
-  geo.add_missing_impl_edges();
-  // fprintf(stderr, "orig_edges.size()= %d\n", orig_edges.size());
-  for (auto &orig_edge : orig_edges) {
-    vector<int> edge(2);
-    edge[0] = orig_edge[0];
-    edge[1] = orig_edge[1];
-    const vector<vector<int>> &gedges = geo.edges();
-    int e_idx = find(gedges.begin(), gedges.end(), edge) - gedges.begin();
-    Color e_col = base.colors(EDGES).get(orig_edge[2]);
-    geo.colors(EDGES).set(e_idx, e_col);
-    // char buf[MSG_SZ];
-    // vtostr(buf, e_col.get_Vec4d());
-    // fprintf(stderr, "adding edge (%d, %d) col=%s\n", edge[0], edge[1],
-    // buf);
+void Geodesic::write_off(FILE *ofile, int sig_dgts)
+{
+  // Only the vertices are held, the faces are made and written a group
+  // of base faces at a time
+  Geometry geo;
+  geo.raw_verts() = base.verts();
+  if (method == 's')
+    project_onto_sphere(geo, centre);
+  make_points(geo.raw_verts());
+  const vector<Vec3d> &gverts = geo.verts();
+
+  int f_sz = base.faces().size();
+  vector<long> tri_cnts(f_sz);
+  vector<vector<vector<int>>> orig_edges(f_sz);
+  parallel_for(0, f_sz, [&](long i) {
+    tri_cnts[i] = grid_to_tris(face_indxs[i], nullptr, &orig_edges[i]);
+  });
+  long num_tris = 0;
+  for (int i = 0; i < f_sz; i++)
+    num_tris += tri_cnts[i];
+
+  vector<vector<int>> edges;
+  vector<Color> e_cols;
+  make_orig_edges(orig_edges, edges, e_cols);
+  const auto &v_cols = base.colors(VERTS).get_properties();
+
+  fprintf(ofile, "OFF\n%lu %ld 0\n", (unsigned long)gverts.size(),
+          num_tris + (long)v_cols.size() + (long)edges.size());
+
+  // Elements are formatted in parallel blocks, and written in order
+  const long blk_sz = 16384;
+  int num_thrds = get_num_threads();
+  vector<string> outs(num_thrds);
+  auto write_outs = [&](long num_outs) {
+    for (long i = 0; i < num_outs; i++)
+      fputs(outs[i].c_str(), ofile);
+  };
+
+  long v_sz = gverts.size();
+  for (long start = 0; start < v_sz; start += num_thrds * blk_sz) {
+    long num_blks =
+        std::min(long(num_thrds), (v_sz - start + blk_sz - 1) / blk_sz);
+    parallel_for(0, num_blks, [&](long b) {
+      char line[MSG_SZ];
+      string &out = outs[b];
+      out.clear();
+      long end = std::min(start + (b + 1) * blk_sz, v_sz);
+      for (long v = start + b * blk_sz; v < end; v++) {
+        out += vtostr(line, gverts[v], " ", sig_dgts);
+        out += '\n';
+      }
+    });
+    write_outs(num_blks);
   }
-  clear_def_edges(geo);
+
+  for (int grp = 0; grp < f_sz; grp += num_thrds) {
+    int grp_end = std::min(grp + num_thrds, f_sz);
+    vector<vector<int>> tris(grp_end - grp);
+    parallel_for(grp, grp_end, [&](long i) {
+      tris[i - grp].resize(3 * tri_cnts[i]);
+      grid_to_tris(face_indxs[i], tris[i - grp].data(), nullptr);
+    });
+    for (int i = grp; i < grp_end; i++) {
+      Color f_col = base.colors(FACES).get(i);
+      const vector<int> &f_tris = tris[i - grp];
+      for (long start = 0; start < tri_cnts[i]; start += num_thrds * blk_sz) {
+        long num_blks = std::min(long(num_thrds),
+                                 (tri_cnts[i] - start + blk_sz - 1) / blk_sz);
+        parallel_for(0, num_blks, [&](long b) {
+          string &out = outs[b];
+          out.clear();
+          long end = std::min(start + (b + 1) * blk_sz, tri_cnts[i]);
+          for (long t = start + b * blk_sz; t < end; t++)
+            add_off_elem(out, &f_tris[3 * t], 3, f_col);
+        });
+        write_outs(num_blks);
+      }
+      tris[i - grp] = vector<int>(); // release memory
+    }
+  }
+
+  string &out = outs[0];
+  out.clear();
+  for (unsigned int i = 0; i < edges.size(); i++)
+    add_off_elem(out, edges[i].data(), 2, e_cols[i]);
+  for (const auto &kp : v_cols)
+    add_off_elem(out, &kp.first, 1, kp.second);
+  write_outs(1);
 }
 
-void Geodesic::grid_to_points(vector<int> indx, vector<Vec3d> &gverts)
+void Geodesic::grid_to_points(const vector<int> &indx, vector<Vec3d> &gverts)
 {
-  const vector<int> face = base.faces(indx[6]);
+  const vector<int> &face = base.faces(indx[6]);
   // fprintf(stderr, "\n+++++++\t\t\t\tface %d = (%d, %d, %d)\n", indx[6],
   // face[0], face[1], face[2]);
 
@@ -346,6 +484,13 @@ void Geodesic::grid_to_points(vector<int> indx, vector<Vec3d> &gverts)
       if (pos.is_out() || pos.is_vert())
         continue;
 
+      // edge points are set by only one of the faces sharing the edge
+      if (pos.is_edge()) {
+        int e_idx = (pos == IJPos::e0) ? 3 : (pos == IJPos::e1) ? 4 : 5;
+        if (edge_owner[indx[e_idx]] != indx[6])
+          continue;
+      }
+
       int x = grid_x(i, j);
       int y = grid_y(i, j);
       int n[] = {x, y, freq - x - y};
@@ -378,25 +523,18 @@ void Geodesic::grid_to_points(vector<int> indx, vector<Vec3d> &gverts)
 void Geodesic::make_grid_idxs()
 {
   int test_val = 2 * freq / (m + n);
+  grid_sz = std::max(test_val - 1, 0);
+  grid_idxs.assign((long)grid_sz * grid_sz, noindex);
   int idx = 0;
   // i and j at twice the corner angle (which lies inside the axes)
   for (int i = 0; i < test_val - 1; i++)
     for (int j = 0; j < test_val - 1; j++)
       if (get_pos(i, j).is_face())
-        grid_idxs[int_pr(i, j)] = idx++;
-}
-
-inline vector<int> make_tri(int v0, int v1, int v2)
-{
-  vector<int> tri(3);
-  tri[0] = v0;
-  tri[1] = v1;
-  tri[2] = v2;
-  return tri;
+        grid_idxs[i * grid_sz + j] = idx++;
 }
 
 int orig_edge(IJPos p0_pos, int p0_idx, IJPos p1_pos, int p1_idx,
-              vector<int> &indx, vector<int> &e_col)
+              const vector<int> &indx, vector<int> &e_col)
 {
   const int e_to_indx[] = {0, 5, 3, 1, 4, 3, 2, 7};
   int e_no = 0;
@@ -430,7 +568,7 @@ int orig_edge(IJPos p0_pos, int p0_idx, IJPos p1_pos, int p1_idx,
 }
 
 void add_orig_edges(IJPos p0_pos, int p0_idx, IJPos p1_pos, int p1_idx,
-                    IJPos p2_pos, int p2_idx, vector<int> &indx,
+                    IJPos p2_pos, int p2_idx, const vector<int> &indx,
                     vector<vector<int>> &e_cols)
 {
   vector<int> e_col;
@@ -470,10 +608,22 @@ inline bool Geodesic::tri_test(int i, int j, int di, int dj)
     return dj;
 }
 
-void Geodesic::grid_to_tris(vector<int> indx, vector<vector<int>> &new_tris,
-                            vector<vector<int>> &orig_edges)
+int Geodesic::grid_to_tris(const vector<int> &indx, int *tris,
+                           vector<vector<int>> *orig_edges)
 {
+  // Triangles are written to tris, if set, and the number is returned
   int p0_idx, p1_idx, p2_idx, p3_idx;
+  int num_tris = 0;
+  auto add_tri = [&](int v0, int v1, int v2) {
+    if (tris) {
+      int *tri = tris + 3 * num_tris;
+      tri[0] = v0;
+      tri[1] = v1;
+      tri[2] = v2;
+    }
+    num_tris++;
+  };
+  bool find_orig_edges = (orig_edges && m * n == 0);
 
   int test_val = 2 * freq / (m + n);
   for (int i = 0; i < test_val - 1; i++)
@@ -489,20 +639,20 @@ void Geodesic::grid_to_tris(vector<int> indx, vector<vector<int>> &new_tris,
         if (tri_test(i, j, 1, 0)) {
           p2_idx = index_map(i + 1, j, indx);
           if (p2_idx != noindex) {
-            new_tris.push_back(make_tri(p0_idx, p1_idx, p2_idx));
-            if (m * n == 0)
+            add_tri(p0_idx, p1_idx, p2_idx);
+            if (find_orig_edges)
               add_orig_edges(p0_pos, p0_idx, p1_pos, p1_idx, p2_pos, p2_idx,
-                             indx, orig_edges);
+                             indx, *orig_edges);
           }
         }
 
         if (tri_test(i, j, 0, 1)) {
           p3_idx = index_map(i, j + 1, indx);
           if (p3_idx != noindex) {
-            new_tris.push_back(make_tri(p1_idx, p0_idx, p3_idx));
-            if (m * n == 0)
+            add_tri(p1_idx, p0_idx, p3_idx);
+            if (find_orig_edges)
               add_orig_edges(p1_pos, p1_idx, p0_pos, p0_idx, p3_pos, p3_idx,
-                             indx, orig_edges);
+                             indx, *orig_edges);
           }
         }
       }
@@ -511,4 +661,6 @@ void Geodesic::grid_to_tris(vector<int> indx, vector<vector<int>> &new_tris,
       // p0_pos.dump().c_str(), p1_idx, p1_pos.dump().c_str(), p2_idx,
       // p2_pos.dump().c_str(), p3_idx, p3_pos.dump().c_str());
     }
+
+  return num_tris;
 }
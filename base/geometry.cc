@@ -30,6 +30,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 
+#include "archive.h"
 #include "coloring.h"
 #include "geometry.h"
 #include "geometryinfo.h"
@@ -139,122 +140,132 @@ int Geometry::add_faces(const vector<vector<int>> &fces)
   return faces().size() - 1;
 }
 
-static void delete_verts(Geometry *geom, const vector<int> &v_nos,
-                         map<int, int> *vert_map)
+// Delete elements in a single pass, and set a map from old index numbers to
+// new index numbers, with deleted elements mapped to -1. The map is set
+// empty if no elements are deleted.
+template <class T>
+static void delete_elems(vector<T> &elems, const vector<int> &idxs,
+                         vector<int> &elem_map)
 {
-  vector<int> dels = v_nos;
-  map<int, int> tmp;
-  map<int, int> *v_map = (vert_map) ? vert_map : &tmp;
-  v_map->clear();
-  if (!dels.size())
+  elem_map.clear();
+  if (!idxs.size())
     return;
-  sort(dels.begin(), dels.end());
-  unsigned int del_verts_cnt = 0;
-  int map_to;
-  for (unsigned int i = 0; i < geom->verts().size(); i++) {
-    if (del_verts_cnt < dels.size() && (int)i == dels[del_verts_cnt]) {
-      del_verts_cnt++;
-      map_to = -1;
-    }
-    else {
-      map_to = i - del_verts_cnt;
-      geom->verts(map_to) = geom->verts(i);
+  elem_map.assign(elems.size(), 0);
+  int del_cnt = 0;
+  for (int idx : idxs)
+    if (idx >= 0 && idx < (int)elems.size() && elem_map[idx] != -1) {
+      elem_map[idx] = -1;
+      del_cnt++;
     }
-    (*v_map)[i] = map_to;
+  if (!del_cnt) {
+    elem_map.clear();
+    return;
   }
-  geom->raw_verts().resize(geom->verts().size() - del_verts_cnt);
 
-  vector<int> del_faces;
-  for (unsigned int i = 0; i < geom->faces().size(); i++) {
-    int curr_idx = 0;
-    for (unsigned int j = 0; j < geom->faces(i).size(); j++) {
-      int new_idx = (*v_map)[geom->faces(i, j)];
-      if (new_idx >= 0)
-        geom->raw_faces()[i][curr_idx++] = new_idx;
+  int new_idx = 0;
+  for (unsigned int i = 0; i < elems.size(); i++) {
+    if (elem_map[i] != -1) {
+      if (new_idx != (int)i)
+        elems[new_idx] = std::move(elems[i]);
+      elem_map[i] = new_idx++;
     }
-    geom->raw_faces()[i].resize(curr_idx);
-    if (curr_idx < 3)
-      del_faces.push_back(i);
   }
-  geom->del(FACES, del_faces);
-
-  vector<int> del_edges;
-  for (unsigned int i = 0; i < geom->edges().size(); i++)
-    for (unsigned int j = 0; j < 2; j++) {
-      int new_idx = (*v_map)[geom->edges(i, j)];
-      if (new_idx >= 0)
-        geom->raw_edges()[i][j] = new_idx;
-      else {
-        del_edges.push_back(i);
-        break;
-      }
-    }
-  geom->del(EDGES, del_edges);
+  elems.resize(new_idx);
 }
 
-static void delete_faces(Geometry *geom, const vector<int> &f_nos,
-                         map<int, int> *face_map)
+// Change the vertex index numbers of faces and edges, vertices mapped to -1
+// are removed, and if merging then repeated vertices are removed. Faces left
+// with fewer than three vertices, and edges with fewer than two, are deleted
+// in the same pass.
+static void remap_elem_verts(Geometry *geom, const vector<int> &v_map,
+                             bool merge)
 {
-  vector<int> dels = f_nos;
-  if (face_map)
-    face_map->clear();
-  if (!dels.size())
-    return;
-  sort(dels.begin(), dels.end());
-  unsigned int del_faces_cnt = 0;
-  int map_to;
-  for (unsigned int i = 0; i < geom->faces().size(); i++) {
-    if (del_faces_cnt < dels.size() && (int)i == dels[del_faces_cnt]) {
-      del_faces_cnt++;
-      map_to = -1;
+  auto new_v_idx = [&](int idx) {
+    return (idx >= 0 && idx < (int)v_map.size()) ? v_map[idx] : -1;
+  };
+
+  vector<vector<int>> &faces = geom->raw_faces();
+  vector<int> f_map(faces.size());
+  int new_idx = 0;
+  for (unsigned int i = 0; i < faces.size(); i++) {
+    vector<int> &face = faces[i];
+    int curr_idx = 0;
+    for (int v_idx : face) {
+      int map_to = new_v_idx(v_idx);
+      if (map_to >= 0)
+        face[curr_idx++] = map_to;
+    }
+    face.resize(curr_idx);
+    if (merge && face.size()) {
+      auto vi = unique(face.begin(), face.end());
+      if (face[0] == *(vi - 1))
+        vi--;
+      face.resize(vi - face.begin());
     }
+    if (face.size() < 3)
+      f_map[i] = -1;
     else {
-      map_to = i - del_faces_cnt;
-      geom->raw_faces()[map_to] = geom->faces(i);
+      if (new_idx != (int)i)
+        faces[new_idx] = std::move(face);
+      f_map[i] = new_idx++;
     }
-    if (face_map)
-      (*face_map)[i] = map_to;
   }
-  geom->raw_faces().resize(geom->faces().size() - del_faces_cnt);
-}
+  if (new_idx < (int)faces.size()) {
+    faces.resize(new_idx);
+    geom->colors(FACES).remap(f_map);
+  }
 
-static void delete_edges(Geometry *geom, const vector<int> &e_nos,
-                         map<int, int> *edge_map)
-{
-  vector<int> dels = e_nos;
-  if (edge_map)
-    edge_map->clear();
-  if (!dels.size())
-    return;
-  sort(dels.begin(), dels.end());
-  unsigned int del_edges_cnt = 0;
-  int map_to;
-  for (unsigned int i = 0; i < geom->edges().size(); i++) {
-    if (del_edges_cnt < dels.size() && (int)i == dels[del_edges_cnt]) {
-      del_edges_cnt++;
-      map_to = -1;
-    }
+  vector<vector<int>> &edges = geom->raw_edges();
+  vector<int> e_map(edges.size());
+  new_idx = 0;
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    vector<int> &edge = edges[i];
+    for (int &v_idx : edge)
+      v_idx = new_v_idx(v_idx);
+    if (edge[0] < 0 || edge[1] < 0 || (merge && edge[0] == edge[1]))
+      e_map[i] = -1;
     else {
-      map_to = i - del_edges_cnt;
-      geom->raw_edges()[map_to] = geom->edges(i);
+      if (new_idx != (int)i)
+        edges[new_idx] = std::move(edge);
+      e_map[i] = new_idx++;
     }
-    if (edge_map)
-      (*edge_map)[i] = map_to;
   }
-  geom->raw_edges().resize(geom->edges().size() - del_edges_cnt);
+  if (new_idx < (int)edges.size()) {
+    edges.resize(new_idx);
+    geom->colors(EDGES).remap(e_map);
+  }
 }
 
-void Geometry::del(int type, const vector<int> &idxs, map<int, int> *elem_map)
+static void delete_verts(Geometry *geom, const vector<int> &v_nos,
+                         vector<int> &v_map)
 {
-  map<int, int> tmp;
-  map<int, int> *elm_map = (elem_map) ? elem_map : &tmp;
+  delete_elems(geom->raw_verts(), v_nos, v_map);
+  if (v_map.size())
+    remap_elem_verts(geom, v_map, false);
+}
+
+void Geometry::del(int type, const vector<int> &idxs, vector<int> *elem_map)
+{
+  vector<int> tmp;
+  vector<int> &elm_map = (elem_map) ? *elem_map : tmp;
   if (type == VERTS)
     delete_verts(this, idxs, elm_map);
   else if (type == EDGES)
-    delete_edges(this, idxs, elm_map);
+    delete_elems(raw_edges(), idxs, elm_map);
   else if (type == FACES)
-    delete_faces(this, idxs, elm_map);
-  colors(type).remap(*elm_map);
+    delete_elems(raw_faces(), idxs, elm_map);
+  colors(type).remap(elm_map);
+}
+
+void Geometry::del(int type, const vector<int> &idxs, map<int, int> *elem_map)
+{
+  vector<int> v_map;
+  del(type, idxs, &v_map);
+  if (elem_map) {
+    elem_map->clear();
+    for (unsigned int i = 0; i < v_map.size(); i++)
+      elem_map->emplace_hint(elem_map->end(), i, v_map[i]);
+  }
 }
 
 void Geometry::del(int type, int idx, map<int, int> *elem_map)
@@ -305,6 +316,12 @@ void Geometry::clear_all()
   clear(FACES);
 }
 
+size_t Geometry::memory_usage() const
+{
+  return sizeof(*this) + heap_memory(vert_elems) + heap_memory(face_elems) +
+         heap_memory(edge_elems) + cols.memory_usage() - sizeof(cols);
+}
+
 void Geometry::get_impl_edges(vector<vector<int>> &edgs) const
 {
   // edgs hasn't been cleared
@@ -346,6 +363,16 @@ Status Geometry::orient(int type)
 
 void Geometry::orient_reverse() { return ::orient_reverse(*this); }
 
+void Geometry::transform(const Geometry &geom, const Trans3d &trans)
+{
+  if (&geom != this) {
+    face_elems = geom.face_elems;
+    edge_elems = geom.edge_elems;
+    cols = geom.cols;
+  }
+  anti::transform(vert_elems, geom.vert_elems, trans);
+}
+
 void Geometry::sym_align() { transform(Symmetry(*this).get_to_std()); }
 
 void Geometry::triangulate(Color col, unsigned int winding, vector<int> *fmap)
@@ -355,6 +382,17 @@ void Geometry::triangulate(Color col, unsigned int winding, vector<int> *fmap)
 
 Status Geometry::read(string file_name)
 {
+  string arc_name, model_name;
+  if (split_archive_ref(file_name, arc_name, model_name)) {
+    Archive arc;
+    Status stat = arc.open(arc_name);
+    if (stat.is_error()) {
+      clear_all();
+      return stat;
+    }
+    return arc.read(model_name, *this);
+  }
+
   Status stat;
   char errmsg[MSG_SZ];
   if (!off_file_read(file_name, *this, errmsg))
@@ -388,6 +426,21 @@ Status Geometry::read_resource(string res_name)
 
 Status Geometry::write(string file_name, int sig_dgts) const
 {
+  string arc_name, model_name;
+  if (split_archive_ref(file_name, arc_name, model_name, true)) {
+    ArchiveWriter arc;
+    Status stat = arc.open(arc_name, true);
+    if (stat.is_error())
+      return stat;
+    stat = arc.add(model_name, *this, sig_dgts);
+    if (stat.is_error())
+      return stat;
+    return arc.close();
+  }
+
+  if (is_ply_file_name(file_name))
+    return write_ply(file_name, "binary_little_endian", sig_dgts);
+
   Status stat;
   char errmsg[MSG_SZ];
   if (!off_file_write(file_name, *this, errmsg, sig_dgts))
@@ -437,6 +490,27 @@ void Geometry::write_obj(FILE *file, FILE *mfile, string mtl_file,
   obj_write(file, mfile, mtl_file, *this, sep, sig_dgts);
 }
 
+Status Geometry::write_ply(string file_name, string format,
+                           int sig_dgts) const
+{
+  if (format != "ascii" && format != "binary_little_endian" &&
+      format != "binary_big_endian")
+    return Status::error("unknown PLY format '" + format + "'");
+
+  Status stat;
+  char errmsg[MSG_SZ];
+  if (!ply_file_write(file_name, *this, errmsg, format.c_str(), sig_dgts))
+    stat.set_error(errmsg);
+  else if (*errmsg)
+    stat.set_warning(errmsg);
+  return stat;
+}
+
+void Geometry::write_ply(FILE *file, string format, int sig_dgts) const
+{
+  ply_file_write(file, *this, format.c_str(), sig_dgts);
+}
+
 GeometryInfo Geometry::get_info() const { return GeometryInfo(*this); }
 
 vector<int> make_face(int v1, ...)
@@ -503,45 +577,39 @@ Geometry::get_edge_face_pairs(bool oriented) const
   return edge2facepr;
 }
 
-void Geometry::verts_merge(map<int, int> &vmap)
+void Geometry::verts_merge(const vector<int> &vmap)
 {
-  map<int, int>::iterator vmi;
-  vector<int> del_faces;
-  for (unsigned int i = 0; i < faces().size(); i++) {
-    for (unsigned int j = 0; j < faces(i).size(); j++) {
-      int idx = faces(i, j);
-      vmi = vmap.find(idx);
-      if (vmi != vmap.end())
-        raw_faces()[i][j] = vmap[idx];
-    }
-    if (raw_faces()[i].size()) {
-      auto vi = unique(raw_faces()[i].begin(), raw_faces()[i].end());
-      if (faces(i, 0) == *(vi - 1))
-        vi--;
-      raw_faces()[i].resize(vi - faces(i).begin());
-    }
-    if (faces(i).size() < 3)
-      del_faces.push_back(i);
-  }
-  del(FACES, del_faces);
-
-  vector<int> del_edges;
-  for (unsigned int i = 0; i < edges().size(); i++) {
-    for (unsigned int j = 0; j < edges(i).size(); j++) {
-      int idx = edges(i, j);
-      vmi = vmap.find(idx);
-      if (vmi != vmap.end())
-        raw_edges()[i][j] = vmap[idx];
-    }
-    if (edges(i, 0) == edges(i, 1))
-      del_edges.push_back(i);
+  vector<int> del_verts;
+  for (unsigned int i = 0; i < vmap.size() && i < verts().size(); i++)
+    if (vmap[i] >= 0 && vmap[i] != (int)i)
+      del_verts.push_back(i);
+
+  vector<int> v_map;
+  delete_elems(raw_verts(), del_verts, v_map);
+  colors(VERTS).remap(v_map);
+
+  // map each merged vertex to the new index of the vertex replacing it
+  int old_verts_sz = (v_map.size()) ? v_map.size() : verts().size();
+  vector<int> merge_map(old_verts_sz);
+  for (unsigned int i = 0; i < merge_map.size(); i++) {
+    int idx = (i < vmap.size() && vmap[i] >= 0) ? vmap[i] : i;
+    if (v_map.size())
+      idx = (idx < (int)v_map.size()) ? v_map[idx] : -1;
+    merge_map[i] = idx;
   }
-  del(EDGES, del_edges);
+  remap_elem_verts(this, merge_map, true);
+}
 
-  vector<int> del_verts;
-  for (vmi = vmap.begin(); vmi != vmap.end(); vmi++)
-    del_verts.push_back(vmi->first);
-  del(VERTS, del_verts);
+void Geometry::verts_merge(map<int, int> &vmap)
+{
+  vector<int> v_map;
+  if (vmap.size() && vmap.rbegin()->first >= 0) {
+    v_map.resize(vmap.rbegin()->first + 1, -1);
+    for (const auto &kp : vmap)
+      if (kp.first >= 0)
+        v_map[kp.first] = kp.second;
+  }
+  verts_merge(v_map);
 }
 
 void Geometry::face_angles_lengths(int f_idx, vector<double> *angles,
@@ -256,6 +256,17 @@ public:
   virtual void del(int type, const std::vector<int> &idxs,
                    std::map<int, int> *elem_map = nullptr);
 
+  /// Delete several elements
+  /** Faces and edges that are left with too few vertices when vertices
+   *  are deleted are also deleted.
+   * \param type from VERTS, EDGES, FACES.
+   * \param idxs vertex index numbers to delete
+   * \param elem_map set to the new index number of each element, indexed
+   *  by old index number, deleted elements map to index \c -1. It is set
+   *  empty if no elements are deleted. */
+  virtual void del(int type, const std::vector<int> &idxs,
+                   std::vector<int> *elem_map);
+
   /// Delete all elements of a type
   virtual void clear(int type);
 
@@ -276,6 +287,10 @@ public:
   /**\return the colour. */
   GeomElemProps<Color> &get_cols();
 
+  /// Estimate the memory used
+  /**\return The estimated memory, in bytes, including the object. */
+  size_t memory_usage() const;
+
   /// Clear all colours for all elements
   /**\return the colour. */
   void clear_cols();
@@ -290,6 +305,14 @@ public:
    *  number of the vertex it will be replaced with */
   virtual void verts_merge(std::map<int, int> &vmap);
 
+  /// Merge some of the vertices
+  /** The faces and edges are updated in a single pass, and faces and edges
+   *  left with too few vertices are deleted.
+   * \param vmap the index number of the vertex to replace each vertex
+   *  with, indexed by vertex index number, vertices mapped to \c -1 or to
+   *  themselves, or not included, are kept. */
+  virtual void verts_merge(const std::vector<int> &vmap);
+
   /// Add missing implicit edges
   /** Add implicit edges (edges of faces) to the edge list if they are
    *  not already included.
@@ -342,6 +365,14 @@ public:
   /**\param trans the transformation matrix. */
   void transform(const Trans3d &trans);
 
+  /// Set to a transformed copy of a geometry
+  /** The vertices are transformed as they are copied, and the storage
+   *  already held is reused, so this is faster than copying a geometry
+   *  and then transforming it.
+   * \param geom the geometry to copy, which may be this geometry.
+   * \param trans the transformation matrix. */
+  void transform(const Geometry &geom, const Trans3d &trans);
+
   /// Align a polyhedron with the standard alignment for its symmetry type.
   void sym_align();
 
@@ -502,6 +533,9 @@ public:
    *  read as a Qhull formatted OFF file, and if that fails the file will be
    *  read for any coordinates (lines that contains three numbers separated
    *  by commas and/or spaces will be taken as a set of coordinates.)
+   *  A file that starts with \c ply is read as a PLY file.
+   *  A model in an archive is read with a name of the form
+   *  \c archive#name (see split_archive_ref()).
    * \param file_name the file name ("" or "-" for standard input).
    * \return status, which evaluates to \c true if the file could be read
    *  (possibly with warnings), otherwise \c false to indicate an error. */
@@ -512,6 +546,7 @@ public:
    *  read as a Qhull formatted OFF file, and if that fails the file will be
    *  read for any coordinates (lines that contains three numbers separated
    *  by commas and/or spaces will be taken as a set of coordinates.)
+   *  A file that starts with \c ply is read as a PLY file.
    * \param file the file stream.
    * \return status, which evaluates to \c true if the file could be read
    *  (possibly with warnings), otherwise \c false to indicate an error. */
@@ -525,7 +560,10 @@ public:
   virtual Status read_resource(std::string res_name = "");
 
   /// Write geometry to a file
-  /**\param file_name the file name ("" for standard output.)
+  /** A model is added to an archive with a name of the form
+   *  \c archive#name (see split_archive_ref()). A file name ending in
+   *  \c .ply is written as a binary little endian PLY file.
+   * \param file_name the file name ("" for standard output.)
    * \param sig_dgts the number of significant digits to write,
    *  or if negative then the number of digits after the decimal point.
    * \return status, which evaluates to \c true if the file could be written
@@ -580,6 +618,33 @@ public:
                          const char *sep = " ",
                          int sig_dgts = DEF_SIG_DGTS) const;
 
+  /// Write geometry to a file in PLY format
+  /** Colours are written as RGB, with alpha if any colour of the element
+   *  type is transparent. Unset and index colours are written with the
+   *  default colour for the element type.
+   * \param file_name the file name ("" for standard output.)
+   * \param format the PLY format, \c ascii, \c binary_little_endian
+   *  or \c binary_big_endian.
+   * \param sig_dgts the number of significant digits to write in the
+   *  \c ascii format, or if negative then the number of digits after the
+   *  decimal point. Binary coordinates are written as doubles.
+   * \return status, which evaluates to \c true if the file could be written
+   *  (possibly with warnings), otherwise \c false to indicate an error. */
+  virtual Status write_ply(std::string file_name = "",
+                           std::string format = "binary_little_endian",
+                           int sig_dgts = DEF_SIG_DGTS) const;
+
+  /// Write geometry to a file stream in PLY format
+  /**\param file the file stream.
+   * \param format the PLY format, \c ascii, \c binary_little_endian
+   *  or \c binary_big_endian.
+   * \param sig_dgts the number of significant digits to write in the
+   *  \c ascii format, or if negative then the number of digits after the
+   *  decimal point. */
+  virtual void write_ply(FILE *file,
+                         std::string format = "binary_little_endian",
+                         int sig_dgts = DEF_SIG_DGTS) const;
+
   /// Check if geomtery is consistently oriented
   /**\return \c true if consistently oriented, otherwise \c false. */
   bool is_oriented() const;
@@ -29,7 +29,9 @@
 #include "geometryinfo.h"
 #include "geometryutils.h"
 #include "mathutils.h"
+#include "parallel.h"
 #include "private_misc.h"
+#include "profile.h"
 #include <algorithm>
 #include <map>
 #include <set>
@@ -111,6 +113,12 @@ GeometryInfo::GeometryInfo(const Geometry &geo, Vec3d center)
   reset();
 }
 
+GeometryInfo::~GeometryInfo()
+{
+  if (profiling_enabled())
+    profile_mem("GeometryInfo", memory_usage());
+}
+
 void GeometryInfo::reset()
 {
   oriented = -1;
@@ -138,6 +146,25 @@ void GeometryInfo::reset()
   set_center(cent);
 }
 
+size_t GeometryInfo::memory_usage() const
+{
+  size_t bytes = sizeof(*this);
+  bytes += heap_memory(impl_edges) + heap_memory(efpairs) +
+           heap_memory(edge_parts) + heap_memory(face_angles) +
+           heap_memory(vert_dihed) + heap_memory(dihedral_angles) +
+           heap_memory(e_lengths) + heap_memory(ie_lengths) +
+           heap_memory(plane_angles) + heap_memory(sol_angles) +
+           heap_memory(vertex_angles) + heap_memory(vf_plane_angles) +
+           heap_memory(edge_dihedrals) + heap_memory(f_areas) +
+           heap_memory(f_perimeters) + heap_memory(f_max_nonplanars) +
+           heap_memory(vert_cons) + heap_memory(vert_cons_orig) +
+           heap_memory(face_cons) + heap_memory(vert_figs) +
+           heap_memory(vert_norms) + heap_memory(free_verts);
+  bytes += dual.memory_usage() - sizeof(dual);
+  bytes += sym.memory_usage() - sizeof(sym);
+  return bytes;
+}
+
 void GeometryInfo::set_center(Vec3d center)
 {
   cent = center;
@@ -575,8 +602,19 @@ void GeometryInfo::find_f_areas()
   area.init();
   vol = 0;
   vol_cent = Vec3d(0, 0, 0);
+
+  // face values are found in parallel, and totalled in face order
+  vector<double> f_vols(fsz);
+  vector<Vec3d> f_vol_cents(fsz);
+  parallel_for(
+      0, fsz,
+      [&](long i) {
+        f_areas[i] = geom.face_norm(i, true).len();
+        f_vols[i] = face_vol(geom, i, &f_vol_cents[i]);
+      },
+      256);
+
   for (int i = 0; i < fsz; i++) {
-    f_areas[i] = geom.face_norm(i, true).len();
     if (f_areas[i] < area.min) {
       area.min = f_areas[i];
       area.idx[ElementLimits::IDX_MIN] = i;
@@ -586,10 +624,8 @@ void GeometryInfo::find_f_areas()
       area.idx[ElementLimits::IDX_MAX] = i;
     }
     area.sum += f_areas[i];
-    Vec3d f_vol_cent;
-    double f_vol = face_vol(geom, i, &f_vol_cent);
-    vol += f_vol;
-    vol_cent += f_vol_cent * f_vol;
+    vol += f_vols[i];
+    vol_cent += f_vol_cents[i] * f_vols[i];
   }
   if (!double_eq(vol, 0))
     vol_cent /= vol;
@@ -600,12 +636,16 @@ void GeometryInfo::find_f_areas()
 void GeometryInfo::find_f_perimeters()
 {
   f_perimeters.resize(num_faces());
-  for (unsigned int i = 0; i < geom.faces().size(); i++) {
-    double perim = 0.0;
-    for (unsigned int j = 0; j < geom.faces(i).size(); j++)
-      perim += geom.edge_vec(geom.faces(i, j), geom.faces_mod(i, j + 1)).len();
-    f_perimeters[i] = perim;
-  }
+  parallel_for(
+      0, geom.faces().size(),
+      [&](long i) {
+        double perim = 0.0;
+        for (unsigned int j = 0; j < geom.faces(i).size(); j++)
+          perim +=
+              geom.edge_vec(geom.faces(i, j), geom.faces_mod(i, j + 1)).len();
+        f_perimeters[i] = perim;
+      },
+      256);
 }
 
 void GeometryInfo::find_face_angles()
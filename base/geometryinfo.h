@@ -201,9 +201,20 @@ public:
    * \param center used for any properties that are relative to a centre */
   GeometryInfo(const Geometry &geo, Vec3d center = Vec3d(0, 0, 0));
 
+  /// Destructor
+  /** If profiling is enabled, the memory used is recorded as the object
+   *  \c GeometryInfo (see profile_mem()). */
+  ~GeometryInfo();
+
   /// Reset, clear all setting
   void reset();
 
+  /// Estimate the memory used
+  /** The geometry being analysed is not included.
+   * \return The estimated memory, in bytes, including the object and
+   *  the cached values. */
+  size_t memory_usage() const;
+
   /// Get the geometry being analysed
   /**\return The geometry.*/
   const Geometry &get_geom() const;
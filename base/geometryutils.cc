@@ -61,6 +61,16 @@ bool make_geodesic_sphere(Geometry &geom, const Geometry &base, int m, int n,
   return true; // valid pattern
 }
 
+bool write_geodesic_off(FILE *ofile, const Geometry &base, int m, int n,
+                        char method, Vec3d cent, int sig_dgts)
+{
+  if (m < 0 || n < 0 || (m == 0 && n == 0))
+    return false; // invalid pattern
+  Geodesic geod(base, m, n, method, cent);
+  geod.write_off(ofile, sig_dgts);
+  return true; // valid pattern
+}
+
 void project_onto_sphere(Geometry &geom, Vec3d centre, double radius)
 {
   for (Vec3d &v : geom.raw_verts())
@@ -116,6 +116,24 @@ bool make_geodesic_planar(Geometry &geom, const Geometry &base, int m,
 bool make_geodesic_sphere(Geometry &geom, const Geometry &base, int m,
                           int n = 0, Vec3d cent = Vec3d(0, 0, 0));
 
+/// Write a geodesic division directly in OFF format.
+/** The model is the same as made by \c make_geodesic_sphere or
+ *  \c make_geodesic_planar, but only the vertices are held in memory,
+ *  the faces are written as they are generated. Use for very high
+ *  frequency divisions.
+ * \param ofile file to write to.
+ * \param base the base polyhedron
+ * \param m the first pattern specifier.
+ * \param n the second pattern specifier.
+ * \param method \c s for a geodesic sphere, \c p for a planar division.
+ * \param cent the centre of projection (geodesic sphere only).
+ * \param sig_dgts the number of significant digits to write,
+ *  or if negative then the number of digits after the decimal point.
+ * \return \c true if the pattern was valid, otherwise \c false. */
+bool write_geodesic_off(FILE *ofile, const Geometry &base, int m, int n = 0,
+                        char method = 's', Vec3d cent = Vec3d(0, 0, 0),
+                        int sig_dgts = DEF_SIG_DGTS);
+
 /// Project the vertices onto a sphere
 /**\param geom whose vertices will be projected
  * \param centre the centre of the sphere.
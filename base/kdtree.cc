@@ -0,0 +1,249 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/**\file kdtree.cc
+   \brief k-d tree for nearest neighbour and radius queries on points
+*/
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#include "kdtree.h"
+#include "profile.h"
+
+using std::pair;
+using std::vector;
+
+namespace anti {
+
+// Maximum number of points in a leaf, which is searched point by point
+static const int leaf_sz = 8;
+
+KDTree::KDTree(const vector<Vec3d> &points) { init(points); }
+
+void KDTree::init(const vector<Vec3d> &points)
+{
+  idxs.resize(points.size());
+  for (unsigned int i = 0; i < idxs.size(); i++)
+    idxs[i] = i;
+  axes.assign(points.size(), 0);
+  build(points, 0, points.size());
+
+  pts.resize(points.size());
+  for (unsigned int i = 0; i < idxs.size(); i++)
+    pts[i] = points[idxs[i]];
+}
+
+// Split the points on the axis of greatest extent. The median point is
+// the node, with points on the low side before it and on the high side
+// after it.
+void KDTree::build(const vector<Vec3d> &points, int begin, int end)
+{
+  if (end - begin <= leaf_sz)
+    return;
+
+  Vec3d min_crds = points[idxs[begin]];
+  Vec3d max_crds = min_crds;
+  for (int i = begin + 1; i < end; i++)
+    for (int j = 0; j < 3; j++) {
+      double crd = points[idxs[i]][j];
+      if (crd < min_crds[j])
+        min_crds[j] = crd;
+      else if (crd > max_crds[j])
+        max_crds[j] = crd;
+    }
+  Vec3d extent = max_crds - min_crds;
+  int axis = 0;
+  for (int j = 1; j < 3; j++)
+    if (extent[j] > extent[axis])
+      axis = j;
+
+  int mid = (begin + end) / 2;
+  std::nth_element(idxs.begin() + begin, idxs.begin() + mid,
+                   idxs.begin() + end, [&](int idx0, int idx1) {
+                     return points[idx0][axis] < points[idx1][axis];
+                   });
+  axes[mid] = axis;
+  build(points, begin, mid);
+  build(points, mid + 1, end);
+}
+
+namespace {
+
+// Search for the nearest points, keeping the best found in a heap with
+// the furthest at the front
+class NearestSearch {
+private:
+  const vector<Vec3d> &pts;
+  const vector<char> &axes;
+  Vec3d pt;
+  unsigned int k;
+  double min_dist2;
+  double bound2;
+  int skip_pos;
+
+  void consider(int pos)
+  {
+    if (pos == skip_pos)
+      return;
+    double dist2 = (pts[pos] - pt).len2();
+    if (dist2 < min_dist2 || dist2 > worst2())
+      return;
+    if (best.size() == k) {
+      std::pop_heap(best.begin(), best.end());
+      best.pop_back();
+    }
+    best.push_back(pair<double, int>(dist2, pos));
+    std::push_heap(best.begin(), best.end());
+  }
+
+public:
+  // Best points found, as (squared distance, tree position) pairs
+  vector<pair<double, int>> best;
+
+  NearestSearch(const vector<Vec3d> &pts, const vector<char> &axes,
+                const Vec3d &pt, int k, double min_dist, double bound2,
+                int skip_pos = -1)
+      : pts(pts), axes(axes), pt(pt), k(k), min_dist2(min_dist * min_dist),
+        bound2(bound2), skip_pos(skip_pos)
+  {
+  }
+
+  // Squared distance that a point must be within to be a best point
+  double worst2() const
+  {
+    return (best.size() < k) ? bound2 : best.front().first;
+  }
+
+  void search(int begin, int end)
+  {
+    if (end - begin <= leaf_sz) {
+      for (int i = begin; i < end; i++)
+        consider(i);
+      return;
+    }
+
+    int mid = (begin + end) / 2;
+    consider(mid);
+    double diff = pt[axes[mid]] - pts[mid][axes[mid]];
+    bool low_first = diff < 0;
+    search(low_first ? begin : mid + 1, low_first ? mid : end);
+    if (diff * diff <= worst2())
+      search(low_first ? mid + 1 : begin, low_first ? end : mid);
+  }
+};
+
+} // namespace
+
+int KDTree::nearest(const Vec3d &pt, double min_dist, double *dist) const
+{
+  NearestSearch srch(pts, axes, pt, 1, min_dist, 1e100);
+  srch.search(0, pts.size());
+  if (!srch.best.size())
+    return -1;
+  if (dist)
+    *dist = sqrt(srch.best[0].first);
+  return idxs[srch.best[0].second];
+}
+
+void KDTree::nearest(const Vec3d &pt, int k, vector<int> &nbrs,
+                     vector<double> *dists, double min_dist) const
+{
+  nbrs.clear();
+  if (dists)
+    dists->clear();
+  if (k < 1)
+    return;
+  NearestSearch srch(pts, axes, pt, k, min_dist, 1e100);
+  srch.search(0, pts.size());
+  std::sort_heap(srch.best.begin(), srch.best.end());
+  for (const auto &bst : srch.best) {
+    nbrs.push_back(idxs[bst.second]);
+    if (dists)
+      dists->push_back(sqrt(bst.first));
+  }
+}
+
+void KDTree::in_radius(const Vec3d &pt, double rad, vector<int> &nbrs) const
+{
+  nbrs.clear();
+  double rad2 = rad * rad;
+  vector<pair<int, int>> ranges; // ranges still to search
+  if (pts.size())
+    ranges.push_back(pair<int, int>(0, pts.size()));
+  while (ranges.size()) {
+    int begin = ranges.back().first;
+    int end = ranges.back().second;
+    ranges.pop_back();
+    if (end - begin <= leaf_sz) {
+      for (int i = begin; i < end; i++)
+        if ((pts[i] - pt).len2() <= rad2)
+          nbrs.push_back(idxs[i]);
+      continue;
+    }
+
+    int mid = (begin + end) / 2;
+    if ((pts[mid] - pt).len2() <= rad2)
+      nbrs.push_back(idxs[mid]);
+    double diff = pt[axes[mid]] - pts[mid][axes[mid]];
+    if (diff <= rad)
+      ranges.push_back(pair<int, int>(begin, mid));
+    if (diff >= -rad)
+      ranges.push_back(pair<int, int>(mid + 1, end));
+  }
+  std::sort(nbrs.begin(), nbrs.end());
+}
+
+double KDTree::min_pair_dist(double min_dist, pair<int, int> *idx_pair) const
+{
+  // the best distance so far bounds the search for the next point
+  double best2 = 1e100;
+  int best_pos[2] = {-1, -1};
+  for (unsigned int i = 0; i < pts.size(); i++) {
+    NearestSearch srch(pts, axes, pts[i], 1, min_dist, best2, i);
+    srch.search(0, pts.size());
+    if (srch.best.size() && srch.best[0].first < best2) {
+      best2 = srch.best[0].first;
+      best_pos[0] = i;
+      best_pos[1] = srch.best[0].second;
+    }
+  }
+
+  if (best_pos[0] < 0)
+    return -1;
+  if (idx_pair) {
+    idx_pair->first = std::min(idxs[best_pos[0]], idxs[best_pos[1]]);
+    idx_pair->second = std::max(idxs[best_pos[0]], idxs[best_pos[1]]);
+  }
+  return sqrt(best2);
+}
+
+size_t KDTree::memory_usage() const
+{
+  return sizeof(*this) + heap_memory(pts) + heap_memory(idxs) +
+         heap_memory(axes);
+}
+
+} // namespace anti
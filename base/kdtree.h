@@ -0,0 +1,114 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/**\file kdtree.h
+   \brief k-d tree for nearest neighbour and radius queries on points
+*/
+
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include "vec3d.h"
+
+#include <utility>
+#include <vector>
+
+namespace anti {
+
+/// k-d tree for nearest neighbour and radius queries on points
+/** The tree holds a copy of the points, and is built in O(N log N) time.
+ *  The queries are exact, and a query for each point finds the nearest
+ *  neighbours of a whole point cloud in O(N log N) time, rather than the
+ *  O(N^2) time of comparing every pair of points. */
+class KDTree {
+private:
+  std::vector<Vec3d> pts; // the points, in tree order
+  std::vector<int> idxs;  // index number of each point, in tree order
+  std::vector<char> axes; // split axis of each node, in tree order
+
+  void build(const std::vector<Vec3d> &points, int begin, int end);
+
+public:
+  /// Constructor
+  /**\param points the points to make the tree for. */
+  KDTree(const std::vector<Vec3d> &points = std::vector<Vec3d>());
+
+  /// Make the tree for a set of points
+  /**\param points the points to make the tree for. */
+  void init(const std::vector<Vec3d> &points);
+
+  /// Number of points in the tree
+  /**\return The number of points. */
+  int size() const { return pts.size(); }
+
+  /// Find the nearest point
+  /**\param pt the point to find the nearest point to.
+   * \param min_dist only consider points that are at least this distance
+   *  from \a pt, so a value greater than \c 0 excludes \a pt itself.
+   * \param dist set to the distance to the nearest point, if not \c nullptr.
+   * \return The index number of the nearest point, or \c -1 if there are
+   *  no points to consider. */
+  int nearest(const Vec3d &pt, double min_dist = 0,
+              double *dist = nullptr) const;
+
+  /// Find the nearest points
+  /**\param pt the point to find the nearest points to.
+   * \param k the number of points to find.
+   * \param nbrs set to the index numbers of the nearest points, in order
+   *  of distance. Fewer than \a k are set if the tree does not hold
+   *  enough points.
+   * \param dists set to the distances of the nearest points, if not
+   *  \c nullptr.
+   * \param min_dist only consider points that are at least this distance
+   *  from \a pt. */
+  void nearest(const Vec3d &pt, int k, std::vector<int> &nbrs,
+               std::vector<double> *dists = nullptr,
+               double min_dist = 0) const;
+
+  /// Find the points within a distance
+  /**\param pt the point to find the points around.
+   * \param rad the distance, points at this distance are included.
+   * \param nbrs set to the index numbers of the points, in increasing
+   *  order. */
+  void in_radius(const Vec3d &pt, double rad, std::vector<int> &nbrs) const;
+
+  /// Find the minimum distance between two points
+  /**\param min_dist only consider pairs of points that are at least this
+   *  distance apart, so a value greater than \c 0 excludes coincident
+   *  points.
+   * \param idx_pair set to the index numbers of the pair of points, in
+   *  increasing order, if not \c nullptr.
+   * \return The minimum distance, or \c -1 if there are no pairs of
+   *  points to consider. */
+  double min_pair_dist(double min_dist = 0,
+                       std::pair<int, int> *idx_pair = nullptr) const;
+
+  /// Estimate the memory used
+  /**\return The estimated memory, in bytes, including the object. */
+  size_t memory_usage() const;
+};
+
+} // namespace anti
+
+#endif // KDTREE_H
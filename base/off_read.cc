@@ -37,6 +37,7 @@
 #include "polygon.h"
 #include "private_off_file.h"
 #include "private_std_polys.h"
+#include "profile.h"
 #include "utils.h"
 
 using std::string;
@@ -67,7 +68,10 @@ bool off_file_read(string file_name, Geometry &geom, char *errmsg)
     file_name = "stdin";
   }
   else
-    ifile = open_sup_file(file_name.c_str(), "/models/", &alt_name);
+    // binary mode, as a PLY file may be binary, and the OFF reader
+    // accepts \r line endings
+    ifile = open_sup_file(file_name.c_str(), "/models/", &alt_name, nullptr,
+                          nullptr, "rb");
 
   if (alt_name != "") { // an alt name found before a file with the name
     if (make_resource_geom(geom, alt_name, errmsg2))
@@ -205,6 +209,13 @@ bool add_face(Geometry &geom, vector<char *> vals, char *errmsg,
 
 bool off_file_read(FILE *ifile, Geometry &geom, char *errmsg)
 {
+  // a PLY file starts with "ply", and an OFF file never starts with 'p'
+  int first_char = getc(ifile);
+  ungetc(first_char, ifile);
+  if (first_char == 'p')
+    return ply_file_read(ifile, geom, errmsg);
+
+  ProfileScope prof("off_file_read");
   char errmsg2[MSG_SZ];
 
   int file_line_no = 0; // line number in the file
@@ -356,5 +367,9 @@ bool off_file_read(FILE *ifile, Geometry &geom, char *errmsg)
   if (errmsg && !geom.is_set() && !*errmsg) // no previous error message
     strncpy(errmsg, "no vertices (empty geometry)", MSG_SZ);
 
+  profile_count("vertices read", geom.verts().size());
+  profile_count("faces read", geom.faces().size());
+  if (profiling_enabled())
+    profile_mem("Geometry (read)", geom.memory_usage());
   return geom.is_set();
 }
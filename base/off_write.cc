@@ -34,19 +34,20 @@
 #include <vector>
 
 #include "private_off_file.h"
+#include "profile.h"
 #include "utils.h"
 
 using std::map;
 using std::string;
 using std::vector;
 
-FILE *file_open_w(string file_name, char *errmsg)
+FILE *file_open_w(string file_name, char *errmsg, const char *mode)
 {
   if (errmsg)
     *errmsg = '\0';
   FILE *ofile = stdout; // write to stdout by default
   if (file_name != "") {
-    ofile = fopen(file_name.c_str(), "w");
+    ofile = fopen(file_name.c_str(), mode);
     if (!ofile && errmsg)
       snprintf(errmsg, MSG_SZ, "could not output file \'%s\'",
                file_name.c_str());
@@ -63,6 +64,7 @@ void file_close_w(FILE *ofile)
 void crds_write(FILE *ofile, const Geometry &geom, const char *sep,
                 int sig_dgts)
 {
+  ProfileScope prof("crds_write");
   char line[MSG_SZ];
   for (unsigned int i = 0; i < geom.verts().size(); i++)
     fprintf(ofile, "%s\n", vtostr(line, geom.verts(i), sep, sig_dgts));
@@ -143,6 +145,7 @@ void write_mtl_file(FILE *mfile, vector<Color> &cols)
 void obj_write(FILE *ofile, FILE *mfile, string mtl_file, const Geometry &geom,
                const char *sep, int sig_dgts)
 {
+  ProfileScope prof("obj_write");
   int offset = 1; // obj files start indexes from 1
 
   vector<Color> cols;
@@ -328,6 +331,13 @@ void off_polys_write(FILE *ofile, const Geometry &geom, int offset)
 void off_file_write(FILE *ofile, const vector<const Geometry *> &geoms,
                     int sig_dgts)
 {
+  ProfileScope prof("off_file_write");
+  if (profiling_enabled()) {
+    size_t bytes = 0;
+    for (auto geom : geoms)
+      bytes += geom->memory_usage();
+    profile_mem("Geometry (written)", bytes);
+  }
   int vert_cnt = 0, face_cnt = 0, edge_cnt = 0;
   for (auto geom : geoms) {
     int num_v_col_elems = geom->colors(VERTS).get_properties().size();
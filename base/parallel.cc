@@ -0,0 +1,228 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/**\file parallel.cc
+   \brief Utilities for running work on several threads
+*/
+
+#include "parallel.h"
+
+#include <stdlib.h>
+
+namespace anti {
+
+static int num_threads_in_use = 0; // 0: use the default
+
+// Index of the queue of the current thread, 0 for a thread that is not
+// a worker
+static thread_local int queue_idx = 0;
+
+// The pool used by parallel operations, replaced if the number of threads
+// changes. It is not deleted at exit, so a program may exit while tasks are
+// running, for example after an error.
+static ThreadPool *shared_pool = nullptr;
+static std::mutex pool_mtx;
+
+static int default_num_threads()
+{
+  static int num_threads = 0;
+  static std::once_flag once;
+  std::call_once(once, []() {
+    const char *env = getenv("ANTIPRISM_THREADS");
+    if (env) {
+      char *end;
+      long num = strtol(env, &end, 10);
+      if (*env && *end == '\0' && num > 0)
+        num_threads = (num < 1024) ? num : 1024;
+    }
+    if (num_threads < 1)
+      num_threads = std::thread::hardware_concurrency();
+  });
+  return num_threads;
+}
+
+int get_num_threads()
+{
+  int num_threads = num_threads_in_use;
+  if (num_threads < 1)
+    num_threads = default_num_threads();
+  return (num_threads > 0) ? num_threads : 1;
+}
+
+void set_num_threads(int num_threads)
+{
+  num_threads_in_use = (num_threads > 0) ? num_threads : 0;
+}
+
+ThreadPool::ThreadPool(int num_workers) : num_queued(0), stopping(false)
+{
+  for (int i = 0; i <= num_workers; i++)
+    queues.emplace_back(new Queue);
+  for (int i = 1; i <= num_workers; i++)
+    workers.push_back(std::thread(&ThreadPool::work, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+ThreadPool &ThreadPool::get_pool()
+{
+  std::lock_guard<std::mutex> lock(pool_mtx);
+  int num_workers = get_num_threads() - 1;
+  if (!shared_pool || shared_pool->size() != num_workers) {
+    delete shared_pool; // finish with the old pool first
+    shared_pool = new ThreadPool(num_workers);
+  }
+  return *shared_pool;
+}
+
+void ThreadPool::submit(Task task)
+{
+  // A thread that is not a worker of this pool uses the shared queue
+  int idx = queue_idx;
+  if (idx > size())
+    idx = 0;
+  {
+    std::lock_guard<std::mutex> lock(queues[idx]->mtx);
+    queues[idx]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    num_queued++;
+  }
+  wake.notify_one();
+}
+
+bool ThreadPool::pop(int idx, Task &task)
+{
+  if (num_queued == 0)
+    return false;
+
+  // own queue first, newest task
+  {
+    std::lock_guard<std::mutex> lock(queues[idx]->mtx);
+    if (!queues[idx]->tasks.empty()) {
+      task = std::move(queues[idx]->tasks.back());
+      queues[idx]->tasks.pop_back();
+      num_queued--;
+      return true;
+    }
+  }
+
+  // steal the oldest task from another queue
+  int num_queues = queues.size();
+  for (int i = 1; i < num_queues; i++) {
+    Queue &q = *queues[(idx + i) % num_queues];
+    std::lock_guard<std::mutex> lock(q.mtx);
+    if (!q.tasks.empty()) {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      num_queued--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ThreadPool::run_one()
+{
+  int idx = queue_idx;
+  if (idx > size())
+    idx = 0;
+  Task task;
+  if (!pop(idx, task))
+    return false;
+  task();
+  return true;
+}
+
+void ThreadPool::run_until_done(const std::atomic<long> &count)
+{
+  while (count > 0) {
+    if (run_one())
+      continue;
+    std::unique_lock<std::mutex> lock(mtx);
+    wake.wait(lock, [&]() { return count == 0 || num_queued > 0; });
+  }
+}
+
+void ThreadPool::task_done(std::atomic<long> &count)
+{
+  if (--count == 0) {
+    // lock, so the wake cannot be missed by a thread about to sleep
+    std::lock_guard<std::mutex> lock(mtx);
+    wake.notify_all();
+  }
+}
+
+void ThreadPool::work(int idx)
+{
+  queue_idx = idx;
+  Task task;
+  while (true) {
+    if (pop(idx, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    wake.wait(lock, [this]() { return stopping || num_queued > 0; });
+    if (stopping)
+      return;
+  }
+}
+
+void TaskGroup::run(ThreadPool::Task task)
+{
+  if (get_num_threads() < 2) {
+    task();
+    return;
+  }
+
+  if (!pool)
+    pool = &ThreadPool::get_pool();
+  pending++;
+  pool->submit([this, task]() {
+    task();
+    pool->task_done(pending);
+  });
+}
+
+void TaskGroup::wait()
+{
+  if (pool)
+    pool->run_until_done(pending);
+}
+
+} // namespace anti
@@ -0,0 +1,229 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/**\file parallel.h
+   \brief Utilities for running work on several threads
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace anti {
+
+/// Get the number of threads used for parallel operations
+/** Unless set with set_num_threads(), this is the value of the environment
+ *  variable \c ANTIPRISM_THREADS, if it is a positive integer, otherwise the
+ *  number of hardware threads.
+ * \return The number of threads, at least 1. */
+int get_num_threads();
+
+/// Set the number of threads used for parallel operations
+/** This should not be called while parallel operations are running.
+ * \param num_threads the number of threads, or 0 to use the default. */
+void set_num_threads(int num_threads);
+
+/// A pool of worker threads, shared by the parallel operations
+/** Each worker has its own queue of tasks. A worker takes the newest task
+ *  from its own queue, and when that is empty it takes the oldest task from
+ *  another queue. A thread waiting for tasks to finish also runs tasks, so
+ *  parallel operations may be nested. */
+class ThreadPool {
+public:
+  typedef std::function<void()> Task;
+
+private:
+  struct Queue {
+    std::mutex mtx;
+    std::deque<Task> tasks;
+  };
+  std::vector<std::unique_ptr<Queue>> queues; // one more than workers
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::condition_variable wake;
+  std::atomic<long> num_queued;
+  bool stopping;
+
+  void work(int idx);
+  bool pop(int idx, Task &task);
+
+public:
+  /// Constructor
+  /**\param num_workers the number of worker threads. */
+  ThreadPool(int num_workers);
+
+  /// Destructor, stops the workers
+  /** Tasks which have not started are not run. */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Get the pool used by the parallel operations
+  /**\return The pool, with one less worker than get_num_threads(). */
+  static ThreadPool &get_pool();
+
+  /// Get the number of worker threads
+  /**\return The number of workers. */
+  int size() const { return workers.size(); }
+
+  /// Add a task
+  /** If called from a worker the task is added to its own queue.
+   * \param task the task. */
+  void submit(Task task);
+
+  /// Run one queued task on the calling thread
+  /**\return \c true if a task was run, \c false if there were none. */
+  bool run_one();
+
+  /// Run queued tasks until a count of unfinished tasks reaches zero
+  /** The calling thread sleeps while there are no queued tasks to run.
+   * \param count the count, which is decremented with task_done(). */
+  void run_until_done(const std::atomic<long> &count);
+
+  /// Decrement a count of unfinished tasks
+  /** Wakes the threads in run_until_done() when the count reaches zero.
+   * \param count the count. */
+  void task_done(std::atomic<long> &count);
+};
+
+/// A group of tasks which can be waited for together
+/** If only one thread is in use then each task is run when it is added. */
+class TaskGroup {
+private:
+  ThreadPool *pool;
+  std::atomic<long> pending;
+
+public:
+  /// Constructor
+  TaskGroup() : pool(nullptr), pending(0) {}
+
+  /// Destructor, waits for the tasks to finish
+  ~TaskGroup() { wait(); }
+
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  /// Add a task to the group
+  /**\param task the task. */
+  void run(ThreadPool::Task task);
+
+  /// Wait for the tasks in the group to finish
+  /** The calling thread runs queued tasks while it waits. */
+  void wait();
+};
+
+/// Call a function for each index in a range, using several threads
+/** The range is split into blocks of \a grain indexes, and the blocks are
+ *  taken in turn by the threads. The calls must be independent of each
+ *  other. If only one thread is in use the calls are made in index order
+ *  on the calling thread.
+ * \param begin the first index.
+ * \param end one past the last index.
+ * \param func the function to call, taking the index as its argument.
+ * \param grain the number of indexes to process as a block. */
+template <class Func>
+void parallel_for(long begin, long end, Func func, long grain = 1)
+{
+  if (end <= begin)
+    return;
+  if (grain < 1)
+    grain = 1;
+  long num_blocks = (end - begin + grain - 1) / grain;
+  long num_threads = std::min(long(get_num_threads()), num_blocks);
+  if (num_threads < 2) {
+    for (long i = begin; i < end; i++)
+      func(i);
+    return;
+  }
+
+  std::atomic<long> next_block(0);
+  auto worker = [&]() {
+    long blk;
+    while ((blk = next_block++) < num_blocks) {
+      long blk_end = std::min(begin + (blk + 1) * grain, end);
+      for (long i = begin + blk * grain; i < blk_end; i++)
+        func(i);
+    }
+  };
+
+  TaskGroup tasks;
+  for (long t = 1; t < num_threads; t++)
+    tasks.run(worker);
+  worker();
+  tasks.wait();
+}
+
+/// Combine values for each index in a range, using several threads
+/** The range is split into blocks of \a grain indexes. The values in each
+ *  block are combined in index order, starting from \a identity, and then
+ *  the block results are combined in block order. The order of combining
+ *  depends only on \a grain, and so the result is the same for any number
+ *  of threads. If \a grain is at least the size of the range the result is
+ *  the same as combining the values in a simple loop.
+ * \param begin the first index.
+ * \param end one past the last index.
+ * \param identity the starting value for each block.
+ * \param func the function giving the value for an index.
+ * \param reduce the function to combine two values, taking the value so far
+ *  and the next value.
+ * \param grain the number of indexes to process as a block.
+ * \return The combined value, or \a identity if the range is empty. */
+template <class T, class Func, class Reduce>
+T parallel_reduce(long begin, long end, T identity, Func func, Reduce reduce,
+                  long grain = 1)
+{
+  if (end <= begin)
+    return identity;
+  if (grain < 1)
+    grain = 1;
+  long num_blocks = (end - begin + grain - 1) / grain;
+  std::vector<T> partials(num_blocks, identity);
+  parallel_for(0, num_blocks, [&](long blk) {
+    long blk_end = std::min(begin + (blk + 1) * grain, end);
+    T val = identity;
+    for (long i = begin + blk * grain; i < blk_end; i++)
+      val = reduce(val, func(i));
+    partials[blk] = val;
+  });
+
+  T val = partials[0];
+  for (long blk = 1; blk < num_blocks; blk++)
+    val = reduce(val, partials[blk]);
+  return val;
+}
+
+} // namespace anti
+
+#endif // PARALLEL_H
@@ -30,13 +30,18 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <map>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "parallel.h"
 #include "planar.h"
+#include "private_off_file.h"
+#include "random.h"
+#include "utils.h"
 
 using std::make_pair;
 using std::map;
@@ -599,6 +604,117 @@ Geometry make_stellation_diagram(Geometry &geom, int f_idx, string sym_string,
   return diagram;
 }
 
+static string stellation_cache_dir;
+
+void set_stellation_diagram_cache(const string &dir)
+{
+  stellation_cache_dir = dir;
+}
+
+static string get_stellation_diagram_cache()
+{
+  if (stellation_cache_dir != "")
+    return stellation_cache_dir;
+  const char *env_dir = getenv("ANTIPRISM_STELLATION_CACHE");
+  return (env_dir) ? env_dir : "";
+}
+
+// FNV-1a hash of the model elements, coordinates and colours
+static unsigned long long hash_geom(const Geometry &geom)
+{
+  unsigned long long hash = 14695981039346656037ULL;
+  auto add_bytes = [&](const void *data, size_t sz) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < sz; i++) {
+      hash ^= p[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  char col_str[MSG_SZ];
+  for (const auto &v : geom.verts())
+    add_bytes(v.get_v(), 3 * sizeof(double));
+  const vector<vector<int>> *elems[] = {nullptr, &geom.edges(), &geom.faces()};
+  for (int type = 0; type < 3; type++) {
+    if (elems[type]) {
+      int sz = elems[type]->size();
+      add_bytes(&sz, sizeof(sz));
+      for (const auto &elem : *elems[type]) {
+        add_bytes(elem.data(), elem.size() * sizeof(int));
+        add_bytes("|", 1);
+      }
+    }
+    for (const auto &kp : geom.colors(type).get_properties()) {
+      add_bytes(&kp.first, sizeof(kp.first));
+      off_col(col_str, kp.second);
+      add_bytes(col_str, strlen(col_str));
+    }
+  }
+  return hash;
+}
+
+static string stellation_diagram_cache_file(const string &cache_dir,
+                                            unsigned long long geom_hash,
+                                            int f_idx, const string &sym_string,
+                                            int projection_width, double eps)
+{
+  return cache_dir + "/" +
+         msg_str("stel_v1_%016llx_f%d_%s_w%d_e%g.off", geom_hash, f_idx,
+                 (sym_string != "") ? sym_string.c_str() : "full",
+                 projection_width, eps);
+}
+
+void make_stellation_diagrams(Geometry &geom, map<int, Geometry> &diagrams,
+                              const vector<int> &f_idxs, string sym_string,
+                              int projection_width, double eps)
+{
+  // faces which still need a diagram
+  vector<int> todo;
+  for (int f_idx : f_idxs)
+    if (!diagrams[f_idx].verts().size() &&
+        find(todo.begin(), todo.end(), f_idx) == todo.end())
+      todo.push_back(f_idx);
+
+  string cache_dir = get_stellation_diagram_cache();
+  unsigned long long geom_hash = (cache_dir != "") ? hash_geom(geom) : 0;
+  vector<string> cache_files(todo.size());
+  vector<bool> from_cache(todo.size(), false);
+  vector<Geometry> new_diagrams(todo.size());
+  if (cache_dir != "") {
+    for (unsigned int i = 0; i < todo.size(); i++) {
+      cache_files[i] = stellation_diagram_cache_file(
+          cache_dir, geom_hash, todo[i], sym_string, projection_width, eps);
+      FILE *cfile = fopen(cache_files[i].c_str(), "r");
+      if (cfile) {
+        fclose(cfile);
+        from_cache[i] = new_diagrams[i].read(cache_files[i]).is_ok() &&
+                        new_diagrams[i].verts().size();
+      }
+    }
+  }
+
+  parallel_for(0, todo.size(), [&](long i) {
+    if (!from_cache[i])
+      new_diagrams[i] = make_stellation_diagram(geom, todo[i], sym_string,
+                                                projection_width, eps);
+  });
+
+  Random rnd;
+  rnd.time_seed();
+  for (unsigned int i = 0; i < todo.size(); i++) {
+    if (cache_dir != "" && !from_cache[i]) {
+      // write to a temporary file and rename, so that a partial file
+      // is never read by another process
+      string tmp_file = cache_files[i] + msg_str(".tmp%lu", rnd.ranlui());
+      if (new_diagrams[i].write(tmp_file, 17).is_ok())
+        rename(tmp_file.c_str(), cache_files[i].c_str());
+      else
+        remove(tmp_file.c_str());
+    }
+    diagrams[todo[i]] = new_diagrams[i];
+  }
+}
+
 void split_pinched_faces(Geometry &geom, double eps)
 {
   vector<vector<int>> &faces = geom.raw_faces();
@@ -112,6 +112,30 @@ Geometry make_stellation_diagram(Geometry &geom, int f_idx,
                                  int projection_width = 500,
                                  double eps = epsilon);
 
+/// make stellation diagrams for a set of faces of a geom
+/** The diagrams are made in parallel. Faces which already have a diagram
+ *  in \a diagrams are skipped. If a diagram cache is set then the diagrams
+ *  are read from it when present, and new diagrams are added to it.
+ * \param geom the geometry.
+ * \param diagrams map of face index to stellation diagram, to add to.
+ * \param f_idxs the faces to make diagrams for.
+ * \param sym_string is sub-symmetry of stellation.
+ * \param projection_width is length of line extents of diagram.
+ * \param eps value for contolling the limit of precision. */
+void make_stellation_diagrams(Geometry &geom, map<int, Geometry> &diagrams,
+                              const vector<int> &f_idxs,
+                              string sym_string = "",
+                              int projection_width = 500,
+                              double eps = epsilon);
+
+/// set the directory used to cache stellation diagrams
+/** Cached diagrams are keyed by a hash of the model, the face index,
+ *  the sub-symmetry, the projection width and the precision.
+ * \param dir the cache directory. If this is "" then the directory in
+ *  the environment variable ANTIPRISM_STELLATION_CACHE is used, if set,
+ *  otherwise diagrams are not cached. */
+void set_stellation_diagram_cache(const string &dir);
+
 /// if faces are pinched (revisited vertices) in a geom, split them
 /**\param geom the geometry.
  * \param eps value for contolling the limit of precision. */
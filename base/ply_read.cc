@@ -0,0 +1,495 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/* \file ply_read.cc
+   \brief Read PLY files
+*/
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "private_off_file.h"
+#include "profile.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// PLY property types, in the order of ply_type_names
+enum {
+  PLY_INT8,
+  PLY_UINT8,
+  PLY_INT16,
+  PLY_UINT16,
+  PLY_INT32,
+  PLY_UINT32,
+  PLY_FLOAT32,
+  PLY_FLOAT64,
+  PLY_NO_TYPE
+};
+
+const char *ply_type_names[][2] = {
+    {"char", "int8"},     {"uchar", "uint8"}, {"short", "int16"},
+    {"ushort", "uint16"}, {"int", "int32"},   {"uint", "uint32"},
+    {"float", "float32"}, {"double", "float64"}};
+
+const int ply_type_sizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+int ply_type(const char *name)
+{
+  for (int i = 0; i < PLY_NO_TYPE; i++)
+    if (strcmp(name, ply_type_names[i][0]) == 0 ||
+        strcmp(name, ply_type_names[i][1]) == 0)
+      return i;
+  return PLY_NO_TYPE;
+}
+
+// How a property value is used
+enum {
+  USE_NONE,
+  USE_X,
+  USE_Y,
+  USE_Z,
+  USE_RED,
+  USE_GREEN,
+  USE_BLUE,
+  USE_ALPHA,
+  USE_IDXS,
+  USE_V1,
+  USE_V2
+};
+
+struct PlyProp {
+  string name;
+  int type;
+  int count_type; // type of list count, or PLY_NO_TYPE if not a list
+  int use;
+};
+
+struct PlyElem {
+  string name;
+  long count;
+  vector<PlyProp> props;
+};
+
+int ply_prop_use(const string &elem, const string &prop)
+{
+  if (prop == "red" || prop == "diffuse_red")
+    return USE_RED;
+  if (prop == "green" || prop == "diffuse_green")
+    return USE_GREEN;
+  if (prop == "blue" || prop == "diffuse_blue")
+    return USE_BLUE;
+  if (prop == "alpha" || prop == "diffuse_alpha")
+    return USE_ALPHA;
+  if (elem == "vertex") {
+    if (prop == "x")
+      return USE_X;
+    if (prop == "y")
+      return USE_Y;
+    if (prop == "z")
+      return USE_Z;
+  }
+  else if (elem == "face") {
+    if (prop == "vertex_indices" || prop == "vertex_index")
+      return USE_IDXS;
+  }
+  else if (elem == "edge") {
+    if (prop == "vertex1")
+      return USE_V1;
+    if (prop == "vertex2")
+      return USE_V2;
+  }
+  return USE_NONE;
+}
+
+// Read values from the body of a PLY file, through a buffer
+class PlyReader {
+private:
+  FILE *ifile;
+  bool ascii;
+  bool swap; // binary byte order is not the byte order of this machine
+  vector<char> buf;
+  size_t pos;
+  size_t end;
+
+  // Make at least num bytes available from pos
+  bool fill(size_t num);
+
+public:
+  PlyReader(FILE *file, bool is_ascii, bool big_endian)
+      : ifile(file), ascii(is_ascii), buf(1 << 16), pos(0), end(0)
+  {
+    const uint16_t one = 1;
+    swap = (*(const unsigned char *)&one == 1) == big_endian;
+  }
+
+  bool read(int type, double *val);
+};
+
+bool PlyReader::fill(size_t num)
+{
+  if (end - pos >= num)
+    return true;
+  memmove(buf.data(), buf.data() + pos, end - pos);
+  end -= pos;
+  pos = 0;
+  while (end < num) {
+    size_t num_read = fread(buf.data() + end, 1, buf.size() - end, ifile);
+    if (!num_read)
+      return false;
+    end += num_read;
+  }
+  return true;
+}
+
+bool PlyReader::read(int type, double *val)
+{
+  if (ascii) {
+    // skip whitespace, and copy the value so it is terminated
+    while (fill(1) && isspace(buf[pos]))
+      pos++;
+    char tok[64];
+    size_t len = 0;
+    while (fill(1) && !isspace(buf[pos]) && len < sizeof(tok) - 1)
+      tok[len++] = buf[pos++];
+    tok[len] = '\0';
+    char *tok_end;
+    *val = strtod(tok, &tok_end);
+    return len && *tok_end == '\0' && std::isfinite(*val);
+  }
+
+  int sz = ply_type_sizes[type];
+  if (!fill(sz))
+    return false;
+  unsigned char bytes[8];
+  memcpy(bytes, buf.data() + pos, sz);
+  pos += sz;
+  if (swap)
+    for (int i = 0; i < sz / 2; i++)
+      std::swap(bytes[i], bytes[sz - 1 - i]);
+
+  switch (type) {
+  case PLY_INT8:
+    *val = (signed char)bytes[0];
+    break;
+  case PLY_UINT8:
+    *val = bytes[0];
+    break;
+  case PLY_INT16: {
+    int16_t v;
+    memcpy(&v, bytes, sz);
+    *val = v;
+    break;
+  }
+  case PLY_UINT16: {
+    uint16_t v;
+    memcpy(&v, bytes, sz);
+    *val = v;
+    break;
+  }
+  case PLY_INT32: {
+    int32_t v;
+    memcpy(&v, bytes, sz);
+    *val = v;
+    break;
+  }
+  case PLY_UINT32: {
+    uint32_t v;
+    memcpy(&v, bytes, sz);
+    *val = v;
+    break;
+  }
+  case PLY_FLOAT32: {
+    float v;
+    memcpy(&v, bytes, sz);
+    *val = v;
+    break;
+  }
+  default: // PLY_FLOAT64
+    memcpy(val, bytes, sz);
+  }
+  return std::isfinite(*val);
+}
+
+// Values of an element that are used
+struct PlyRow {
+  Vec3d v;
+  double col[4];
+  int edge[2];
+  vector<int> face;
+  PlyRow() : v(0, 0, 0), col{0, 0, 0, 0}, edge{0, 0} {}
+};
+
+Status ply_row_read(PlyReader &rdr, const PlyElem &elem, long num_verts,
+                    PlyRow &row)
+{
+  row.face.clear();
+  double val;
+  for (const auto &prop : elem.props) {
+    if (prop.count_type != PLY_NO_TYPE) { // list
+      double num;
+      if (!rdr.read(prop.count_type, &num) || num < 0 || num > INT_MAX ||
+          num != floor(num))
+        return Status::error("invalid or missing list count");
+      for (int j = 0; j < (int)num; j++) {
+        if (!rdr.read(prop.type, &val))
+          return Status::error("invalid or missing value");
+        if (prop.use == USE_IDXS) {
+          if (val < 0 || val >= num_verts)
+            return Status::error(
+                msg_str("vertex index %.0f is not in range 0 to %ld", val,
+                        num_verts - 1));
+          row.face.push_back((int)val);
+        }
+      }
+    }
+    else {
+      if (!rdr.read(prop.type, &val))
+        return Status::error("invalid or missing value");
+      if (prop.use >= USE_X && prop.use <= USE_Z)
+        row.v[prop.use - USE_X] = val;
+      else if (prop.use >= USE_RED && prop.use <= USE_ALPHA)
+        row.col[prop.use - USE_RED] = val;
+      else if (prop.use == USE_V1 || prop.use == USE_V2) {
+        if (val < 0 || val >= num_verts)
+          return Status::error(
+              msg_str("vertex index %.0f is not in range 0 to %ld", val,
+                      num_verts - 1));
+        row.edge[prop.use - USE_V1] = (int)val;
+      }
+    }
+  }
+  return Status::ok();
+}
+
+// Read the header, and check it is valid
+bool ply_header_read(FILE *ifile, vector<PlyElem> &elems, string &format,
+                     char *errmsg)
+{
+  int line_no = 0;
+  char *line = nullptr;
+  bool header_ok = false;
+  while (read_line(ifile, &line) == 0) {
+    line_no++;
+    vector<char *> vals;
+    split_line(line, vals);
+    if (line_no == 1) {
+      if (vals.size() != 1 || strcmp(vals[0], "ply") != 0) {
+        snprintf(errmsg, MSG_SZ, "line 1: not a PLY file");
+        break;
+      }
+    }
+    else if (!vals.size() || strcmp(vals[0], "comment") == 0 ||
+             strcmp(vals[0], "obj_info") == 0)
+      ; // ignore
+    else if (strcmp(vals[0], "format") == 0) {
+      if (vals.size() < 2 || (strcmp(vals[1], "ascii") != 0 &&
+                              strcmp(vals[1], "binary_little_endian") != 0 &&
+                              strcmp(vals[1], "binary_big_endian") != 0)) {
+        snprintf(errmsg, MSG_SZ, "line %d: unknown format '%s'", line_no,
+                 (vals.size() < 2) ? "" : vals[1]);
+        break;
+      }
+      format = vals[1];
+    }
+    else if (strcmp(vals[0], "element") == 0) {
+      PlyElem elem;
+      int count;
+      if (vals.size() != 3 || !read_int(vals[2], &count) || count < 0) {
+        snprintf(errmsg, MSG_SZ, "line %d: invalid element", line_no);
+        break;
+      }
+      elem.name = vals[1];
+      elem.count = count;
+      elems.push_back(elem);
+    }
+    else if (strcmp(vals[0], "property") == 0) {
+      PlyProp prop;
+      bool is_list = vals.size() > 1 && strcmp(vals[1], "list") == 0;
+      bool valid = elems.size() > 0 && vals.size() == (is_list ? 5u : 3u);
+      if (valid) {
+        prop.count_type = is_list ? ply_type(vals[2]) : PLY_NO_TYPE;
+        prop.type = ply_type(vals[is_list ? 3 : 1]);
+        prop.name = vals[is_list ? 4 : 2];
+        prop.use = ply_prop_use(elems.back().name, prop.name);
+        valid = prop.type != PLY_NO_TYPE &&
+                (!is_list || (prop.count_type != PLY_NO_TYPE &&
+                              prop.count_type < PLY_FLOAT32));
+        // a list must be the vertex indexes, and indexes must be a list
+        if (is_list != (prop.use == USE_IDXS))
+          prop.use = USE_NONE;
+      }
+      if (!valid) {
+        snprintf(errmsg, MSG_SZ, "line %d: invalid property", line_no);
+        break;
+      }
+      elems.back().props.push_back(prop);
+    }
+    else if (strcmp(vals[0], "end_header") == 0) {
+      header_ok = true;
+      break;
+    }
+    else {
+      snprintf(errmsg, MSG_SZ, "line %d: unknown header keyword '%s'",
+               line_no, vals[0]);
+      break;
+    }
+    free(line);
+    line = nullptr;
+  }
+  free(line);
+
+  if (header_ok && format == "") {
+    snprintf(errmsg, MSG_SZ, "header has no format");
+    header_ok = false;
+  }
+  else if (!header_ok && !*errmsg)
+    snprintf(errmsg, MSG_SZ, "header has no end_header");
+  return header_ok;
+}
+
+// Number of elements to reserve space for. The header count may be wrong,
+// so it is limited by the number of rows the file could hold or, if the
+// file size is not known, by a fixed number.
+long ply_reserve_count(FILE *ifile, const PlyElem &elem, bool ascii)
+{
+  long min_row_sz = 0; // an ASCII value has at least a digit and a space
+  for (const auto &prop : elem.props) {
+    int type = (prop.count_type != PLY_NO_TYPE) ? prop.count_type : prop.type;
+    min_row_sz += (ascii) ? 2 : ply_type_sizes[type];
+  }
+  long max_rows = 1 << 20;
+  struct stat st;
+  if (fstat(fileno(ifile), &st) == 0 && S_ISREG(st.st_mode))
+    max_rows = st.st_size / std::max(min_row_sz, 1L);
+  return std::min(elem.count, max_rows);
+}
+
+} // namespace
+
+bool ply_file_read(FILE *ifile, Geometry &geom, char *errmsg)
+{
+  ProfileScope prof("ply_file_read");
+  char errmsg2[MSG_SZ] = "";
+  if (errmsg)
+    *errmsg = '\0';
+
+  vector<PlyElem> elems;
+  string format;
+  if (!ply_header_read(ifile, elems, format, errmsg2)) {
+    if (errmsg)
+      strncpy(errmsg, errmsg2, MSG_SZ);
+    return false;
+  }
+
+  long num_verts = 0;
+  for (const auto &elem : elems)
+    if (elem.name == "vertex")
+      num_verts = elem.count;
+
+  const bool is_ascii = format == "ascii";
+  PlyReader rdr(ifile, is_ascii, format == "binary_big_endian");
+  for (const auto &elem : elems) {
+    const bool is_vert = elem.name == "vertex";
+    const bool is_face = elem.name == "face";
+    const bool is_edge = elem.name == "edge";
+    bool has_col = false;
+    bool col_is_float = false;
+    for (const auto &prop : elem.props)
+      if (prop.use >= USE_RED && prop.use <= USE_ALPHA) {
+        has_col = true;
+        col_is_float = prop.type >= PLY_FLOAT32;
+      }
+    if (is_vert)
+      geom.raw_verts().reserve(geom.verts().size() +
+                               ply_reserve_count(ifile, elem, is_ascii));
+    else if (is_face)
+      geom.raw_faces().reserve(geom.faces().size() +
+                               ply_reserve_count(ifile, elem, is_ascii));
+
+    PlyRow row;
+    for (long i = 0; i < elem.count; i++) {
+      row.col[3] = col_is_float ? 1.0 : 255;
+      Status stat = ply_row_read(rdr, elem, num_verts, row);
+      if (stat.is_error()) {
+        snprintf(errmsg2, MSG_SZ, "%s %ld: %s", elem.name.c_str(), i,
+                 stat.c_msg());
+        break;
+      }
+
+      Color c;
+      const double *col = row.col;
+      if (has_col)
+        c = col_is_float ? Color(col[0], col[1], col[2], col[3])
+                         : Color((int)col[0], (int)col[1], (int)col[2],
+                                 (int)col[3]);
+      if (is_vert)
+        geom.add_vert(row.v, c);
+      else if (is_face) {
+        // as in OFF files, small faces are vertex and edge elements
+        const vector<int> &face = row.face;
+        if (face.size() == 1) {
+          if (c.is_set())
+            geom.colors(VERTS).set(face[0], c);
+        }
+        else if (face.size() == 2)
+          geom.add_edge_raw(make_edge(face[0], face[1]), c);
+        else if (face.size() > 2)
+          geom.add_face(face, c);
+      }
+      else if (is_edge && row.edge[0] != row.edge[1])
+        geom.add_edge_raw(make_edge(row.edge[0], row.edge[1]), c);
+    }
+    if (*errmsg2)
+      break;
+  }
+
+  if (*errmsg2) {
+    if (errmsg)
+      strncpy(errmsg, errmsg2, MSG_SZ);
+    geom.clear_all();
+    return false;
+  }
+
+  if (errmsg && !geom.is_set())
+    strncpy(errmsg, "no vertices (empty geometry)", MSG_SZ);
+
+  profile_count("vertices read", geom.verts().size());
+  profile_count("faces read", geom.faces().size());
+  if (profiling_enabled())
+    profile_mem("Geometry (read)", geom.memory_usage());
+  return geom.is_set();
+}
@@ -0,0 +1,293 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/* \file ply_write.cc
+   \brief Write PLY files
+*/
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "private_off_file.h"
+#include "profile.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Write PLY body values, through a buffer
+class PlyWriter {
+private:
+  FILE *ofile;
+  bool ascii;
+  bool swap; // binary byte order is not the byte order of this machine
+  int sig_dgts;
+  bool elem_start; // no value has been added to the current element
+  string buf;
+  static const size_t buf_block_sz = 1 << 16; // write when this size
+
+  void add_bytes(const void *val, int sz)
+  {
+    size_t pos = buf.size();
+    buf.append((const char *)val, sz);
+    if (swap)
+      for (int i = 0; i < sz / 2; i++)
+        std::swap(buf[pos + i], buf[pos + sz - 1 - i]);
+  }
+
+  void add_sep()
+  {
+    if (!elem_start)
+      buf += ' ';
+    elem_start = false;
+  }
+
+public:
+  PlyWriter(FILE *file, bool is_ascii, bool big_endian, int dgts)
+      : ofile(file), ascii(is_ascii), sig_dgts(dgts), elem_start(true)
+  {
+    const uint16_t one = 1;
+    swap = (*(const unsigned char *)&one == 1) == big_endian;
+    buf.reserve(buf_block_sz + MSG_SZ);
+  }
+  ~PlyWriter() { flush(); }
+
+  void add(const Vec3d &v)
+  {
+    if (ascii) {
+      char str[MSG_SZ];
+      add_sep();
+      buf += vtostr(str, v, " ", sig_dgts);
+    }
+    else
+      for (int i = 0; i < 3; i++) {
+        const double crd = v[i];
+        add_bytes(&crd, sizeof(crd));
+      }
+  }
+
+  void add(int32_t val)
+  {
+    if (ascii) {
+      add_sep();
+      buf += itostr(val);
+    }
+    else
+      add_bytes(&val, sizeof(val));
+  }
+
+  void add(uint8_t val)
+  {
+    if (ascii) {
+      add_sep();
+      buf += itostr(val);
+    }
+    else
+      buf += (char)val;
+  }
+
+  // End an element, and write the buffer if it is large enough
+  void end_elem()
+  {
+    if (ascii)
+      buf += '\n';
+    elem_start = true;
+    if (buf.size() > buf_block_sz)
+      flush();
+  }
+
+  void flush()
+  {
+    fwrite(buf.data(), 1, buf.size(), ofile);
+    buf.clear();
+  }
+};
+
+// Colour to write, unset and index colours are written with the default
+// display colour for the element type
+Color ply_col(const Color &col, int type)
+{
+  if (col.is_value())
+    return col;
+  const Color def_cols[] = {Color(1.0, 0.5, 0.0), Color(0.8, 0.6, 0.8),
+                            Color(0.8, 0.9, 0.9)};
+  return def_cols[type];
+}
+
+// Find whether elements of a type have colours and transparency
+void ply_col_props(const Geometry &geom, int type, bool *has_col,
+                   bool *has_alpha)
+{
+  const auto &cols = geom.colors(type).get_properties();
+  *has_col = cols.size() > 0;
+  *has_alpha = false;
+  for (const auto &kp : cols)
+    if (kp.second.is_value() && kp.second[3] < 255)
+      *has_alpha = true;
+}
+
+void ply_col_header(FILE *ofile, bool has_col, bool has_alpha)
+{
+  if (has_col)
+    fprintf(ofile, "property uchar red\n"
+                   "property uchar green\n"
+                   "property uchar blue\n");
+  if (has_alpha)
+    fprintf(ofile, "property uchar alpha\n");
+}
+
+void ply_col_write(PlyWriter &wrtr, const Color &col, bool has_alpha)
+{
+  for (int i = 0; i < 3 + has_alpha; i++)
+    wrtr.add((uint8_t)col[i]);
+}
+
+} // namespace
+
+bool ply_has_index_cols(const Geometry &geom)
+{
+  for (int type = 0; type < 3; type++)
+    for (const auto &kp : geom.colors(type).get_properties())
+      if (kp.second.is_index())
+        return true;
+  return false;
+}
+
+bool is_ply_file_name(const string &file_name)
+{
+  size_t len = file_name.size();
+  return len > 4 && file_name[len - 4] == '.' &&
+         tolower(file_name[len - 3]) == 'p' &&
+         tolower(file_name[len - 2]) == 'l' &&
+         tolower(file_name[len - 1]) == 'y';
+}
+
+bool ply_file_write(string file_name, const Geometry &geom, char *errmsg,
+                    const char *format, int sig_dgts)
+{
+  if (errmsg)
+    *errmsg = '\0';
+  FILE *ofile = file_open_w(file_name, errmsg,
+                            (strcmp(format, "ascii") == 0) ? "w" : "wb");
+  if (!ofile)
+    return false;
+
+  ply_file_write(ofile, geom, format, sig_dgts);
+  bool write_err = ferror(ofile);
+  if (ofile != stdout)
+    write_err = (fclose(ofile) != 0) || write_err;
+  else
+    write_err = (fflush(ofile) != 0) || write_err;
+  if (write_err) {
+    if (errmsg)
+      snprintf(errmsg, MSG_SZ, "could not write output file '%s'",
+               (file_name != "") ? file_name.c_str() : "stdout");
+    return false;
+  }
+
+  if (errmsg && ply_has_index_cols(geom))
+    strncpy(errmsg,
+            "PLY files cannot hold index colours, these were written "
+            "with the default colour for the element type",
+            MSG_SZ);
+  return true;
+}
+
+void ply_file_write(FILE *ofile, const Geometry &geom, const char *format,
+                    int sig_dgts)
+{
+  ProfileScope prof("ply_file_write");
+  if (profiling_enabled())
+    profile_mem("Geometry (written)", geom.memory_usage());
+
+  bool has_col[3], has_alpha[3];
+  for (int type = 0; type < 3; type++)
+    ply_col_props(geom, type, &has_col[type], &has_alpha[type]);
+
+  // a face size count must hold the largest face size
+  unsigned int max_face_sz = 0;
+  for (const auto &face : geom.faces())
+    max_face_sz = std::max(max_face_sz, (unsigned int)face.size());
+  bool count_is_int = max_face_sz > 255;
+
+  fprintf(ofile, "ply\nformat %s 1.0\n", format);
+  fprintf(ofile, "comment Antiprism - http://www.antiprism.com\n");
+  fprintf(ofile, "element vertex %lu\n", (unsigned long)geom.verts().size());
+  fprintf(ofile, "property double x\n"
+                 "property double y\n"
+                 "property double z\n");
+  ply_col_header(ofile, has_col[VERTS], has_alpha[VERTS]);
+  fprintf(ofile, "element face %lu\n", (unsigned long)geom.faces().size());
+  fprintf(ofile, "property list %s int vertex_indices\n",
+          count_is_int ? "int" : "uchar");
+  ply_col_header(ofile, has_col[FACES], has_alpha[FACES]);
+  if (geom.edges().size()) {
+    fprintf(ofile, "element edge %lu\n", (unsigned long)geom.edges().size());
+    fprintf(ofile, "property int vertex1\n"
+                   "property int vertex2\n");
+    ply_col_header(ofile, has_col[EDGES], has_alpha[EDGES]);
+  }
+  fprintf(ofile, "end_header\n");
+
+  PlyWriter wrtr(ofile, strcmp(format, "ascii") == 0,
+                 strcmp(format, "binary_big_endian") == 0, sig_dgts);
+  for (unsigned int i = 0; i < geom.verts().size(); i++) {
+    wrtr.add(geom.verts(i));
+    if (has_col[VERTS])
+      ply_col_write(wrtr, ply_col(geom.colors(VERTS).get(i), VERTS),
+                    has_alpha[VERTS]);
+    wrtr.end_elem();
+  }
+
+  for (unsigned int i = 0; i < geom.faces().size(); i++) {
+    const vector<int> &face = geom.faces(i);
+    if (count_is_int)
+      wrtr.add((int32_t)face.size());
+    else
+      wrtr.add((uint8_t)face.size());
+    for (int v_idx : face)
+      wrtr.add((int32_t)v_idx);
+    if (has_col[FACES])
+      ply_col_write(wrtr, ply_col(geom.colors(FACES).get(i), FACES),
+                    has_alpha[FACES]);
+    wrtr.end_elem();
+  }
+
+  for (unsigned int i = 0; i < geom.edges().size(); i++) {
+    wrtr.add((int32_t)geom.edges(i, 0));
+    wrtr.add((int32_t)geom.edges(i, 1));
+    if (has_col[EDGES])
+      ply_col_write(wrtr, ply_col(geom.colors(EDGES).get(i), EDGES),
+                    has_alpha[EDGES]);
+    wrtr.end_elem();
+  }
+}
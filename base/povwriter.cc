@@ -32,6 +32,7 @@
 #include "displaypoly.h"
 #include "mathutils.h"
 #include "povwriter.h"
+#include "profile.h"
 
 using std::string;
 using std::vector;
@@ -74,6 +75,7 @@ string pov_col(const Color &col)
 
 void PovWriter::write(FILE *ofile, const Scene &scen, int sig_dgts)
 {
+  ProfileScope prof("pov_write");
   if (o_type != 'o') {
     scene_header(ofile, scen);
     cameras(ofile, scen);
@@ -32,6 +32,7 @@
 #define GEODESIC_H
 
 #include <map>
+#include <stdio.h>
 #include <string>
 #include <vector>
 
@@ -77,9 +78,15 @@ private:
   anti::Vec3d centre;
 
   std::map<std::vector<int>, int> edge_idx;
-  std::map<std::vector<int>, std::vector<int>> edge_faces;
-  // std::map<std::vector<int>, int> face_idx;
-  std::map<int_pr, int> grid_idxs;
+  // per base face: vertex, edge and face index numbers (see make_face_indexes)
+  std::vector<std::vector<int>> face_indxs;
+  // per base face: neighbouring face across sides v0v1, v1v2, v2v0, or -1
+  std::vector<std::vector<int>> face_nbrs;
+  // per base edge: the face that sets the edge points (last face with edge)
+  std::vector<int> edge_owner;
+  // grid position (i, j) to face interior point number, or noindex
+  std::vector<int> grid_idxs;
+  int grid_sz;
 
   void init();
   void sphere_projection(anti::Geometry &geom);
@@ -105,17 +112,21 @@ private:
     return ((m + n) * crds.first + m * crds.second) / (m * m + m * n + n * n);
   }
 
-  void grid_to_points(std::vector<int> indx, std::vector<anti::Vec3d> &gverts);
+  int num_geo_verts() const;
+  void grid_to_points(const std::vector<int> &indx,
+                      std::vector<anti::Vec3d> &gverts);
   bool tri_test(int i, int j, int di, int dj);
-  void grid_to_tris(std::vector<int> indx,
-                    std::vector<std::vector<int>> &new_tris,
-                    std::vector<std::vector<int>> &orig_edges);
+  int grid_to_tris(const std::vector<int> &indx, int *tris,
+                   std::vector<std::vector<int>> *orig_edges);
   std::vector<int> make_face_indexes(int i, const std::vector<int> &face);
   int index_map(int i, int j, const std::vector<int> &indx,
                 int p_idx = noindex);
 
   int get_edge_index(int v0, int v1);
-  std::vector<int> get_face_indexes(std::vector<int> face);
+  void make_points(std::vector<anti::Vec3d> &gverts);
+  void make_orig_edges(const std::vector<std::vector<std::vector<int>>> &oes,
+                       std::vector<std::vector<int>> &edges,
+                       std::vector<anti::Color> &cols);
 
   IJPos get_pos_xy(int x, int y)
   {
@@ -131,6 +142,7 @@ public:
   Geodesic(const anti::Geometry &base_poly, int mm, int nn = 0, char mthd = 's',
            anti::Vec3d cen = anti::Vec3d(0, 0, 0));
   void make_geo(anti::Geometry &geo);
+  void write_off(FILE *ofile, int sig_dgts);
 };
 
 #endif // GEODESIC_H
@@ -73,6 +73,11 @@ Status get_delaunay_edges(const Geometry &geom,
                           std::map<std::pair<int, int>, int> &edges,
                           std::string qh_args);
 
+/// Get the minimum distance between vertices
+/**\param verts the vertices.
+ * \param sig_dist only consider distances of at least this value.
+ * \return The minimum distance, or \a sig_dist if there are no pairs of
+ *  vertices this far apart. */
 double get_min_vert_to_vert_dist(const std::vector<Vec3d> &verts,
                                  double sig_dist);
 
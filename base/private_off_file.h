@@ -23,7 +23,7 @@
 */
 
 /* !\file private_off_file.h
-   \brief Read and write OFF and coordinate files
+   \brief Read and write OFF, PLY and coordinate files
 */
 
 #ifndef PRIVATE_OFF_FILE_H
@@ -36,6 +36,10 @@ using namespace anti;
 
 int read_off_line(FILE *fp, char **line);
 
+FILE *file_open_w(std::string file_name, char *errmsg,
+                  const char *mode = "w");
+void file_close_w(FILE *ofile);
+
 bool crds_file_read(std::string file_name, anti::Geometry &geom,
                     char *errmsg = nullptr);
 void crds_file_read(FILE *ifile, anti::Geometry &geom,
@@ -58,6 +62,8 @@ bool off_file_read(std::string file_name, anti::Geometry &geom,
                    char *errmsg = nullptr);
 bool off_file_read(FILE *ifile, anti::Geometry &geom, char *errmsg = nullptr);
 
+char *off_col(char *str, anti::Color col);
+
 bool off_file_write(std::string file_name, const anti::Geometry &geom,
                     char *errmsg = nullptr, int sig_dgts = DEF_SIG_DGTS);
 void off_file_write(FILE *ofile, const anti::Geometry &geom,
@@ -70,4 +76,16 @@ void off_file_write(FILE *ofile,
                     const std::vector<const anti::Geometry *> &geoms,
                     int sig_dgts = DEF_SIG_DGTS);
 
+bool ply_file_read(FILE *ifile, anti::Geometry &geom, char *errmsg = nullptr);
+
+bool is_ply_file_name(const std::string &file_name);
+bool ply_has_index_cols(const anti::Geometry &geom);
+bool ply_file_write(std::string file_name, const anti::Geometry &geom,
+                    char *errmsg = nullptr,
+                    const char *format = "binary_little_endian",
+                    int sig_dgts = DEF_SIG_DGTS);
+void ply_file_write(FILE *ofile, const anti::Geometry &geom,
+                    const char *format = "binary_little_endian",
+                    int sig_dgts = DEF_SIG_DGTS);
+
 #endif // PRIVATE_OFF_FILE_H
@@ -0,0 +1,229 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/**\file profile.cc
+   \brief Timing, counting and memory use of program phases
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#endif
+
+#include "profile.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(HAVE_GETRUSAGE) && defined(HAVE_SYS_RESOURCE_H)
+#include <sys/resource.h>
+#endif
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace anti {
+
+std::atomic<bool> profile_on(false);
+
+namespace {
+
+struct PhaseStats {
+  long calls = 0;
+  double secs = 0.0;
+  long peak_rss = -1;   // peak memory use when the phase last ended
+  long peak_growth = 0; // largest increase in peak memory use in a call
+};
+
+// Phases, counters and object sizes, with their names in the order first
+// recorded
+struct ProfileData {
+  std::mutex mtx;
+  std::chrono::steady_clock::time_point start;
+  map<string, PhaseStats> phases;
+  vector<string> phase_names;
+  map<string, long> counts;
+  vector<string> count_names;
+  map<string, size_t> mems;
+  vector<string> mem_names;
+};
+
+ProfileData &profile_data()
+{
+  static ProfileData *data = new ProfileData; // used until exit
+  return *data;
+}
+
+} // namespace
+
+void set_profiling(bool enable)
+{
+  ProfileData &data = profile_data();
+  std::lock_guard<std::mutex> lock(data.mtx);
+  if (enable && !profile_on)
+    data.start = std::chrono::steady_clock::now();
+  profile_on = enable;
+}
+
+long get_peak_rss()
+{
+#if defined(HAVE_GETRUSAGE) && defined(HAVE_SYS_RESOURCE_H)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes to kilobytes
+#else
+    return usage.ru_maxrss; // kilobytes
+#endif
+  }
+#endif
+  return -1;
+}
+
+void profile_add_time(const char *phase, double secs, long start_rss)
+{
+  long peak_rss = get_peak_rss();
+  ProfileData &data = profile_data();
+  std::lock_guard<std::mutex> lock(data.mtx);
+  auto ins = data.phases.insert(std::make_pair(string(phase), PhaseStats()));
+  if (ins.second)
+    data.phase_names.push_back(phase);
+  PhaseStats &stats = ins.first->second;
+  stats.calls++;
+  stats.secs += secs;
+  stats.peak_rss = peak_rss;
+  if (start_rss >= 0 && peak_rss - start_rss > stats.peak_growth)
+    stats.peak_growth = peak_rss - start_rss;
+}
+
+void profile_count(const char *name, long inc)
+{
+  if (!profiling_enabled())
+    return;
+  ProfileData &data = profile_data();
+  std::lock_guard<std::mutex> lock(data.mtx);
+  auto ins = data.counts.insert(std::make_pair(string(name), 0L));
+  if (ins.second)
+    data.count_names.push_back(name);
+  ins.first->second += inc;
+}
+
+void profile_mem(const char *name, size_t bytes)
+{
+  if (!profiling_enabled())
+    return;
+  ProfileData &data = profile_data();
+  std::lock_guard<std::mutex> lock(data.mtx);
+  auto ins = data.mems.insert(std::make_pair(string(name), bytes));
+  if (ins.second)
+    data.mem_names.push_back(name);
+  else if (bytes > ins.first->second)
+    ins.first->second = bytes;
+}
+
+void profile_report(FILE *ofile, bool json)
+{
+  ProfileData &data = profile_data();
+  std::lock_guard<std::mutex> lock(data.mtx);
+  std::chrono::duration<double> wall =
+      std::chrono::steady_clock::now() - data.start;
+  long peak_rss = get_peak_rss();
+
+  if (json) {
+    fprintf(ofile, "{\"wall_ms\":%.3f,\"peak_rss_kb\":%ld,\"phases\":[",
+            wall.count() * 1000, peak_rss);
+    for (size_t i = 0; i < data.phase_names.size(); i++) {
+      const PhaseStats &stats = data.phases[data.phase_names[i]];
+      fprintf(ofile,
+              "%s{\"name\":\"%s\",\"calls\":%ld,\"total_ms\":%.3f,"
+              "\"peak_rss_kb\":%ld}",
+              (i) ? "," : "", data.phase_names[i].c_str(), stats.calls,
+              stats.secs * 1000, stats.peak_rss);
+    }
+    fprintf(ofile, "],\"counters\":{");
+    for (size_t i = 0; i < data.count_names.size(); i++)
+      fprintf(ofile, "%s\"%s\":%ld", (i) ? "," : "",
+              data.count_names[i].c_str(), data.counts[data.count_names[i]]);
+    fprintf(ofile, "}}\n");
+    return;
+  }
+
+  fprintf(ofile, "profile: %-28s %8s %12s %12s %12s\n", "phase", "calls",
+          "total(ms)", "mean(ms)", "peak RSS(kB)");
+  for (const auto &name : data.phase_names) {
+    const PhaseStats &stats = data.phases[name];
+    fprintf(ofile, "profile: %-28s %8ld %12.3f %12.3f %12ld\n", name.c_str(),
+            stats.calls, stats.secs * 1000, stats.secs * 1000 / stats.calls,
+            stats.peak_rss);
+  }
+  for (const auto &name : data.count_names)
+    fprintf(ofile, "profile: %-28s %8ld\n", name.c_str(), data.counts[name]);
+  fprintf(ofile, "profile: %-28s %8s %12.3f %12s %12ld\n", "total (wall)", "",
+          wall.count() * 1000, "", peak_rss);
+}
+
+void mem_report(FILE *ofile, bool json)
+{
+  ProfileData &data = profile_data();
+  std::lock_guard<std::mutex> lock(data.mtx);
+  long peak_rss = get_peak_rss();
+
+  if (json) {
+    fprintf(ofile, "{\"peak_rss_kb\":%ld,\"objects\":[", peak_rss);
+    for (size_t i = 0; i < data.mem_names.size(); i++)
+      fprintf(ofile, "%s{\"name\":\"%s\",\"max_kb\":%.1f}", (i) ? "," : "",
+              data.mem_names[i].c_str(),
+              data.mems[data.mem_names[i]] / 1024.0);
+    fprintf(ofile, "],\"phases\":[");
+    for (size_t i = 0; i < data.phase_names.size(); i++) {
+      const PhaseStats &stats = data.phases[data.phase_names[i]];
+      fprintf(ofile,
+              "%s{\"name\":\"%s\",\"calls\":%ld,\"peak_growth_kb\":%ld,"
+              "\"peak_rss_kb\":%ld}",
+              (i) ? "," : "", data.phase_names[i].c_str(), stats.calls,
+              stats.peak_growth, stats.peak_rss);
+    }
+    fprintf(ofile, "]}\n");
+    return;
+  }
+
+  fprintf(ofile, "memory: %-29s %12s\n", "object", "max size(kB)");
+  for (const auto &name : data.mem_names)
+    fprintf(ofile, "memory: %-29s %12.1f\n", name.c_str(),
+            data.mems[name] / 1024.0);
+  fprintf(ofile, "memory: %-29s %8s %12s %12s\n", "phase", "calls",
+          "growth(kB)", "peak RSS(kB)");
+  for (const auto &name : data.phase_names) {
+    const PhaseStats &stats = data.phases[name];
+    fprintf(ofile, "memory: %-29s %8ld %12ld %12ld\n", name.c_str(),
+            stats.calls, stats.peak_growth, stats.peak_rss);
+  }
+  fprintf(ofile, "memory: %-29s %8s %12s %12ld\n", "total (peak RSS)", "", "",
+          peak_rss);
+}
+
+} // namespace anti
@@ -0,0 +1,214 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+
+/**\file profile.h
+   \brief Timing, counting and memory use of program phases
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace anti {
+
+/// Whether profiling is enabled, use profiling_enabled() to check it
+extern std::atomic<bool> profile_on;
+
+/// Enable or disable profiling
+/** Phase times, counts and memory use are only recorded while profiling is
+ *  enabled.
+ * \param enable \c true to enable profiling, \c false to disable it. */
+void set_profiling(bool enable);
+
+/// Check whether profiling is enabled
+/**\return \c true if profiling is enabled, otherwise \c false. */
+inline bool profiling_enabled()
+{
+  return profile_on.load(std::memory_order_relaxed);
+}
+
+/// Add a time to a phase
+/** Used by ProfileScope, this also counts a call of the phase and records
+ *  the peak memory use so far, and how much it increased during the call.
+ * \param phase the name of the phase.
+ * \param secs the time, in seconds.
+ * \param start_rss the peak memory use at the start of the call, in
+ *  kilobytes, or -1 if not known. */
+void profile_add_time(const char *phase, double secs, long start_rss = -1);
+
+/// Add to a counter
+/** Does nothing if profiling is not enabled.
+ * \param name the name of the counter.
+ * \param inc the amount to add. */
+void profile_count(const char *name, long inc = 1);
+
+/// Record the memory used by an object
+/** The largest size recorded for each name is kept. Does nothing if
+ *  profiling is not enabled, but finding the size may be slow, so check
+ *  profiling_enabled() first.
+ * \param name the name of the object.
+ * \param bytes the memory used, in bytes. */
+void profile_mem(const char *name, size_t bytes);
+
+/// Get the peak memory use of the program
+/**\return The peak resident set size, in kilobytes, or -1 if it is not
+ *  available. */
+long get_peak_rss();
+
+/// Time a phase for the life of the object
+/** Declare an object at the start of a block to time the block as a phase.
+ *  If profiling is not enabled nothing is recorded. Times of nested phases
+ *  are included in the time of the enclosing phase. */
+class ProfileScope {
+private:
+  const char *phase;
+  std::chrono::steady_clock::time_point start;
+  long start_rss;
+
+public:
+  /// Constructor
+  /**\param phase_name the name of the phase, which must not be freed
+   *  while the object exists. */
+  ProfileScope(const char *phase_name)
+      : phase(profiling_enabled() ? phase_name : nullptr), start_rss(-1)
+  {
+    if (phase) {
+      start_rss = get_peak_rss();
+      start = std::chrono::steady_clock::now();
+    }
+  }
+
+  /// Destructor, adds the time to the phase
+  ~ProfileScope()
+  {
+    if (phase) {
+      std::chrono::duration<double> secs =
+          std::chrono::steady_clock::now() - start;
+      profile_add_time(phase, secs.count(), start_rss);
+    }
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+/// Print the phase times and counters
+/** Phases and counters are listed in the order they were first recorded.
+ *  The time is the wall time since profiling was enabled.
+ * \param ofile file to write to.
+ * \param json \c true to write a JSON object, \c false to write a table. */
+void profile_report(FILE *ofile, bool json = false);
+
+/// Print the memory use of objects and phases
+/** Lists the largest size recorded for each object, the largest increase
+ *  in peak memory use during a call of each phase, and the peak memory use
+ *  of the program.
+ * \param ofile file to write to.
+ * \param json \c true to write a JSON object, \c false to write a table. */
+void mem_report(FILE *ofile, bool json = false);
+
+/// Size of the nodes of a set or map, in addition to the element
+const size_t tree_node_overhead = 4 * sizeof(void *);
+
+// Estimates for the heap memory used by containers, declared first so that
+// containers of containers are estimated
+template <class T> size_t heap_memory(const T &);
+inline size_t heap_memory(const std::string &str);
+template <class T1, class T2> size_t heap_memory(const std::pair<T1, T2> &pr);
+template <class T, class A> size_t heap_memory(const std::vector<T, A> &vec);
+template <class K, class C, class A>
+size_t heap_memory(const std::set<K, C, A> &st);
+template <class K, class V, class C, class A>
+size_t heap_memory(const std::map<K, V, C, A> &mp);
+
+/// Estimate the heap memory used by a value
+/** Values which are not containers are taken to use no heap memory. The
+ *  estimate for a container includes the memory used by its elements.
+ * \return The estimated heap memory, in bytes. */
+template <class T> size_t heap_memory(const T &) { return 0; }
+
+/// Estimate the heap memory used by a string
+/**\param str the string.
+ * \return The estimated heap memory, in bytes. */
+inline size_t heap_memory(const std::string &str)
+{
+  // short strings are held in the object
+  return (str.capacity() > 15) ? str.capacity() + 1 : 0;
+}
+
+/// Estimate the heap memory used by a pair
+/**\param pr the pair.
+ * \return The estimated heap memory, in bytes. */
+template <class T1, class T2> size_t heap_memory(const std::pair<T1, T2> &pr)
+{
+  return heap_memory(pr.first) + heap_memory(pr.second);
+}
+
+/// Estimate the heap memory used by a vector
+/**\param vec the vector.
+ * \return The estimated heap memory, in bytes. */
+template <class T, class A> size_t heap_memory(const std::vector<T, A> &vec)
+{
+  size_t bytes = vec.capacity() * sizeof(T);
+  for (const auto &elem : vec)
+    bytes += heap_memory(elem);
+  return bytes;
+}
+
+/// Estimate the heap memory used by a set
+/**\param st the set.
+ * \return The estimated heap memory, in bytes. */
+template <class K, class C, class A>
+size_t heap_memory(const std::set<K, C, A> &st)
+{
+  size_t bytes = st.size() * (sizeof(K) + tree_node_overhead);
+  for (const auto &elem : st)
+    bytes += heap_memory(elem);
+  return bytes;
+}
+
+/// Estimate the heap memory used by a map
+/**\param mp the map.
+ * \return The estimated heap memory, in bytes. */
+template <class K, class V, class C, class A>
+size_t heap_memory(const std::map<K, V, C, A> &mp)
+{
+  size_t bytes =
+      mp.size() * (sizeof(std::pair<const K, V>) + tree_node_overhead);
+  for (const auto &elem : mp)
+    bytes += heap_memory(elem.first) + heap_memory(elem.second);
+  return bytes;
+}
+
+} // namespace anti
+
+#endif // PROFILE_H
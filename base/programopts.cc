@@ -31,6 +31,8 @@
 #endif
 
 #include "programopts.h"
+#include "parallel.h"
+#include "profile.h"
 #include "utils.h"
 #include <map>
 #include <string.h>
@@ -42,7 +44,17 @@ namespace anti {
 
 const char *ProgramOpts::help_ver_text =
     "  -h,--help this help message (run 'off_util -H help' for general help)\n"
-    "  --version version information\n";
+    "  --version version information\n"
+    "  -j <num>  number of threads for parallel operations (default: value\n"
+    "            of ANTIPRISM_THREADS, or the number of hardware threads)\n"
+    "  --profile[=json] print the time taken by each phase to standard error\n"
+    "  --mem-report[=json] print the memory used to standard error\n";
+
+const char *ProgramOpts::help_ver_no_threads_text =
+    "  -h,--help this help message (run 'off_util -H help' for general help)\n"
+    "  --version version information\n"
+    "  --profile[=json] print the time taken by each phase to standard error\n"
+    "  --mem-report[=json] print the memory used to standard error\n";
 
 const char *ProgramOpts::prog_name() const { return program_name.c_str(); }
 
@@ -131,11 +143,77 @@ void ProgramOpts::handle_long_opts(int argc, char *argv[])
       version();
       exit(0);
     }
+    else if (strcmp(argv[i], "--profile") == 0 ||
+             strncmp(argv[i], "--profile=", 10) == 0 ||
+             strcmp(argv[i], "--mem-report") == 0 ||
+             strncmp(argv[i], "--mem-report=", 13) == 0)
+      continue; // processed with the short options
     else if (strncmp(argv[i], "--", 2) == 0 && strlen(argv[i]) > 2)
       error("unknown option", argv[i]);
   }
 }
 
+// Values returned by getopt for --profile and --mem-report
+static const int profile_opt = 256;
+static const int mem_report_opt = 257;
+
+static bool profile_requested = false;
+static bool profile_json = false;
+static bool mem_report_requested = false;
+static bool mem_report_json = false;
+
+static void print_profile() { profile_report(stderr, profile_json); }
+
+static void print_mem_report() { mem_report(stderr, mem_report_json); }
+
+int ProgramOpts::ultragetopt(int argc, char *const argv[],
+                             const char *optstring)
+{
+  static const struct option long_opts[] = {
+      {"profile", optional_argument, nullptr, profile_opt},
+      {"mem-report", optional_argument, nullptr, mem_report_opt},
+      {nullptr, 0, nullptr, 0}};
+
+  bool use_j = !strchr(optstring, 'j');
+  string opts = string(optstring) + (use_j ? "j:" : "");
+  int c;
+  while (true) {
+    int long_idx;
+    c = GetOpt::ultragetopt_long(argc, argv, opts.c_str(), long_opts,
+                                 &long_idx);
+    if (c == 'j' && use_j) {
+      int num_threads;
+      print_status_or_exit(read_int(optarg, &num_threads), c);
+      if (num_threads < 0)
+        error("number of threads cannot be negative", c);
+      set_num_threads(num_threads);
+    }
+    else if (c == profile_opt || c == mem_report_opt) {
+      string arg = (optarg) ? optarg : "";
+      if (arg != "" && arg != "text" && arg != "json")
+        error(msg_str("invalid report format '%s' (use text or json)",
+                      arg.c_str()),
+              string("option --") + long_opts[long_idx].name);
+      if (c == profile_opt) {
+        if (!profile_requested)
+          atexit(print_profile);
+        profile_requested = true;
+        profile_json = (arg == "json");
+      }
+      else {
+        if (!mem_report_requested)
+          atexit(print_mem_report);
+        mem_report_requested = true;
+        mem_report_json = (arg == "json");
+      }
+      set_profiling(true);
+    }
+    else
+      break;
+  }
+  return c;
+}
+
 Status ProgramOpts::get_arg_id(const char *arg, string *arg_id,
                                const char *maps, unsigned int match_flags)
 {
@@ -49,7 +49,10 @@ public:
     argmatch_add_id_maps = 4
   };
 
+  /// Help text for the common options, -h, --version and -j
   static const char *help_ver_text;
+  /// Help text for the common options, for a program which uses -j itself
+  static const char *help_ver_no_threads_text;
 
   /// Constructor
   /**\param prog_name the name of the program. */
@@ -140,6 +143,20 @@ public:
    * \return whether the option was handled. */
   bool common_opts(char c, char opt);
 
+  /// Get the next option
+  /** As GetOpt::ultragetopt(), which getopt() refers to. Unless the program
+   *  uses option letter \c j itself, option \c -j is also accepted, and it
+   *  sets the number of threads for parallel operations (0 for the
+   *  default, see get_num_threads()). Options \c --profile and
+   *  \c --mem-report, with an optional format \c text or \c json, enable
+   *  profiling and print a report of the phase times (see profile_report())
+   *  or the memory used (see mem_report()) to standard error at exit.
+   * \param argc the number of arguments.
+   * \param argv pointers to the argument strings.
+   * \param optstring the option letters.
+   * \return The option letter found, as for GetOpt::ultragetopt(). */
+  int ultragetopt(int argc, char *const argv[], const char *optstring);
+
   /// Map option arguments to identifiers using matching
   /**\param arg the option argument
    * \param arg_id identifier corresponding to the matched string, or
@@ -0,0 +1,851 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/**\file rasterwriter.cc
+   \brief render a scene to an image, and write PNG and PPM files
+*/
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include "displaypoly.h"
+#include "mathutils.h"
+#include "parallel.h"
+#include "profile.h"
+#include "rasterwriter.h"
+#include "trans3d.h"
+#include "vec_utils.h"
+
+using std::string;
+using std::vector;
+
+namespace anti {
+
+void RasterImage::resize(int wdth, int hgt)
+{
+  width = std::max(wdth, 0);
+  height = std::max(hgt, 0);
+  pixels.assign(3 * (size_t)width * height, 0);
+}
+
+void RasterImage::shrink(int factor)
+{
+  if (factor < 2)
+    return;
+  int wdth = width / factor;
+  int hgt = height / factor;
+  int num = factor * factor;
+  vector<unsigned char> pix(3 * (size_t)wdth * hgt);
+  for (int y = 0; y < hgt; y++)
+    for (int x = 0; x < wdth; x++)
+      for (int c = 0; c < 3; c++) {
+        int sum = 0;
+        for (int j = 0; j < factor; j++)
+          for (int i = 0; i < factor; i++)
+            sum += pixel(x * factor + i, y * factor + j)[c];
+        pix[3 * ((size_t)y * wdth + x) + c] = (sum + num / 2) / num;
+      }
+  width = wdth;
+  height = hgt;
+  pixels.swap(pix);
+}
+
+Status RasterImage::write_ppm(FILE *ofile) const
+{
+  fprintf(ofile, "P6\n%d %d\n255\n", width, height);
+  if (fwrite(pixels.data(), 1, pixels.size(), ofile) != pixels.size())
+    return Status::error("could not write image");
+  return Status::ok();
+}
+
+// --------------------------------------------------------------
+// PNG
+
+namespace {
+
+// Writes bits to a byte vector, least significant bit first
+class BitWriter {
+private:
+  vector<unsigned char> &out;
+  unsigned long buf;
+  int cnt;
+
+public:
+  BitWriter(vector<unsigned char> &bytes) : out(bytes), buf(0), cnt(0) {}
+
+  void put(unsigned int bits, int num)
+  {
+    buf |= (unsigned long)bits << cnt;
+    cnt += num;
+    while (cnt >= 8) {
+      out.push_back(buf & 0xff);
+      buf >>= 8;
+      cnt -= 8;
+    }
+  }
+
+  // Huffman codes are written most significant bit first
+  void put_code(unsigned int code, int len)
+  {
+    unsigned int rev = 0;
+    for (int i = 0; i < len; i++)
+      rev |= ((code >> i) & 1) << (len - 1 - i);
+    put(rev, len);
+  }
+
+  void flush()
+  {
+    if (cnt)
+      out.push_back(buf & 0xff);
+    buf = 0;
+    cnt = 0;
+  }
+};
+
+} // namespace
+
+// Literal or length symbol, with the fixed Huffman codes
+static void put_lit_len(BitWriter &bits, int sym)
+{
+  if (sym < 144)
+    bits.put_code(0x30 + sym, 8);
+  else if (sym < 256)
+    bits.put_code(0x190 + sym - 144, 9);
+  else if (sym < 280)
+    bits.put_code(sym - 256, 7);
+  else
+    bits.put_code(0xc0 + sym - 280, 8);
+}
+
+static void put_match(BitWriter &bits, int len, int dist)
+{
+  static const int len_base[] = {3,  4,  5,  6,   7,   8,   9,   10,  11, 13,
+                                 15, 17, 19, 23,  27,  31,  35,  43,  51, 59,
+                                 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  static const int len_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                  1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                  4, 4, 4, 4, 5, 5, 5, 5, 0};
+  static const int dist_base[] = {
+      1,    2,    3,    4,    5,    7,     9,     13,    17,    25,
+      33,   49,   65,   97,   129,  193,   257,   385,   513,   769,
+      1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+  static const int dist_extra[] = {0, 0, 0,  0,  1,  1,  2,  2,  3,  3,
+                                   4, 4, 5,  5,  6,  6,  7,  7,  8,  8,
+                                   9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+  int l = 28;
+  while (len_base[l] > len)
+    l--;
+  put_lit_len(bits, 257 + l);
+  bits.put(len - len_base[l], len_extra[l]);
+
+  int d = 29;
+  while (dist_base[d] > dist)
+    d--;
+  bits.put_code(d, 5);
+  bits.put(dist - dist_base[d], dist_extra[d]);
+}
+
+// Compress in zlib format, as a single deflate block with the fixed
+// Huffman codes, and matches found with a hash chain
+static void zlib_compress(const vector<unsigned char> &data,
+                          vector<unsigned char> &out)
+{
+  const int win_sz = 32768;
+  const int hash_bits = 15;
+  const int max_chain = 32;
+  const int max_match = 258;
+
+  out.push_back(0x78); // zlib header
+  out.push_back(0x01);
+
+  BitWriter bits(out);
+  bits.put(1, 1); // final block
+  bits.put(1, 2); // fixed Huffman codes
+
+  const long sz = data.size();
+  vector<long> head(1 << hash_bits, -1);
+  vector<long> prev(win_sz, -1);
+  auto insert = [&](long pos) {
+    if (pos + 2 < sz) {
+      int hash = ((data[pos] << 10) ^ (data[pos + 1] << 5) ^ data[pos + 2]) &
+                 ((1 << hash_bits) - 1);
+      prev[pos % win_sz] = head[hash];
+      head[hash] = pos;
+    }
+  };
+
+  long i = 0;
+  while (i < sz) {
+    int best_len = 0;
+    long best_dist = 0;
+    if (i + 2 < sz) {
+      int hash = ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) &
+                 ((1 << hash_bits) - 1);
+      long max_len = std::min(long(max_match), sz - i);
+      long pos = head[hash];
+      for (int chain = 0; chain < max_chain && pos >= 0 && i - pos <= win_sz;
+           chain++) {
+        int len = 0;
+        while (len < max_len && data[pos + len] == data[i + len])
+          len++;
+        if (len > best_len) {
+          best_len = len;
+          best_dist = i - pos;
+          if (len == max_len)
+            break;
+        }
+        long next = prev[pos % win_sz];
+        if (next >= pos) // overwritten by a later position
+          break;
+        pos = next;
+      }
+    }
+
+    if (best_len >= 3) {
+      put_match(bits, best_len, best_dist);
+      for (int j = 0; j < best_len; j++)
+        insert(i + j);
+      i += best_len;
+    }
+    else {
+      put_lit_len(bits, data[i]);
+      insert(i);
+      i++;
+    }
+  }
+  put_lit_len(bits, 256); // end of block
+  bits.flush();
+
+  unsigned long a = 1, b = 0;
+  for (unsigned char byte : data) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  unsigned long adler = (b << 16) | a;
+  for (int s = 24; s >= 0; s -= 8)
+    out.push_back((adler >> s) & 0xff);
+}
+
+static unsigned long crc32(const vector<unsigned char> &bytes)
+{
+  static const vector<unsigned long> table = []() {
+    vector<unsigned long> tab(256);
+    for (unsigned long n = 0; n < 256; n++) {
+      unsigned long c = n;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1) ? 0xedb88320ul ^ (c >> 1) : c >> 1;
+      tab[n] = c;
+    }
+    return tab;
+  }();
+
+  unsigned long c = 0xfffffffful;
+  for (unsigned char byte : bytes)
+    c = table[(c ^ byte) & 0xff] ^ (c >> 8);
+  return c ^ 0xfffffffful;
+}
+
+static void push_u32(vector<unsigned char> &bytes, unsigned long val)
+{
+  for (int s = 24; s >= 0; s -= 8)
+    bytes.push_back((val >> s) & 0xff);
+}
+
+static bool write_png_chunk(FILE *ofile, const char *type,
+                            const vector<unsigned char> &data)
+{
+  vector<unsigned char> chunk(type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  vector<unsigned char> len;
+  push_u32(len, data.size());
+  vector<unsigned char> crc;
+  push_u32(crc, crc32(chunk));
+  return fwrite(len.data(), 1, 4, ofile) == 4 &&
+         fwrite(chunk.data(), 1, chunk.size(), ofile) == chunk.size() &&
+         fwrite(crc.data(), 1, 4, ofile) == 4;
+}
+
+static int paeth(int a, int b, int c)
+{
+  int p = a + b - c;
+  int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+  if (pa <= pb && pa <= pc)
+    return a;
+  return (pb <= pc) ? b : c;
+}
+
+Status RasterImage::write_png(FILE *ofile) const
+{
+  ProfileScope prof("write_png");
+
+  // Filter each row with the filter giving the smallest sum of absolute
+  // values, which usually compresses best
+  const int row_sz = 3 * width;
+  vector<unsigned char> raw((size_t)(row_sz + 1) * height);
+  vector<unsigned char> filt[5];
+  for (auto &f : filt)
+    f.resize(row_sz);
+  for (int y = 0; y < height; y++) {
+    const unsigned char *row = &pixels[(size_t)y * row_sz];
+    const unsigned char *up = (y) ? row - row_sz : nullptr;
+    long best_sum = -1;
+    int best = 0;
+    for (int type = 0; type < 5; type++) {
+      long sum = 0;
+      for (int i = 0; i < row_sz; i++) {
+        int a = (i >= 3) ? row[i - 3] : 0;
+        int b = (up) ? up[i] : 0;
+        int c = (up && i >= 3) ? up[i - 3] : 0;
+        int pred = 0;
+        if (type == 1)
+          pred = a;
+        else if (type == 2)
+          pred = b;
+        else if (type == 3)
+          pred = (a + b) / 2;
+        else if (type == 4)
+          pred = paeth(a, b, c);
+        unsigned char val = row[i] - pred;
+        filt[type][i] = val;
+        sum += (val < 128) ? val : 256 - val;
+      }
+      if (best_sum < 0 || sum < best_sum) {
+        best_sum = sum;
+        best = type;
+      }
+    }
+    unsigned char *out = &raw[(size_t)y * (row_sz + 1)];
+    out[0] = best;
+    std::copy(filt[best].begin(), filt[best].end(), out + 1);
+  }
+
+  vector<unsigned char> hdr;
+  push_u32(hdr, width);
+  push_u32(hdr, height);
+  hdr.push_back(8); // bit depth
+  hdr.push_back(2); // RGB
+  hdr.push_back(0); // compression
+  hdr.push_back(0); // filter
+  hdr.push_back(0); // no interlace
+
+  vector<unsigned char> idat;
+  zlib_compress(raw, idat);
+
+  const unsigned char sig[] = {137, 80, 78, 71, 13, 10, 26, 10};
+  if (fwrite(sig, 1, 8, ofile) != 8 || !write_png_chunk(ofile, "IHDR", hdr) ||
+      !write_png_chunk(ofile, "IDAT", idat) ||
+      !write_png_chunk(ofile, "IEND", vector<unsigned char>()))
+    return Status::error("could not write image");
+  return Status::ok();
+}
+
+// --------------------------------------------------------------
+// Rendering
+
+namespace {
+
+// Width and height of a tile, in samples
+const int tile_sz = 32;
+
+// Light direction, and half way vector for the highlights, relative to the
+// viewer, and the lighting values, as in antiview
+const Vec3d light_dir = Vec3d(-100, 200, 1000).unit();
+const Vec3d light_half = (light_dir + Vec3d(0, 0, 1)).unit();
+const double light_ambient = 0.2;
+const double shininess = 100;
+
+// Colour of an element
+struct ElemCol {
+  float rgb[3];
+  int alpha_lev; // drawn in this many of each 16 samples
+};
+
+// Samples that may show an element, a box and the convex hull of the
+// projected element, with no hull if the projection is not bounded
+struct ScreenBound {
+  int box[4];
+  int hull_start; // first hull point in RasterScene::hull_pts
+  int hull_num;
+};
+
+// Face triangle, with a shaded colour
+// For a vertex P0 and edge vectors E1 and E2 from it, a ray D meets the
+// triangle at barycentric coordinates u = D.U/D.N and v = D.V/D.N, with
+// N = E2xE1, U = P0xE2 and V = E1xP0, at distance E2.V/D.N (Moller-Trumbore
+// with the terms that do not depend on the ray found beforehand)
+struct RasterTri {
+  Vec3d norm;
+  Vec3d u_dir;
+  Vec3d v_dir;
+  double dist;
+  ElemCol col;
+  ScreenBound bnd;
+};
+
+// Vertex sphere
+struct RasterBall {
+  Vec3d cent;
+  double rad;
+  ElemCol col;
+  ScreenBound bnd;
+};
+
+// Edge cylinder
+struct RasterRod {
+  Vec3d end;
+  Vec3d axis; // unit
+  double len;
+  double rad;
+  ElemCol col;
+  ScreenBound bnd;
+};
+
+// Scene elements, in eye coordinates, and the elements in each tile
+class RasterScene {
+private:
+  int width;
+  int height;
+  double near;   // elements are cut by this plane in front of the eye
+  double fx, fy; // projection scale
+  int tiles_x, tiles_y;
+
+  vector<RasterTri> tris;
+  vector<RasterBall> balls;
+  vector<RasterRod> rods;
+  vector<double> hull_pts;        // x and y of the hull points
+  vector<vector<int>> tile_elems; // element index * 4 + type
+
+  bool bound(const Vec3d *pts, int num, ScreenBound &bnd);
+  bool row_span(const ScreenBound &bnd, int y, int &x0, int &x1) const;
+  void add_to_tiles(int code, const ScreenBound &bnd);
+  void add_disp(DisplayPoly &disp, const Trans3d &trans);
+
+public:
+  RasterScene(const Scene &scen, int wdth, int hgt);
+
+  int num_tiles() const { return tiles_x * tiles_y; }
+  void draw_tile(int tile, const ElemCol &bg, vector<double> &depths,
+                 RasterImage &img) const;
+};
+
+} // namespace
+
+// Bayer matrix, to spread the samples drawn for transparency
+static const int stipple[16] = {0,  8, 2,  10, 12, 4, 14, 6,
+                                3, 11, 1,  9,  15, 7, 13, 5};
+
+static ElemCol elem_col(Color col, bool trans)
+{
+  ElemCol ecol;
+  Vec4d cv = col.get_vec4d();
+  for (int i = 0; i < 3; i++)
+    ecol.rgb[i] = cv[i];
+  ecol.alpha_lev = (trans) ? int(cv[3] * 16 + 0.5) : 16;
+  return ecol;
+}
+
+// Colour lit from a direction, with the normal facing the viewer
+static void shade(const ElemCol &col, const Vec3d &norm, float rgb[3])
+{
+  double diff = std::max(vdot(norm, light_dir), 0.0);
+  double spec = pow(std::max(vdot(norm, light_half), 0.0), shininess);
+  for (int i = 0; i < 3; i++)
+    rgb[i] = col.rgb[i] * (light_ambient + diff + spec / 2);
+}
+
+static void set_pixel(unsigned char *pix, const float rgb[3])
+{
+  for (int i = 0; i < 3; i++)
+    pix[i] = (unsigned char)(std::min(std::max(rgb[i], 0.0f), 1.0f) * 255 +
+                             0.5);
+}
+
+RasterScene::RasterScene(const Scene &scen, int wdth, int hgt)
+    : width(wdth), height(hgt)
+{
+  // View as in antiview, a 30 degree vertical field of view at a distance
+  // giving the same view as other export formats
+  const Camera &cam = scen.cur_camera();
+  near = cam.get_cut_dist();
+  fy = 1 / tan(deg2rad(15));
+  fx = fy * height / width;
+  Vec3d centre = cam.get_centre();
+  Trans3d trans = Trans3d::translate(Vec3d(0, 0, -1.57 * cam.get_distance()) -
+                                     cam.get_lookat() + centre) *
+                  cam.get_rotation() * cam.get_spin_rot() *
+                  Trans3d::translate(-centre);
+
+  tiles_x = (width + tile_sz - 1) / tile_sz;
+  tiles_y = (height + tile_sz - 1) / tile_sz;
+  tile_elems.resize(num_tiles());
+
+  for (const auto &sc_geom : scen.get_geoms()) {
+    for (auto *disp : sc_geom.get_disps())
+      if (auto *poly = dynamic_cast<DisplayPoly *>(disp))
+        add_disp(*poly, trans);
+    if (auto *poly = dynamic_cast<DisplayPoly *>(sc_geom.get_sym()))
+      add_disp(*poly, trans);
+  }
+}
+
+// Samples that may show points, false if there are none
+bool RasterScene::bound(const Vec3d *pts, int num, ScreenBound &bnd)
+{
+  bnd.hull_start = hull_pts.size();
+  bnd.hull_num = 0;
+  vector<std::pair<double, double>> proj;
+  int num_behind = 0;
+  for (int i = 0; i < num; i++) {
+    double depth = -pts[i][2];
+    if (depth < near) { // projection is not bounded
+      num_behind++;
+      continue;
+    }
+    proj.push_back({width * 0.5 * (1 + fx * pts[i][0] / depth),
+                    height * 0.5 * (1 - fy * pts[i][1] / depth)});
+  }
+  if (num_behind == num)
+    return false;
+  if (num_behind) {
+    bnd.box[0] = bnd.box[1] = 0;
+    bnd.box[2] = width;
+    bnd.box[3] = height;
+    return true;
+  }
+
+  // convex hull, by the monotone chain method, anticlockwise on the screen
+  std::sort(proj.begin(), proj.end());
+  vector<std::pair<double, double>> hull(2 * proj.size());
+  auto turn = [](const std::pair<double, double> &p0,
+                 const std::pair<double, double> &p1,
+                 const std::pair<double, double> &p2) {
+    return (p1.first - p0.first) * (p2.second - p0.second) -
+           (p1.second - p0.second) * (p2.first - p0.first);
+  };
+  int cnt = 0;
+  for (unsigned int i = 0; i < proj.size(); i++) {
+    while (cnt >= 2 && turn(hull[cnt - 2], hull[cnt - 1], proj[i]) <= 0)
+      cnt--;
+    hull[cnt++] = proj[i];
+  }
+  for (int i = (int)proj.size() - 2, lower = cnt + 1; i >= 0; i--) {
+    while (cnt >= lower && turn(hull[cnt - 2], hull[cnt - 1], proj[i]) <= 0)
+      cnt--;
+    hull[cnt++] = proj[i];
+  }
+  cnt = std::max(cnt - 1, 1);
+
+  double x0 = width, y0 = height, x1 = 0, y1 = 0;
+  for (int i = 0; i < cnt; i++) {
+    x0 = std::min(x0, hull[i].first);
+    x1 = std::max(x1, hull[i].first);
+    y0 = std::min(y0, hull[i].second);
+    y1 = std::max(y1, hull[i].second);
+    hull_pts.push_back(hull[i].first);
+    hull_pts.push_back(hull[i].second);
+  }
+  bnd.hull_num = cnt;
+  bnd.box[0] = std::max(int(floor(x0)), 0);
+  bnd.box[1] = std::max(int(floor(y0)), 0);
+  bnd.box[2] = std::min(int(ceil(x1)) + 1, width);
+  bnd.box[3] = std::min(int(ceil(y1)) + 1, height);
+  if (bnd.box[0] >= bnd.box[2] || bnd.box[1] >= bnd.box[3]) {
+    hull_pts.resize(bnd.hull_start);
+    return false;
+  }
+  return true;
+}
+
+// Samples of a row that may show an element, with a margin of a sample,
+// false if there are none
+bool RasterScene::row_span(const ScreenBound &bnd, int y, int &x0,
+                           int &x1) const
+{
+  x0 = bnd.box[0];
+  x1 = bnd.box[2];
+  if (bnd.hull_num < 3)
+    return true;
+  const double *pts = &hull_pts[bnd.hull_start];
+  const double yc = y + 0.5;
+  double xmin = width, xmax = 0;
+  bool found = false;
+  for (int i = 0; i < bnd.hull_num; i++) {
+    const double *p = pts + 2 * i;
+    const double *q = pts + 2 * ((i + 1) % bnd.hull_num);
+    if ((p[1] - yc) * (q[1] - yc) > 0)
+      continue;
+    double x = (p[1] == q[1]) ? p[0]
+                              : p[0] + (yc - p[1]) * (q[0] - p[0]) /
+                                           (q[1] - p[1]);
+    xmin = std::min(xmin, x);
+    xmax = std::max(xmax, x);
+    found = true;
+  }
+  if (!found)
+    return false;
+  x0 = std::max(x0, int(floor(xmin)) - 1);
+  x1 = std::min(x1, int(ceil(xmax)) + 1);
+  return x0 < x1;
+}
+
+void RasterScene::add_to_tiles(int code, const ScreenBound &bnd)
+{
+  const int *box = bnd.box;
+  for (int ty = box[1] / tile_sz; ty <= (box[3] - 1) / tile_sz; ty++)
+    for (int tx = box[0] / tile_sz; tx <= (box[2] - 1) / tile_sz; tx++)
+      tile_elems[ty * tiles_x + tx].push_back(code);
+}
+
+void RasterScene::add_disp(DisplayPoly &disp, const Trans3d &trans)
+{
+  const Geometry &geom = disp.get_disp_geom();
+  vector<Vec3d> verts;
+  transform(verts, geom.verts(), trans);
+  bool elem_trans = disp.get_elem_trans();
+  ScreenBound bnd;
+
+  auto get_col = [&](int type, int idx) {
+    Color col = geom.colors(type).get(idx);
+    if (col.is_index())
+      col = disp.get_clrngs()[type].get_col(col.get_index());
+    if (!col.is_value())
+      col = disp.def_col(type);
+    return col;
+  };
+
+  if (disp.elem(FACES).get_show()) {
+    for (unsigned int i = 0; i < geom.faces().size(); i++) {
+      const vector<int> &face = geom.faces(i);
+      if (face.size() < 3)
+        continue;
+      Color col = get_col(FACES, i);
+      ElemCol ecol = elem_col(col, elem_trans);
+      if (col.is_invisible() || !ecol.alpha_lev)
+        continue;
+      Vec3d norm = face_norm(verts, face).unit();
+      if (vdot(norm, verts[face[0]]) > 0) // two sided lighting
+        norm = -norm;
+      float rgb[3];
+      shade(ecol, norm, rgb);
+      std::copy(rgb, rgb + 3, ecol.rgb);
+
+      // a fan of triangles, as for a native polygon display
+      for (unsigned int j = 1; j < face.size() - 1; j++) {
+        Vec3d pts[] = {verts[face[0]], verts[face[j]], verts[face[j + 1]]};
+        if (!bound(pts, 3, bnd))
+          continue;
+        add_to_tiles(tris.size() * 4 + FACES, bnd);
+        Vec3d e1 = pts[1] - pts[0];
+        Vec3d e2 = pts[2] - pts[0];
+        Vec3d v_dir = vcross(e1, pts[0]);
+        tris.push_back({vcross(e2, e1), vcross(pts[0], e2), v_dir,
+                        vdot(e2, v_dir), ecol, bnd});
+      }
+    }
+  }
+
+  if (disp.elem(VERTS).get_show()) {
+    double rad = disp.get_vert_rad();
+    for (unsigned int i = 0; i < verts.size(); i++) {
+      Color col = get_col(VERTS, i);
+      ElemCol ecol = elem_col(col, elem_trans);
+      if (col.is_invisible() || !ecol.alpha_lev)
+        continue;
+      Vec3d pts[8];
+      for (int c = 0; c < 8; c++)
+        pts[c] = verts[i] + rad * Vec3d((c & 1) ? 1 : -1, (c & 2) ? 1 : -1,
+                                        (c & 4) ? 1 : -1);
+      if (!bound(pts, 8, bnd))
+        continue;
+      add_to_tiles(balls.size() * 4 + VERTS, bnd);
+      balls.push_back({verts[i], rad, ecol, bnd});
+    }
+  }
+
+  if (disp.elem(EDGES).get_show()) {
+    double rad = disp.get_edge_rad();
+    for (unsigned int i = 0; i < geom.edges().size(); i++) {
+      Color col = get_col(EDGES, i);
+      ElemCol ecol = elem_col(col, elem_trans);
+      if (col.is_invisible() || !ecol.alpha_lev)
+        continue;
+      const Vec3d &v0 = verts[geom.edges(i, 0)];
+      const Vec3d &v1 = verts[geom.edges(i, 1)];
+      double len = (v1 - v0).len();
+      if (len < epsilon)
+        continue;
+      Vec3d pts[16];
+      for (int c = 0; c < 16; c++)
+        pts[c] = ((c & 8) ? v1 : v0) +
+                 rad * Vec3d((c & 1) ? 1 : -1, (c & 2) ? 1 : -1,
+                             (c & 4) ? 1 : -1);
+      if (!bound(pts, 16, bnd))
+        continue;
+      add_to_tiles(rods.size() * 4 + EDGES, bnd);
+      rods.push_back({v0, (v1 - v0) / len, len, rad, ecol, bnd});
+    }
+  }
+}
+
+void RasterScene::draw_tile(int tile, const ElemCol &bg,
+                            vector<double> &depths, RasterImage &img) const
+{
+  const int tx0 = (tile % tiles_x) * tile_sz;
+  const int ty0 = (tile / tiles_x) * tile_sz;
+  const int tx1 = std::min(tx0 + tile_sz, width);
+  const int ty1 = std::min(ty0 + tile_sz, height);
+  for (int y = ty0; y < ty1; y++)
+    for (int x = tx0; x < tx1; x++) {
+      depths[(size_t)y * width + x] = std::numeric_limits<double>::max();
+      set_pixel(img.pixel(x, y), bg.rgb);
+    }
+
+  // direction of the ray through a sample, with depth 1
+  auto ray = [&](int x, int y) {
+    return Vec3d(((x + 0.5) * 2 / width - 1) / fx,
+                 (1 - (y + 0.5) * 2 / height) / fy, -1);
+  };
+
+  for (int code : tile_elems[tile]) {
+    int idx = code / 4;
+    int type = code % 4;
+    const ElemCol &col = (type == FACES)   ? tris[idx].col
+                         : (type == VERTS) ? balls[idx].col
+                                           : rods[idx].col;
+    const ScreenBound &bnd = (type == FACES)   ? tris[idx].bnd
+                             : (type == VERTS) ? balls[idx].bnd
+                                               : rods[idx].bnd;
+    int x0, x1;
+    for (int y = std::max(ty0, bnd.box[1]); y < std::min(ty1, bnd.box[3]);
+         y++) {
+      if (!row_span(bnd, y, x0, x1))
+        continue;
+      for (int x = std::max(tx0, x0); x < std::min(tx1, x1); x++) {
+        if (col.alpha_lev < 16 &&
+            stipple[(y & 3) * 4 + (x & 3)] >= col.alpha_lev)
+          continue;
+        double &depth = depths[(size_t)y * width + x];
+        Vec3d dir = ray(x, y);
+        double t = -1;
+        Vec3d norm;
+        if (type == FACES) {
+          const RasterTri &tri = tris[idx];
+          double det = vdot(dir, tri.norm);
+          if (fabs(det) < 1e-300)
+            continue;
+          t = tri.dist / det;
+          if (t >= depth)
+            continue;
+          double u = vdot(dir, tri.u_dir) / det;
+          double v = vdot(dir, tri.v_dir) / det;
+          if (u < 0 || v < 0 || u + v > 1)
+            t = -1;
+        }
+        else if (type == VERTS) {
+          const RasterBall &ball = balls[idx];
+          double a = vdot(dir, dir);
+          double b = vdot(dir, ball.cent);
+          double c = ball.cent.len2() - ball.rad * ball.rad;
+          double disc = b * b - a * c;
+          if (disc < 0)
+            continue;
+          double sq = sqrt(disc);
+          t = (b - sq) / a;
+          if (t < near)
+            t = (b + sq) / a;
+          norm = (t * dir - ball.cent) / ball.rad;
+        }
+        else {
+          const RasterRod &rod = rods[idx];
+          Vec3d w = -rod.end;
+          double d_par = vdot(dir, rod.axis);
+          double w_par = vdot(w, rod.axis);
+          Vec3d dp = dir - d_par * rod.axis;
+          Vec3d wp = w - w_par * rod.axis;
+          double a = vdot(dp, dp);
+          double b = vdot(dp, wp);
+          double c = vdot(wp, wp) - rod.rad * rod.rad;
+          double disc = b * b - a * c;
+          if (a < 1e-300 || disc < 0)
+            continue;
+          double sq = sqrt(disc);
+          for (double tc : {(-b - sq) / a, (-b + sq) / a}) {
+            double s = w_par + tc * d_par;
+            if (tc >= near && s >= 0 && s <= rod.len) {
+              t = tc;
+              norm = (tc * dir - rod.end - s * rod.axis) / rod.rad;
+              break;
+            }
+          }
+        }
+        if (t < near || t >= depth)
+          continue;
+        depth = t;
+
+        float rgb[3];
+        if (type == FACES)
+          std::copy(col.rgb, col.rgb + 3, rgb);
+        else {
+          if (vdot(norm, dir) > 0) // inside, seen through the cut plane
+            norm = -norm;
+          shade(col, norm, rgb);
+        }
+        set_pixel(img.pixel(x, y), rgb);
+      }
+    }
+  }
+}
+
+void RasterWriter::render(const Scene &scen, RasterImage &img) const
+{
+  ProfileScope prof("render");
+  const int wdth = width * samples;
+  const int hgt = height * samples;
+  RasterScene rast(scen, wdth, hgt);
+
+  img.resize(wdth, hgt);
+  Color bg = scen.get_bg_col();
+  ElemCol bg_col = elem_col(bg.is_value() ? bg : Color(0.9, 0.9, 0.9), false);
+  vector<double> depths((size_t)wdth * hgt);
+  parallel_for(0, rast.num_tiles(),
+               [&](long tile) { rast.draw_tile(tile, bg_col, depths, img); });
+  img.shrink(samples);
+}
+
+Status RasterWriter::write(FILE *ofile, const Scene &scen,
+                           const string &format) const
+{
+  RasterImage img;
+  render(scen, img);
+  if (format == "ppm")
+    return img.write_ppm(ofile);
+  else
+    return img.write_png(ofile);
+}
+
+} // namespace anti
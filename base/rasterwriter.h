@@ -0,0 +1,144 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/**\file rasterwriter.h
+   \brief render a scene to an image, and write PNG and PPM files
+*/
+
+#ifndef RASTERWRITER_H
+#define RASTERWRITER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "scene.h"
+#include "status.h"
+
+namespace anti {
+
+/// An RGB image, with 8 bits for each component
+class RasterImage {
+private:
+  int width;
+  int height;
+  std::vector<unsigned char> pixels; // RGB, by row from the top
+
+public:
+  /// Constructor
+  /**\param wdth the width, in pixels.
+   * \param hgt the height, in pixels. */
+  RasterImage(int wdth = 0, int hgt = 0) { resize(wdth, hgt); }
+
+  /// Set the size
+  /** The pixels are set to black.
+   * \param wdth the width, in pixels.
+   * \param hgt the height, in pixels. */
+  void resize(int wdth, int hgt);
+
+  /// Get the width
+  /**\return The width, in pixels. */
+  int get_width() const { return width; }
+
+  /// Get the height
+  /**\return The height, in pixels. */
+  int get_height() const { return height; }
+
+  /// Get the RGB values of a pixel
+  /**\param x the column, from the left.
+   * \param y the row, from the top.
+   * \return A pointer to the three values of the pixel. */
+  unsigned char *pixel(int x, int y) { return &pixels[3 * (y * width + x)]; }
+
+  /// Get the RGB values of a pixel
+  /**\param x the column, from the left.
+   * \param y the row, from the top.
+   * \return A pointer to the three values of the pixel. */
+  const unsigned char *pixel(int x, int y) const
+  {
+    return &pixels[3 * (y * width + x)];
+  }
+
+  /// Reduce the size by averaging blocks of pixels
+  /**\param factor the width and height of the blocks. */
+  void shrink(int factor);
+
+  /// Write in binary PPM format
+  /**\param ofile file to write to.
+   * \return status, which evaluates to \c true if the image was written. */
+  Status write_ppm(FILE *ofile) const;
+
+  /// Write in PNG format
+  /**\param ofile file to write to.
+   * \return status, which evaluates to \c true if the image was written. */
+  Status write_png(FILE *ofile) const;
+};
+
+/// Render a scene to an image without a display
+/** The displays are drawn as in antiview: faces are flat shaded, vertices
+ *  are spheres and edges are cylinders, with screen door transparency.
+ *  Spheres and cylinders are drawn exactly, rather than as polygons. The
+ *  image is split into tiles, which are drawn in parallel. */
+class RasterWriter {
+private:
+  int width;
+  int height;
+  int samples;
+
+public:
+  /// Constructor
+  RasterWriter() : width(512), height(512), samples(2) {}
+
+  /// Set the image size
+  /**\param wdth the width, in pixels.
+   * \param hgt the height, in pixels. */
+  void set_size(int wdth, int hgt)
+  {
+    width = wdth;
+    height = hgt;
+  }
+
+  /// Set the antialiasing
+  /** Each pixel is the average of a square of samples, which also blends
+   *  the screen door transparency.
+   * \param samps the number of samples along each side of a pixel. */
+  void set_samples(int samps) { samples = (samps > 0) ? samps : 1; }
+
+  /// Render a scene
+  /**\param scen the scene to render.
+   * \param img the image to render to. */
+  void render(const Scene &scen, RasterImage &img) const;
+
+  /// Render a scene and write the image
+  /**\param ofile file to write to.
+   * \param scen the scene to render.
+   * \param format the image format, "png" or "ppm".
+   * \return status, which evaluates to \c true if the image was written. */
+  Status write(FILE *ofile, const Scene &scen,
+               const std::string &format = "png") const;
+};
+
+} // namespace anti
+
+#endif // RASTERWRITER_H
@@ -41,6 +41,7 @@
 #include "geometryinfo.h"
 #include "geometryutils.h"
 #include "mathutils.h"
+#include "profile.h"
 
 using std::map;
 using std::set;
@@ -49,30 +50,19 @@ using std::vector;
 
 namespace anti {
 
-bool polygon_sort(vector<int> &polygon)
+// Rotate a polygon to start at its lowest index, and reverse it if the
+// index that follows is greater than the last index
+bool polygon_sort(vector<int>::iterator begin, vector<int>::iterator end)
 {
-  bool reversed = false;
-  vector<int> polygon_sorted;
-
-  // Find lowest index make it the first polygon vertex index
-  auto iter = min_element(polygon.begin(), polygon.end());
-  polygon_sorted.push_back(*iter);
-
-  // Find rest of polygon indexes
-  if (iter < polygon.end())
-    polygon_sorted.insert(polygon_sorted.end(), (iter + 1), polygon.end());
-  if (iter > polygon.begin())
-    polygon_sorted.insert(polygon_sorted.end(), polygon.begin(), iter);
-
-  // reverse them if necessary
-  iter = polygon_sorted.begin() + 1;
-  if (*iter > polygon_sorted.back()) {
-    reverse(iter, polygon_sorted.end());
-    reversed = true;
-  }
+  if (end - begin < 2)
+    return false;
 
-  polygon = polygon_sorted;
-  return reversed;
+  std::rotate(begin, min_element(begin, end), end);
+  if (*(begin + 1) > *(end - 1)) {
+    reverse(begin + 1, end);
+    return true;
+  }
+  return false;
 }
 
 class vertexMap {
@@ -94,43 +84,62 @@ void remap_faces(vector<vector<int>> &faces, const vector<vertexMap> &vm)
       j = vm[j].new_vertex;
 }
 
-class facesSort {
+// Faces held in a single array, with the faces sorted by permuting a list
+// of face numbers rather than moving the faces
+class FlatFaces {
+private:
+  vector<int> idxs;
+  vector<int> offsets; // face i is idxs[offsets[i]] to idxs[offsets[i+1]]
+
 public:
-  int face_no;
-  vector<int> face;
-  vector<int> face_all_verts;
-  Color col;
-  Color average_col;
-  bool deleted;
-  bool reversed;
+  FlatFaces() = default;
 
-  // for congruence test
-  vector<int> equiv_faces;
+  FlatFaces(const vector<vector<int>> &faces)
+  {
+    offsets.reserve(faces.size() + 1);
+    offsets.push_back(0);
+    for (const auto &face : faces)
+      offsets.push_back(offsets.back() + face.size());
+    idxs.reserve(offsets.back());
+    for (const auto &face : faces)
+      idxs.insert(idxs.end(), face.begin(), face.end());
+  }
 
-  facesSort(int i, vector<int> f, Color c, bool rev)
-      : face_no(i), face(f), col(c), reversed(rev)
+  void remap(const vector<vertexMap> &vm)
   {
-    deleted = false;
+    for (int &idx : idxs)
+      idx = vm[idx].new_vertex;
   }
-  facesSort(int i, vector<int> f, vector<int> fcv, Color c, bool rev)
-      : face_no(i), face(f), face_all_verts(fcv), col(c), reversed(rev)
+
+  bool polygon_sort(int f)
   {
-    deleted = false;
+    return anti::polygon_sort(idxs.begin() + offsets[f],
+                              idxs.begin() + offsets[f + 1]);
   }
-};
 
-bool cmp_faces(const facesSort &a, const facesSort &b)
-{
-  if (a.face.size() != b.face.size())
-    return a.face.size() < b.face.size();
-  else
-    return a.face < b.face;
-}
+  int size(int f) const { return offsets[f + 1] - offsets[f]; }
+  const int *begin(int f) const { return idxs.data() + offsets[f]; }
+  const int *end(int f) const { return idxs.data() + offsets[f + 1]; }
 
-bool cmp_face_no(const facesSort &a, const facesSort &b)
-{
-  return a.face_no < b.face_no;
-}
+  // size first, then index numbers
+  bool less(int f1, int f2) const
+  {
+    if (size(f1) != size(f2))
+      return size(f1) < size(f2);
+    return std::lexicographical_compare(begin(f1), end(f1), begin(f2),
+                                        end(f2));
+  }
+
+  bool equal(int f1, int f2) const
+  {
+    return size(f1) == size(f2) && std::equal(begin(f1), end(f1), begin(f2));
+  }
+
+  size_t memory_usage() const
+  {
+    return heap_memory(idxs) + heap_memory(offsets);
+  }
+};
 
 Color average_color(const vector<Color> &cols, const int blend_type)
 {
@@ -147,19 +156,22 @@ Color average_color(const vector<Color> &cols, const int blend_type)
   return Color();
 }
 
-Color average_face_color(const vector<facesSort> &fs, const int begin,
-                         const int end, const int blend_type)
+// Average colour of the faces order[begin] to order[end], using blend_cols
+// as working space
+Color average_face_color(const vector<Color> &cols, const vector<int> &order,
+                         const int begin, const int end, const int blend_type,
+                         vector<Color> &blend_cols)
 {
   // quick decision, if only one instance, return its own color
   if (!(end - begin))
-    return fs[begin].col;
+    return cols[order[begin]];
 
   // collect colors
-  vector<Color> cols;
+  blend_cols.clear();
   for (int i = begin; i <= end; i++)
-    cols.push_back(fs[i].col);
+    blend_cols.push_back(cols[order[i]]);
 
-  return (cols.size() ? average_color(cols, blend_type) : Color());
+  return average_color(blend_cols, blend_type);
 }
 
 void sort_faces(Geometry &geom, const vector<vertexMap> &vm_all_verts,
@@ -170,46 +182,37 @@ void sort_faces(Geometry &geom, const vector<vertexMap> &vm_all_verts,
 {
   vector<vector<int>> &faces =
       (elem == 'f') ? geom.raw_faces() : geom.raw_edges();
+  const int num_faces = faces.size();
 
   // sort only when 's' is set
   bool sort_only = strchr(delete_elems.c_str(), 's');
   bool merge_verts = strchr(delete_elems.c_str(), 'v');
   bool include_colors = (!equiv_elems);
 
-  vector<facesSort> fs;
-
-  // make a copy of faces with all vertices if necessary
-  vector<vector<int>> faces_all_verts;
+  // the faces with merged vertices, and with all vertices if necessary
+  FlatFaces merged_faces(faces);
+  FlatFaces all_faces;
   if (!merge_verts) {
-    faces_all_verts = faces;
-    remap_faces(faces_all_verts, vm_all_verts);
+    all_faces = merged_faces;
+    all_faces.remap(vm_all_verts);
   }
-
-  // use geom's face's and not a copy for merged vertices
   if (vm_merged_verts.size())
-    remap_faces(faces, vm_merged_verts);
+    merged_faces.remap(vm_merged_verts);
 
-  // load face sort vector
-  for (unsigned int i = 0; i < faces.size(); i++) {
-    Color col;
-    if (include_colors) {
-      if (elem == 'f')
-        col = geom.colors(FACES).get(i);
-      else
-        col = geom.colors(EDGES).get(i);
-    }
+  vector<Color> cols;
+  if (include_colors) {
+    cols.resize(num_faces);
+    for (int i = 0; i < num_faces; i++)
+      cols[i] = geom.colors((elem == 'f') ? FACES : EDGES).get(i);
+  }
 
-    // use the reverse flag from the faces with merged vertices
-    bool reversed = polygon_sort(faces[i]);
-    // if using faces with all verts mapped, use different declaration
-    if (!merge_verts) {
-      polygon_sort(faces_all_verts[i]);
-      fs.push_back(facesSort(i, faces[i], faces_all_verts[i], col, reversed));
-    }
-    else
-      fs.push_back(facesSort(i, faces[i], col, reversed));
+  // use the reverse flag from the faces with merged vertices
+  vector<char> reversed(num_faces);
+  for (int i = 0; i < num_faces; i++) {
+    reversed[i] = merged_faces.polygon_sort(i);
+    if (!merge_verts)
+      all_faces.polygon_sort(i);
   }
-  faces_all_verts.clear();
 
   // clear some memory
   if (elem == 'f')
@@ -218,77 +221,100 @@ void sort_faces(Geometry &geom, const vector<vertexMap> &vm_all_verts,
     geom.clear(EDGES);
 
   // sort on faces with merged vertices
-  stable_sort(fs.begin(), fs.end(), cmp_faces);
+  vector<int> order(num_faces);
+  for (int i = 0; i < num_faces; i++)
+    order[i] = i;
+  stable_sort(order.begin(), order.end(), [&merged_faces](int f1, int f2) {
+    return merged_faces.less(f1, f2);
+  });
 
   // check to see we are actually deleting elements
   // mark coincident faces for skipping if any
   bool deleting_faces = ((elem == 'e' && strchr(delete_elems.c_str(), 'e')) ||
                          (elem == 'f' && strchr(delete_elems.c_str(), 'f')));
+  vector<char> deleted(num_faces, false);
+  vector<Color> average_cols;
+  // equivalent faces are order[equiv_begin[f]] to order[equiv_end[f]], for
+  // the first face f of a set of equivalent faces
+  vector<int> equiv_begin, equiv_end;
   if (deleting_faces) {
-    if (equiv_elems)
-      fs[0].equiv_faces.push_back(fs[0].face_no);
+    if (include_colors)
+      average_cols.resize(num_faces);
+    if (equiv_elems) {
+      equiv_begin.resize(num_faces);
+      equiv_end.resize(num_faces);
+    }
 
+    vector<Color> blend_cols;
     int cur_undeleted = 0; // the first face in a set of equivalent faces
-    unsigned int j = 0;
-    for (unsigned int i = 0; i < fs.size() - 1; i++) {
-      j = i + 1;
-      if (fs[i].face == fs[j].face)
-        fs[j].deleted = true;
-      else {
-        if (!equiv_elems)
-          fs[cur_undeleted].average_col =
-              average_face_color(fs, cur_undeleted, i, blend_type);
-        cur_undeleted = j;
+    for (int i = 0; i < num_faces; i++) {
+      bool last_of_set =
+          (i == num_faces - 1 || !merged_faces.equal(order[i], order[i + 1]));
+      if (i > cur_undeleted)
+        deleted[order[i]] = true;
+      if (last_of_set) {
+        int f = order[cur_undeleted];
+        if (include_colors)
+          average_cols[f] = average_face_color(cols, order, cur_undeleted, i,
+                                               blend_type, blend_cols);
+        if (equiv_elems) {
+          equiv_begin[f] = cur_undeleted;
+          equiv_end[f] = i;
+        }
+        cur_undeleted = i + 1;
       }
-
-      if (equiv_elems)
-        fs[cur_undeleted].equiv_faces.push_back(fs[j].face_no);
     }
-    if (!equiv_elems)
-      fs[cur_undeleted].average_col =
-          average_face_color(fs, cur_undeleted, j, blend_type);
   }
 
   // if all vertices use/re-sort by those faces
   // but deleted flag will be preserved
-  if (!merge_verts) {
-    for (auto &f : fs)
-      f.face = f.face_all_verts;
-    stable_sort(fs.begin(), fs.end(), cmp_faces);
-  }
+  vector<int> first_order;
+  if (equiv_elems)
+    first_order = order;
+  if (!merge_verts)
+    stable_sort(order.begin(), order.end(), [&all_faces](int f1, int f2) {
+      return all_faces.less(f1, f2);
+    });
 
   // restore original sort of faces unless sort only or congruency check
   if (!sort_only && !equiv_elems)
-    sort(fs.begin(), fs.end(), cmp_face_no);
+    for (int i = 0; i < num_faces; i++)
+      order[i] = i;
+
+  if (profiling_enabled())
+    profile_mem("sort_faces temporaries",
+                merged_faces.memory_usage() + all_faces.memory_usage() +
+                    heap_memory(cols) + heap_memory(reversed) +
+                    heap_memory(order) + heap_memory(deleted) +
+                    heap_memory(average_cols) + heap_memory(equiv_begin) +
+                    heap_memory(equiv_end) + heap_memory(first_order));
 
   // write out sorted faces and colors
+  const FlatFaces &out_faces = (merge_verts) ? merged_faces : all_faces;
   int j = 0;
-  for (auto &f : fs) {
-    if (!f.deleted) {
-      if (equiv_elems)
-        (*equiv_elems)[j++].insert(f.equiv_faces.begin(), f.equiv_faces.end());
+  for (int f : order) {
+    if (!deleted[f]) {
+      if (equiv_elems) {
+        auto &equivs = (*equiv_elems)[j++];
+        if (deleting_faces)
+          for (int i = equiv_begin[f]; i <= equiv_end[f]; i++)
+            equivs.insert(first_order[i]);
+      }
 
       // only write out the geom if not doing congruency check
       if (!chk_congruence) {
+        faces.push_back(vector<int>(out_faces.begin(f), out_faces.end(f)));
         // restore orientation unless sort only
-        if (!sort_only && f.reversed)
-          reverse(f.face.begin(), f.face.end());
-        faces.push_back(f.face);
+        if (!sort_only && reversed[f])
+          reverse(faces.back().begin(), faces.back().end());
         int f_idx = faces.size() - 1;
 
         if (include_colors) {
-          if (deleting_faces) {
-            if (elem == 'f')
-              geom.colors(FACES).set(f_idx, f.average_col);
-            else
-              geom.colors(EDGES).set(f_idx, f.average_col);
-          }
-          else {
-            if (elem == 'f')
-              geom.colors(FACES).set(f_idx, f.col);
-            else
-              geom.colors(EDGES).set(f_idx, f.col);
-          }
+          const Color &col = (deleting_faces) ? average_cols[f] : cols[f];
+          if (elem == 'f')
+            geom.colors(FACES).set(f_idx, col);
+          else
+            geom.colors(EDGES).set(f_idx, col);
         }
       }
     }
@@ -390,6 +416,8 @@ void sort_vertices(Geometry &geom, vector<vertexMap> &vm_all_verts,
       col = geom.colors(VERTS).get(i);
     vs.push_back(vertSort(i, verts[i], col));
   }
+  if (profiling_enabled())
+    profile_mem("sort_vertices temporaries", heap_memory(vs));
 
   // clear some memory
   geom.clear(VERTS);
@@ -544,12 +572,14 @@ void merge_coincident_elements(Geometry &geom, const string &merge_elems,
                                vector<map<int, set<int>>> *equiv_elems,
                                double eps)
 {
+  ProfileScope prof("merge_coincident_elements");
   sort_merge_elems(geom, merge_elems, equiv_elems, false, 0, eps);
 }
 
 void merge_coincident_elements(Geometry &geom, const string &merge_elems,
                                const int blend_type, double eps)
 {
+  ProfileScope prof("merge_coincident_elements");
   vector<map<int, set<int>>> *equiv_elems = nullptr;
   sort_merge_elems(geom, merge_elems, equiv_elems, false, blend_type, eps);
 }
@@ -557,6 +587,7 @@ void merge_coincident_elements(Geometry &geom, const string &merge_elems,
 void merge_coincident_elements(Geometry &geom, const string &merge_elems,
                                double eps)
 {
+  ProfileScope prof("merge_coincident_elements");
   vector<map<int, set<int>>> *equiv_elems = nullptr;
   sort_merge_elems(geom, merge_elems, equiv_elems, false, 0, eps);
 }
@@ -587,8 +618,8 @@ void get_congruence_maps(const Geometry &geom, Trans3d trans,
                          vector<vector<int>> &elem_maps, double eps)
 {
   elem_maps.resize(3);
-  Geometry tmp = geom;
-  tmp.transform(trans);
+  Geometry tmp;
+  tmp.transform(geom, trans);
   vector<map<int, set<int>>> equiv_elems;
   check_congruence(geom, tmp, &equiv_elems, eps);
   int cnts[3];
@@ -156,15 +156,15 @@ int Wenninger::get_poly(Geometry &geom, int sym)
     read_idx_list((char *)diagram_list_strings[i].c_str(), idx_lists[i],
                   INT_MAX, false);
 
-    // stellation face index is in the first position
-    int stellation_face_idx = idx_lists[i][0];
-
-    // construct the diagrams
-    if (!diagrams[stellation_face_idx].verts().size())
-      diagrams[stellation_face_idx] =
-          make_stellation_diagram(geom, stellation_face_idx, sym_str);
   }
 
+  // construct the diagrams, stellation face index is in the first position
+  vector<int> stellation_face_idxs;
+  for (auto &idx_list : idx_lists)
+    if (idx_list.size())
+      stellation_face_idxs.push_back(idx_list[0]);
+  make_stellation_diagrams(geom, diagrams, stellation_face_idxs, sym_str);
+
   bool merge_faces = true;
   bool remove_inline_verts = Wenninger_items[sym].remove_inline_verts;
   bool split_pinched = true;
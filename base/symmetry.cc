@@ -34,6 +34,7 @@
 
 #include "geometryinfo.h"
 #include "mathutils.h"
+#include "profile.h"
 #include "symmetry.h"
 #include "utils.h"
 
@@ -919,7 +920,7 @@ static void equiv_elems_to_sets(vector<vector<set<int>>> &equiv_sets,
 static bool is_sym(const Geometry &test_geom, const Geometry &geom,
                    const vector<int> &test_v_code, const vector<int> &v_code,
                    bool orient, Trans3d &trans,
-                   vector<map<int, set<int>>> &new_equivs)
+                   vector<map<int, set<int>>> &new_equivs, Geometry &s_geom)
 {
   int v_sz = test_geom.verts().size();
   // code to vertex idx for this sym
@@ -949,8 +950,7 @@ static bool is_sym(const Geometry &test_geom, const Geometry &geom,
   trans = Trans3d::align(t_pts, pts);
   if (orient)
     trans = Trans3d::inversion() * trans;
-  Geometry s_geom = geom;
-  s_geom.transform(trans);
+  s_geom.transform(geom, trans);
 
   bool is_congruent = check_congruence(geom, s_geom, &new_equivs, sym_eps);
   return is_congruent;
@@ -973,6 +973,7 @@ static void set_equiv_elems_identity(const Geometry &geom,
 static int find_syms(const Geometry &geom, Transformations &ts,
                      vector<vector<set<int>>> *equiv_sets)
 {
+  ProfileScope prof("find_syms");
   ts.clear();
 
   Geometry merged_geom = geom;
@@ -1003,6 +1004,11 @@ static int find_syms(const Geometry &geom, Transformations &ts,
   for (auto &r_con : r_cons)
     reverse(r_con.begin(), r_con.end());
   const vector<vector<int>> *cons[] = {&v_cons, &r_cons};
+  if (profiling_enabled())
+    profile_mem("find_syms temporaries",
+                merged_geom.memory_usage() + test_geom.memory_usage() +
+                    heap_memory(orig_equivs) + heap_memory(v_cons) +
+                    heap_memory(r_cons));
 
   vector<map<int, set<int>>> equiv_elems(3);
   int cnts[3] = {(int)merged_geom.verts().size(),
@@ -1010,6 +1016,7 @@ static int find_syms(const Geometry &geom, Transformations &ts,
                  (int)merged_geom.faces().size()};
   vector<int> test_path, path;
   vector<int> test_v_code, v_code;
+  Geometry s_geom; // working geometry, reused for each test
   find_path(test_path, test_v_code, *edges.begin(), v_cons);
   vector<vector<int>>::const_iterator ei;
   for (ei = edges.begin(); ei != edges.end(); ei++) {
@@ -1023,7 +1030,7 @@ static int find_syms(const Geometry &geom, Transformations &ts,
           Trans3d trans;
           vector<map<int, set<int>>> new_equivs;
           if (is_sym(test_geom, merged_geom, test_v_code, v_code, orient, trans,
-                     new_equivs)) {
+                     new_equivs, s_geom)) {
             ts.add(trans);
             if (equiv_sets)
               update_equiv_elems(equiv_elems, new_equivs, cnts);
@@ -1053,6 +1060,8 @@ const char *type_str[Symmetry::Ih + 1] = {
 Symmetry::Symmetry(const Geometry &geom, vector<vector<set<int>>> *equiv_sets)
 {
   init(geom, equiv_sets);
+  if (profiling_enabled())
+    profile_mem("Symmetry", memory_usage());
 }
 
 Symmetry::Symmetry(int type, int n, const Trans3d &pos, Status *stat)
@@ -1278,9 +1287,9 @@ void get_equiv_elems(const Geometry &geom, const Transformations &ts,
                  (int)merged_geom.edges().size(),
                  (int)merged_geom.faces().size()};
 
+  Geometry trans_geom;
   for (const auto &t : ts) {
-    Geometry trans_geom = merged_geom;
-    trans_geom.transform(t);
+    trans_geom.transform(merged_geom, t);
     vector<map<int, set<int>>> new_equivs;
     check_congruence(merged_geom, trans_geom, &new_equivs, sym_eps);
     update_equiv_elems(equiv_elems, new_equivs, cnts);
@@ -1752,6 +1761,15 @@ SymmetryAutos &Symmetry::get_autos()
   return autos;
 }
 
+size_t Symmetry::memory_usage() const
+{
+  size_t bytes = sizeof(*this) + heap_memory(axes) + heap_memory(mirrors) +
+                 heap_memory(autos.get_fixed());
+  for (const auto &sub : sub_syms)
+    bytes += sub.memory_usage() + tree_node_overhead;
+  return bytes;
+}
+
 bool Symmetry::operator<(const Symmetry &s) const
 {
   if (sym_type < s.sym_type)
@@ -2134,8 +2152,7 @@ static Symmetry get_face_stabilizer(const Geometry &geom, int f_idx,
   const Transformations &ts = sym.get_trans();
   for (set<Trans3d>::iterator si = ts.get_trans().begin();
        si != ts.get_trans().end(); si++) {
-    test_geom = f_geom;
-    test_geom.transform(*si);
+    test_geom.transform(f_geom, *si);
     test_geom.append(f_geom);
     merge_coincident_elements(test_geom, "f", epsilon);
     if (test_geom.faces().size() == 1) // face carried onto itself
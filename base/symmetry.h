@@ -588,6 +588,11 @@ public:
   /**\return \c true if set to valid type, otherwise \c false */
   bool is_set() const { return sym_type != unknown; }
 
+  /// Estimate the memory used
+  /**\return The estimated memory, in bytes, including the object and the
+   *  cached axes, mirrors and subgroups. */
+  size_t memory_usage() const;
+
   /// Less than.
   /** Only for containers that need it
    * \param s the symmetry axis to compare for less than.
@@ -29,6 +29,11 @@
 #include <stdio.h>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRANSFORM_AVX
+#include <immintrin.h>
+#endif
+
 #include "mathutils.h"
 #include "trans3d.h"
 
@@ -383,4 +388,70 @@ Trans3d Trans3d::align(Vec3d from1, Vec3d from2, Vec3d to1, Vec3d to2)
   return inv_r * trans;
 }
 
+// The batch transforms add the terms in the same order as
+// operator*(Trans3d, Vec3d), so the results are the same
+
+static void transform_scalar(double *dst, const double *src, size_t num,
+                             const double *m)
+{
+  for (size_t i = 0; i < num; i++, src += 3, dst += 3) {
+    const double x = src[0];
+    const double y = src[1];
+    const double z = src[2];
+    dst[0] = 0.0 + m[0] * x + m[1] * y + m[2] * z + m[3];
+    dst[1] = 0.0 + m[4] * x + m[5] * y + m[6] * z + m[7];
+    dst[2] = 0.0 + m[8] * x + m[9] * y + m[10] * z + m[11];
+  }
+}
+
+#ifdef TRANSFORM_AVX
+// Each vector is transformed as a column combination of the matrix, with
+// the three rows in one register. Only AVX is enabled, so the multiply and
+// add are not fused, which would change the results.
+__attribute__((target("avx"))) static void
+transform_avx(double *dst, const double *src, size_t num, const double *m)
+{
+  const __m256d c0 = _mm256_setr_pd(m[0], m[4], m[8], 0.0);
+  const __m256d c1 = _mm256_setr_pd(m[1], m[5], m[9], 0.0);
+  const __m256d c2 = _mm256_setr_pd(m[2], m[6], m[10], 0.0);
+  const __m256d c3 = _mm256_setr_pd(m[3], m[7], m[11], 0.0);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256i mask = _mm256_setr_epi64x(-1, -1, -1, 0);
+  for (size_t i = 0; i < num; i++, src += 3, dst += 3) {
+    __m256d r = _mm256_mul_pd(c0, _mm256_set1_pd(src[0]));
+    r = _mm256_add_pd(zero, r);
+    r = _mm256_add_pd(r, _mm256_mul_pd(c1, _mm256_set1_pd(src[1])));
+    r = _mm256_add_pd(r, _mm256_mul_pd(c2, _mm256_set1_pd(src[2])));
+    r = _mm256_add_pd(r, c3);
+    _mm256_maskstore_pd(dst, mask, r);
+  }
+}
+
+static bool have_avx()
+{
+  static const bool avx = __builtin_cpu_supports("avx");
+  return avx;
+}
+#endif // TRANSFORM_AVX
+
+void transform(Vec3d *dst, const Vec3d *src, size_t num, const Trans3d &trans)
+{
+  static_assert(sizeof(Vec3d) == 3 * sizeof(double),
+                "Vec3d array must be contiguous coordinates");
+  if (!num)
+    return;
+  double m[12];
+  for (int i = 0; i < 12; i++)
+    m[i] = trans[i];
+  double *d = &(*dst)[0];
+  const double *s = src->get_v();
+#ifdef TRANSFORM_AVX
+  if (have_avx()) {
+    transform_avx(d, s, num, m);
+    return;
+  }
+#endif // TRANSFORM_AVX
+  transform_scalar(d, s, num, m);
+}
+
 } // namespace anti
@@ -284,6 +284,25 @@ bool operator<(const Trans3d &trans1, const Trans3d &trans2);
  * \param trans the transformation to apply. */
 void transform(std::vector<Vec3d> &vecs, const Trans3d &trans);
 
+/// Transform a set of vectors into another set
+/**\param dst the transformed vectors, resized to the number of vectors to
+ *  transform. This may be the same set as \a src.
+ * \param src the (column) vectors to transform.
+ * \param trans the transformation to apply. */
+void transform(std::vector<Vec3d> &dst, const std::vector<Vec3d> &src,
+               const Trans3d &trans);
+
+/// Transform an array of vectors
+/** The vectors are transformed as a batch, using vector instructions if
+ *  the processor has them.
+ * \param dst the array for the transformed vectors, which may be the same
+ *  as \a src but must not otherwise overlap it.
+ * \param src the array of (column) vectors to transform.
+ * \param num the number of vectors.
+ * \param trans the transformation to apply. */
+void transform(Vec3d *dst, const Vec3d *src, size_t num,
+               const Trans3d &trans);
+
 // inline functions
 inline Trans3d::Trans3d()
 {
@@ -400,8 +419,15 @@ inline bool operator==(const Trans3d &trans1, const Trans3d &trans2)
 
 inline void transform(std::vector<Vec3d> &vecs, const Trans3d &trans)
 {
-  for (auto &v : vecs)
-    v = trans * v;
+  transform(vecs.data(), vecs.data(), vecs.size(), trans);
+}
+
+inline void transform(std::vector<Vec3d> &dst, const std::vector<Vec3d> &src,
+                      const Trans3d &trans)
+{
+  if (&dst != &src)
+    dst.resize(src.size());
+  transform(dst.data(), src.data(), src.size(), trans);
 }
 
 } // namespace anti
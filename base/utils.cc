@@ -130,7 +130,8 @@ Status read_int_list(char *str, vector<int> &nums, bool is_index, int len,
 {
   nums.clear();
   int vec_idx;
-  char *v_str = strtok(str, sep);
+  char *tok_ptr; // memory pointer for strtok_r
+  char *v_str = strtok_r(str, sep, &tok_ptr);
   int i = 0;
   while (v_str) {
     i++;
@@ -144,7 +145,7 @@ Status read_int_list(char *str, vector<int> &nums, bool is_index, int len,
       return Status::error(msg_str("more than %d integers given", len));
 
     nums.push_back(vec_idx);
-    v_str = strtok(nullptr, sep);
+    v_str = strtok_r(nullptr, sep, &tok_ptr);
   }
 
   return Status::ok();
@@ -178,7 +179,8 @@ Status read_idx_list(char *str, vector<int> &nums, int num_idxs,
   nums.clear();
   int idx, idx2;
   char *p;
-  char *v_str = strtok(str, ",");
+  char *tok_ptr; // memory pointer for strtok_r
+  char *v_str = strtok_r(str, ",", &tok_ptr);
   while (v_str) {
     if ((p = strchr(v_str, '-'))) { // process a range
       *p = '\0';                    // terminate first index
@@ -217,7 +219,7 @@ Status read_idx_list(char *str, vector<int> &nums, int num_idxs,
       }
       nums.push_back(idx + extra * num_idxs);
     }
-    v_str = strtok(nullptr, ",");
+    v_str = strtok_r(nullptr, ",", &tok_ptr);
   }
 
   return Status::ok();
@@ -254,7 +256,8 @@ static Status read_double_list(char *str, vector<double> &nums, int len,
 {
   nums.clear();
   double num;
-  char *num_str = strtok(str, sep);
+  char *tok_ptr; // memory pointer for strtok_r
+  char *num_str = strtok_r(str, sep, &tok_ptr);
   int i = 0;
   while (num_str) {
     i++;
@@ -267,7 +270,7 @@ static Status read_double_list(char *str, vector<double> &nums, int len,
       return Status::error(msg_str("more than %d numbers given", len));
 
     nums.push_back(num);
-    num_str = strtok(nullptr, sep);
+    num_str = strtok_r(nullptr, sep, &tok_ptr);
   }
 
   return Status::ok();
@@ -363,11 +366,12 @@ int split_line(char *line, vector<char *> &parts, const char *delims,
   }
   else {
     char *val;
-    if (!(val = strtok(line, delims)))
+    char *tok_ptr; // memory pointer for strtok_r
+    if (!(val = strtok_r(line, delims, &tok_ptr)))
       return 0;
 
     parts.push_back(val);
-    while ((val = strtok(nullptr, delims)))
+    while ((val = strtok_r(nullptr, delims, &tok_ptr)))
       parts.push_back(val);
   }
 
@@ -428,10 +432,10 @@ char *copy_str(const char *str)
   return p;
 }
 
-FILE *fopen_file(string &fpath)
+FILE *fopen_file(string &fpath, const char *mode = "r")
 {
   backslash_to_forward(fpath);
-  FILE *file = fopen(fpath.c_str(), "r");
+  FILE *file = fopen(fpath.c_str(), mode);
   if (file) {
     struct stat st;
     fstat(fileno(file), &st);
@@ -462,11 +466,12 @@ string find_alt_name(FILE *afile, const char *a_name)
       *first_hash = '\0';
 
     char *altname, *name;
+    char *tok_ptr; // memory pointer for strtok_r
     // skip lines without =
-    if (!(altname = strtok(line, "=")))
+    if (!(altname = strtok_r(line, "=", &tok_ptr)))
       continue;
 
-    if ((name = strtok(nullptr, "\n"))) {
+    if ((name = strtok_r(nullptr, "\n", &tok_ptr))) {
       if (strcasecmp(clear_extra_whitespace(altname), aname) == 0) {
         clear_extra_whitespace(name);
         for (char *p = name; *p; p++)
@@ -493,7 +498,7 @@ string find_alt_name(const char *fname, const char *subdir)
 }
 
 FILE *open_file_data(const string &dir, const string &fname,
-                     string *aname = nullptr)
+                     string *aname = nullptr, const char *mode = "r")
 {
   if (aname)
     *aname = "";
@@ -510,7 +515,7 @@ FILE *open_file_data(const string &dir, const string &fname,
   // don't allow escape from data directory
   if (!strchr(f_name, '\\') && !strchr(f_name, '/')) {
     fpath = dir + f_name;
-    if ((file = fopen_file(fpath)))
+    if ((file = fopen_file(fpath, mode)))
       return file;
   }
   string alt_names_file = "alt_names.txt";
@@ -522,7 +527,7 @@ FILE *open_file_data(const string &dir, const string &fname,
     if (name != "" && !strchr(name.c_str(), '\\') &&
         !strchr(name.c_str(), '/')) {
       fpath = dir + name;
-      if ((file = fopen_file(fpath)))
+      if ((file = fopen_file(fpath, mode)))
         return file;
     }
     *aname = name; // may be used to open an internal resource
@@ -532,7 +537,7 @@ FILE *open_file_data(const string &dir, const string &fname,
 }
 
 FILE *open_sup_file(const char *fname, const char *subdir, string *alt_name,
-                    int *where, string *fpath)
+                    int *where, string *fpath, const char *mode)
 {
   string alt_nam;
   if (!alt_name)
@@ -551,11 +556,11 @@ FILE *open_sup_file(const char *fname, const char *subdir, string *alt_name,
   // try to open fname alone
   *fpath = fname;
   *where = 0; // local
-  if ((file = fopen_file(*fpath)))
+  if ((file = fopen_file(*fpath, mode)))
     return file;
 
   // The file open will fail, but will read alt_name.txt in local directory
-  if ((file = open_file_data("", *fpath, alt_name)))
+  if ((file = open_file_data("", *fpath, alt_name, mode)))
     return file;
   if (*alt_name != "")
     return nullptr;
@@ -565,7 +570,7 @@ FILE *open_sup_file(const char *fname, const char *subdir, string *alt_name,
   if (sup_dir) {
     *where = 1; // environment
     string fdir = string(sup_dir) + subdir;
-    if ((file = open_file_data(fdir, *fpath, alt_name)))
+    if ((file = open_file_data(fdir, *fpath, alt_name, mode)))
       return file;
     if (*alt_name != "")
       return nullptr;
@@ -574,7 +579,7 @@ FILE *open_sup_file(const char *fname, const char *subdir, string *alt_name,
   // try hardcoded install path for data directory
   *where = 2; // installed
   string fdir = string(SUPDIR) + subdir;
-  if ((file = open_file_data(fdir, *fpath, alt_name)))
+  if ((file = open_file_data(fdir, *fpath, alt_name, mode)))
     return file;
   if (*alt_name != "")
     return nullptr;
@@ -228,10 +228,11 @@ char *to_resource_name(char *to, const char *from);
  *  <li>\c 2 - in the installation data directory
  *  </ul>
  * \param fpath used to return the full path to the file that was found.
+ * \param mode the fopen() mode, \c "rb" to read in binary mode.
  * \return A pointer to the opened file stream. */
 FILE *open_sup_file(const char *fname, const char *subdir,
                     std::string *alt_name = nullptr, int *where = nullptr,
-                    std::string *fpath = nullptr);
+                    std::string *fpath = nullptr, const char *mode = "r");
 
 /// Convert a C formated message string to a C++ string
 /** Converts the first MSG_SZ-1 characters of the C format string
@@ -29,6 +29,7 @@
 #include <string>
 #include <vector>
 
+#include "profile.h"
 #include "symmetry.h"
 #include "vrmlwriter.h"
 
@@ -68,6 +69,7 @@ string vrml_col(const Color &col)
 
 void VrmlWriter::write(FILE *ofile, Scene &scen, int sig_digits)
 {
+  ProfileScope prof("vrml_write");
   header(ofile);
   scene_header(ofile, scen);
   cameras(ofile, scen);
@@ -31,6 +31,7 @@
 
 #include "geometry.h"
 #include "geometryinfo.h"
+#include "profile.h"
 #include "symmetry.h"
 #include "tiling.h"
 #include "utils.h"
@@ -481,7 +482,8 @@ Status Wythoff::read_symbol(const char *sym)
   Status stat;
   char fracs_str[MSG_SZ];
   strncpy(fracs_str, sym_norm2.c_str(), MSG_SZ);
-  char *frac_p = strtok(fracs_str, " ");
+  char *tok_ptr; // memory pointer for strtok_r
+  char *frac_p = strtok_r(fracs_str, " ", &tok_ptr);
   for (int f = 0; f < 3; f++) {
     if (!frac_p)
       return Status::error("internal symbol parsing error");
@@ -513,7 +515,7 @@ Status Wythoff::read_symbol(const char *sym)
     fracs[2 * f] = numerator;
     fracs[2 * f + 1] = denominator % numerator;
 
-    frac_p = strtok(nullptr, " ");
+    frac_p = strtok_r(nullptr, " ", &tok_ptr);
   }
 
   bar_pos = bar_pstn; // clears failure value
@@ -1568,6 +1570,7 @@ static void store_tri(map<vector<int>, pair<int, int>> &elem_to_tri,
 Status Tiling::make_tiling(Geometry &geom, ColoringType col_type,
                            vector<Tile::TileReport> *tile_reports) const
 {
+  ProfileScope prof("make_tiling");
   geom.clear_all();
   if (tile_reports)
     tile_reports->resize(pat_paths.size());
@@ -0,0 +1,615 @@
+/*
+   Copyright (c) 2006-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*
+   Name: anti_bench.cc
+   Description: time library operations on generated models
+   Project: Antiprism - http://www.antiprism.com
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../base/antiprism.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+using namespace anti;
+
+// A benchmark. The input is made once, and each timed run works on a copy
+// of it. A scratch file is available to both, for reading and writing.
+struct Bench {
+  const char *name;
+  const char *kind; // micro or macro
+  const char *desc;
+  std::function<Status(Geometry &, FILE *, double)> make_input;
+  std::function<Status(Geometry &, FILE *)> run;
+};
+
+struct BenchResult {
+  string name;
+  string kind;
+  int verts;
+  int faces;
+  double mem_kb;       // estimated memory used by the final model
+  long peak_growth_kb; // increase in peak memory use, -1 if not known
+  double min_ms;
+  double median_ms;
+  double mean_ms;
+};
+
+class bench_opts : public ProgramOpts {
+public:
+  vector<string> names;
+  int reps;
+  double scale;
+  string baseline;
+  double threshold;
+  bool list_only;
+  string ofile;
+
+  bench_opts()
+      : ProgramOpts("anti_bench"), reps(5), scale(1.0), threshold(10.0),
+        list_only(false)
+  {
+  }
+  void process_command_line(int argc, char **argv);
+  void usage();
+};
+
+// clang-format off
+void bench_opts::usage()
+{
+   fprintf(stdout,
+"\n"
+"Usage: %s [options]\n"
+"\n"
+"Time library operations on models generated from the built-in resources.\n"
+"Micro benchmarks time a single operation, macro benchmarks time a chain\n"
+"of operations. Each benchmark is run once untimed, and then timed. The\n"
+"results, including times and memory use, are written in JSON format. With\n"
+"-c, the median times are compared with those in a saved results file, and\n"
+"the exit status is 1 if any benchmark is slower by more than the threshold.\n"
+"\n"
+"Options\n"
+"%s"
+"  -L        list the benchmarks and exit\n"
+"  -b <list> benchmarks to run, a comma separated list of names, or micro\n"
+"            or macro for all benchmarks of that kind (default: all)\n"
+"  -r <num>  number of timed runs of each benchmark (default: 5)\n"
+"  -s <fact> scale the size of the generated models by this factor\n"
+"            (default: 1)\n"
+"  -c <file> compare with results saved in file, and print a report to\n"
+"            standard error\n"
+"  -t <perc> percentage increase in median time reported as a regression\n"
+"            (default: 10)\n"
+"  -o <file> write output to file (default: write to standard output)\n"
+"\n"
+"\n", prog_name(), help_ver_text);
+}
+// clang-format on
+
+void bench_opts::process_command_line(int argc, char **argv)
+{
+  opterr = 0;
+  int c;
+
+  handle_long_opts(argc, argv);
+
+  while ((c = getopt(argc, argv, ":hLb:r:s:c:t:o:")) != -1) {
+    if (common_opts(c, optopt))
+      continue;
+
+    switch (c) {
+    case 'L':
+      list_only = true;
+      break;
+
+    case 'b': {
+      vector<char *> parts;
+      split_line(optarg, parts, ",");
+      for (auto part : parts)
+        names.push_back(part);
+      break;
+    }
+
+    case 'r':
+      print_status_or_exit(read_int(optarg, &reps), c);
+      if (reps < 1)
+        error("number of runs must be positive", c);
+      break;
+
+    case 's':
+      print_status_or_exit(read_double(optarg, &scale), c);
+      if (scale <= 0)
+        error("scale factor must be positive", c);
+      break;
+
+    case 'c':
+      baseline = optarg;
+      break;
+
+    case 't':
+      print_status_or_exit(read_double(optarg, &threshold), c);
+      if (threshold < 0)
+        error("threshold cannot be negative", c);
+      break;
+
+    case 'o':
+      ofile = optarg;
+      break;
+
+    default:
+      error("unknown command line error");
+    }
+  }
+
+  if (argc - optind > 0)
+    error("too many arguments");
+}
+
+// Size n scaled by a power of the scale factor, at least 1
+static int scaled(int n, double scale, double power)
+{
+  return std::max(1, int(floor(n * pow(scale, power) + 0.5)));
+}
+
+// Geodesic sphere with icosahedral symmetry
+static Status make_geodesic(Geometry &geom, int freq)
+{
+  return geom.read_resource("geo_" + itostr(freq));
+}
+
+// Separate faces of a geodesic sphere, with no shared vertices
+static Status make_polygon_soup(Geometry &geom, int freq)
+{
+  Geometry geo;
+  Status stat = make_geodesic(geo, freq);
+  if (stat.is_error())
+    return stat;
+  geom.clear_all();
+  for (const auto &face : geo.faces()) {
+    vector<int> new_face;
+    for (int v_idx : face)
+      new_face.push_back(geom.add_vert(geo.verts(v_idx)));
+    geom.add_face(new_face);
+  }
+  return Status::ok();
+}
+
+// Points of the cubic lattice within a ball, each point included twice
+static Status make_lattice_ball(Geometry &geom, int rad)
+{
+  geom.clear_all();
+  for (int i = -rad; i <= rad; i++)
+    for (int j = -rad; j <= rad; j++)
+      for (int k = -rad; k <= rad; k++)
+        if (i * i + j * j + k * k <= rad * rad) {
+          geom.add_vert(Vec3d(i, j, k));
+          geom.add_vert(Vec3d(i, j, k));
+        }
+  return Status::ok();
+}
+
+static Status write_scratch(const Geometry &geom, FILE *scratch)
+{
+  rewind(scratch);
+  geom.write(scratch);
+  if (fflush(scratch) != 0)
+    return Status::error("could not write to scratch file");
+  return Status::ok();
+}
+
+// Apply a Conway operator, as a tiling, and remove any digons
+static Status apply_conway(Geometry &geom, const string &op)
+{
+  Geometry base = geom;
+  Status stat = wythoff_make_tiling(geom, base, op);
+  if (stat.is_error())
+    return stat;
+  vector<int> dels;
+  for (int i = 0; i < (int)geom.faces().size(); i++)
+    if (geom.faces(i).size() < 3)
+      dels.push_back(i);
+  geom.del(FACES, dels);
+  geom.orient(1);
+  return Status::ok();
+}
+
+static Status run_info(Geometry &geom)
+{
+  GeometryInfo info(geom);
+  info.num_parts();
+  info.is_oriented();
+  info.genus();
+  info.face_areas();
+  info.dihed_angle_lims();
+  info.volume();
+  info.get_vert_figs();
+  return Status::ok();
+}
+
+static vector<Bench> get_benches()
+{
+  vector<Bench> benches;
+
+  benches.push_back(
+      {"off_write", "micro", "write a geodesic sphere in OFF format",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_geodesic(geom, scaled(40, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *scratch) {
+         return write_scratch(geom, scratch);
+       }});
+
+  benches.push_back(
+      {"off_read", "micro", "read a geodesic sphere in OFF format",
+       [](Geometry &geom, FILE *scratch, double scale) {
+         Status stat = make_geodesic(geom, scaled(40, scale, 0.5));
+         if (stat.is_error())
+           return stat;
+         stat = write_scratch(geom, scratch);
+         geom.clear_all();
+         return stat;
+       },
+       [](Geometry &geom, FILE *scratch) {
+         rewind(scratch);
+         return geom.read(scratch);
+       }});
+
+  benches.push_back(
+      {"merge", "micro", "merge the separate faces of a geodesic sphere",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_polygon_soup(geom, scaled(30, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *) {
+         merge_coincident_elements(geom, "vef");
+         return Status::ok();
+       }});
+
+  benches.push_back(
+      {"symmetry", "micro", "find the symmetry of a geodesic sphere",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_geodesic(geom, scaled(6, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *) {
+         Symmetry sym(geom);
+         return (sym.get_sym_type() == Symmetry::Ih)
+                    ? Status::ok()
+                    : Status::error("symmetry is not Ih");
+       }});
+
+  benches.push_back(
+      {"hull", "micro", "convex hull of lattice points in a ball",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_lattice_ball(geom, scaled(24, scale, 1.0 / 3));
+       },
+       [](Geometry &geom, FILE *) { return geom.set_hull(); }});
+
+  benches.push_back(
+      {"neighbours", "micro", "nearest pair of points of a geodesic sphere",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_geodesic(geom, scaled(80, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *) {
+         KDTree tree(geom.verts());
+         return (tree.min_pair_dist(epsilon) > 0)
+                    ? Status::ok()
+                    : Status::error("no nearest pair found");
+       }});
+
+  benches.push_back(
+      {"geometry_info", "micro", "measure a geodesic sphere",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_geodesic(geom, scaled(30, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *) { return run_info(geom); }});
+
+  benches.push_back(
+      {"canonicalize", "micro", "canonicalize a geodesic sphere",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_geodesic(geom, scaled(6, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *) {
+         canonicalize_mm(geom, 500);
+         return Status::ok();
+       }});
+
+  benches.push_back(
+      {"tiling", "micro", "apply Conway operator k to a geodesic sphere",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_geodesic(geom, scaled(20, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *) { return apply_conway(geom, "k"); }});
+
+  benches.push_back(
+      {"geodesic_chain", "macro",
+       "merge, hull, measure, write geodesic sphere faces",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_polygon_soup(geom, scaled(24, scale, 0.5));
+       },
+       [](Geometry &geom, FILE *scratch) {
+         merge_coincident_elements(geom, "vef");
+         Status stat = geom.set_hull();
+         if (stat.is_error())
+           return stat;
+         run_info(geom);
+         return write_scratch(geom, scratch);
+       }});
+
+  benches.push_back(
+      {"lattice_chain", "macro",
+       "merge, hull, measure and write lattice ball points",
+       [](Geometry &geom, FILE *, double scale) {
+         return make_lattice_ball(geom, scaled(16, scale, 1.0 / 3));
+       },
+       [](Geometry &geom, FILE *scratch) {
+         merge_coincident_elements(geom, "v");
+         Status stat = geom.set_hull();
+         if (stat.is_error())
+           return stat;
+         run_info(geom);
+         return write_scratch(geom, scratch);
+       }});
+
+  benches.push_back(
+      {"conway_chain", "macro",
+       "Conway a, k, t, g on a dodecahedron, canonicalize",
+       [](Geometry &geom, FILE *, double) {
+         return geom.read_resource("dodecahedron");
+       },
+       [](Geometry &geom, FILE *scratch) {
+         for (const char *op : {"a", "k", "t", "g"}) {
+           Status stat = apply_conway(geom, op);
+           if (stat.is_error())
+             return stat;
+         }
+         canonicalize_mm(geom, 100);
+         return write_scratch(geom, scratch);
+       }});
+
+  benches.push_back(
+      {"uniform_johnson", "macro",
+       "find the symmetry of uniform and Johnson polyhedra",
+       [](Geometry &geom, FILE *, double) {
+         geom.clear_all();
+         return Status::ok();
+       },
+       [](Geometry &geom, FILE *) {
+         vector<string> res_names;
+         for (int i = 1; i <= 80; i++)
+           res_names.push_back("u" + itostr(i));
+         for (int i = 1; i <= 92; i++)
+           res_names.push_back("j" + itostr(i));
+         for (const auto &res_name : res_names) {
+           Status stat = geom.read_resource(res_name);
+           if (stat.is_error())
+             return stat;
+           Symmetry sym(geom);
+         }
+         return Status::ok();
+       }});
+
+  return benches;
+}
+
+static double get_median(vector<double> vals)
+{
+  std::sort(vals.begin(), vals.end());
+  int sz = vals.size();
+  return (sz % 2) ? vals[sz / 2] : (vals[sz / 2 - 1] + vals[sz / 2]) / 2;
+}
+
+static Status run_bench(const Bench &bench, int reps, double scale,
+                        BenchResult &res)
+{
+  FILE *scratch = tmpfile();
+  if (!scratch)
+    return Status::error("could not open scratch file");
+
+  Geometry input;
+  Status stat = bench.make_input(input, scratch, scale);
+  long start_rss = get_peak_rss();
+  vector<double> times;
+  Geometry geom;
+  for (int i = 0; i <= reps && stat.is_ok(); i++) { // first run untimed
+    geom = input;
+    auto start = std::chrono::steady_clock::now();
+    stat = bench.run(geom, scratch);
+    std::chrono::duration<double> secs =
+        std::chrono::steady_clock::now() - start;
+    if (i > 0)
+      times.push_back(secs.count() * 1000);
+  }
+  long end_rss = get_peak_rss();
+  fclose(scratch);
+  if (stat.is_error())
+    return Status::error(msg_str("%s: %s", bench.name, stat.c_msg()));
+
+  res.name = bench.name;
+  res.kind = bench.kind;
+  res.verts = geom.verts().size();
+  res.faces = geom.faces().size();
+  res.mem_kb = geom.memory_usage() / 1024.0;
+  res.peak_growth_kb = (start_rss >= 0) ? end_rss - start_rss : -1;
+  res.min_ms = *std::min_element(times.begin(), times.end());
+  res.median_ms = get_median(times);
+  double sum = 0;
+  for (double t : times)
+    sum += t;
+  res.mean_ms = sum / times.size();
+  return Status::ok();
+}
+
+static void write_results(FILE *ofile, const vector<BenchResult> &results,
+                          const bench_opts &opts)
+{
+  fprintf(ofile,
+          "{\"program\":\"anti_bench\",\"threads\":%d,\"reps\":%d,"
+          "\"scale\":%g,\n\"results\":[\n",
+          get_num_threads(), opts.reps, opts.scale);
+  for (unsigned int i = 0; i < results.size(); i++) {
+    const BenchResult &res = results[i];
+    fprintf(ofile,
+            "{\"name\":\"%s\",\"kind\":\"%s\",\"verts\":%d,\"faces\":%d,"
+            "\"mem_kb\":%.1f,\"peak_growth_kb\":%ld,\"min_ms\":%.3f,"
+            "\"median_ms\":%.3f,\"mean_ms\":%.3f}%s\n",
+            res.name.c_str(), res.kind.c_str(), res.verts, res.faces,
+            res.mem_kb, res.peak_growth_kb, res.min_ms, res.median_ms,
+            res.mean_ms,
+            (i < results.size() - 1) ? "," : "");
+  }
+  fprintf(ofile, "]}\n");
+}
+
+// Read the median times from results written by write_results()
+static Status read_baseline(const string &file_name,
+                            map<string, double> &medians)
+{
+  FILE *ifile = fopen(file_name.c_str(), "r");
+  if (!ifile)
+    return Status::error(
+        msg_str("could not open baseline file '%s'", file_name.c_str()));
+
+  const char name_key[] = "\"name\":\"";
+  const char median_key[] = "\"median_ms\":";
+  char *line = nullptr;
+  while (read_line(ifile, &line) == 0) {
+    char *name = strstr(line, name_key);
+    char *median = strstr(line, median_key);
+    if (name && median) {
+      name += strlen(name_key);
+      char *name_end = strchr(name, '"');
+      double val;
+      if (name_end && sscanf(median + strlen(median_key), "%lf", &val) == 1)
+        medians[string(name, name_end)] = val;
+    }
+    free(line);
+  }
+  fclose(ifile);
+
+  if (medians.empty())
+    return Status::error(
+        msg_str("no results found in baseline file '%s'", file_name.c_str()));
+  return Status::ok();
+}
+
+// Print a comparison report, and return the number of regressions
+static int compare_results(const vector<BenchResult> &results,
+                           const map<string, double> &medians,
+                           double threshold)
+{
+  int num_regressions = 0;
+  fprintf(stderr, "%-20s %12s %12s %9s\n", "benchmark", "baseline(ms)",
+          "current(ms)", "change");
+  for (const auto &res : results) {
+    auto mi = medians.find(res.name);
+    if (mi == medians.end()) {
+      fprintf(stderr, "%-20s %12s %12.3f %9s\n", res.name.c_str(), "-",
+              res.median_ms, "new");
+      continue;
+    }
+    double change = (mi->second > 0)
+                        ? 100 * (res.median_ms - mi->second) / mi->second
+                        : 0.0;
+    bool regressed = change > threshold;
+    if (regressed)
+      num_regressions++;
+    fprintf(stderr, "%-20s %12.3f %12.3f %+8.1f%%%s\n", res.name.c_str(),
+            mi->second, res.median_ms, change,
+            (regressed) ? "  REGRESSION" : "");
+  }
+  return num_regressions;
+}
+
+int main(int argc, char *argv[])
+{
+  bench_opts opts;
+  opts.process_command_line(argc, argv);
+
+  vector<Bench> benches = get_benches();
+  if (opts.list_only) {
+    for (const auto &bench : benches)
+      fprintf(stdout, "%-20s %-6s %s\n", bench.name, bench.kind, bench.desc);
+    return 0;
+  }
+
+  vector<const Bench *> selected;
+  for (const auto &bench : benches) {
+    bool sel = opts.names.empty();
+    for (const auto &name : opts.names)
+      if (name == bench.name || name == bench.kind)
+        sel = true;
+    if (sel)
+      selected.push_back(&bench);
+  }
+  for (const auto &name : opts.names) {
+    auto same_name = [&name](const Bench &bench) {
+      return name == bench.name || name == bench.kind;
+    };
+    if (std::find_if(benches.begin(), benches.end(), same_name) ==
+        benches.end())
+      opts.error(msg_str("unknown benchmark '%s'", name.c_str()), 'b');
+  }
+
+  map<string, double> medians;
+  if (opts.baseline != "")
+    opts.print_status_or_exit(read_baseline(opts.baseline, medians), 'c');
+
+  vector<BenchResult> results(selected.size());
+  for (unsigned int i = 0; i < selected.size(); i++)
+    opts.print_status_or_exit(
+        run_bench(*selected[i], opts.reps, opts.scale, results[i]));
+
+  FILE *ofile = stdout;
+  if (opts.ofile != "" && !(ofile = fopen(opts.ofile.c_str(), "w")))
+    opts.error(msg_str("could not open output file '%s'", opts.ofile.c_str()),
+               'o');
+  write_results(ofile, results, opts);
+  if (ofile != stdout)
+    fclose(ofile);
+
+  if (opts.baseline != "") {
+    int num_regressions = compare_results(results, medians, opts.threshold);
+    if (num_regressions) {
+      opts.warning(msg_str("%d benchmark%s slower by more than %g%%",
+                           num_regressions, (num_regressions > 1) ? "s" : "",
+                           opts.threshold));
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,432 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*
+   Name: batch.cc
+   Description: batch processing of models, with a record for each model
+   Project: Antiprism - http://www.antiprism.com
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#endif
+
+#include "batch.h"
+#include "rep_print.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+
+using namespace anti;
+
+// Models are processed in blocks of this size, and the records of a block
+// are written before the next block is started
+static const int batch_block_sz = 64;
+
+static bool is_directory(const string &fname)
+{
+  struct stat st;
+  return stat(fname.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static const char whitespace[] = " \t\r\n\f\v";
+
+// The first token of a line which is not a comment holds "OFF"
+static bool is_off_header(const char *line)
+{
+  line += strspn(line, whitespace);
+  if (*line == '#' || *line == '\0')
+    return false;
+  const char *end = line + strcspn(line, whitespace);
+  const char *off = strstr(line, "OFF");
+  return off && off < end;
+}
+
+Status BatchInputs::add_stream(FILE *file, const string &name)
+{
+  // A model starts at a '# model <name>' line, as in an archive, or at
+  // an OFF header line that is not the first in the current model
+  const char *model_tag = "# model ";
+  const size_t model_tag_len = strlen(model_tag);
+  vector<string> names;
+  bool in_header = false; // current model has its OFF header
+  char *line;
+  int ret;
+  while ((ret = read_line(file, &line)) == 0) {
+    if (strncmp(line, model_tag, model_tag_len) == 0) {
+      names.push_back(line + model_tag_len);
+      stream_models.push_back("");
+      in_header = false;
+    }
+    else if (strncmp(line, "# index", 7) == 0) {
+      free(line);
+      break; // the archive index follows the models
+    }
+    else if (is_off_header(line)) {
+      if (in_header || !names.size()) {
+        names.push_back(itostr(names.size()));
+        stream_models.push_back("");
+      }
+      in_header = true;
+    }
+    if (names.size() && strncmp(line, model_tag, model_tag_len) != 0) {
+      stream_models.back() += line;
+      stream_models.back() += '\n';
+    }
+    free(line);
+  }
+  if (ret < 0)
+    return Status::error(msg_str("%s: could not read", name.c_str()));
+
+  int first = stream_models.size() - names.size();
+  for (unsigned int i = 0; i < names.size(); i++)
+    inputs.push_back({name + "#" + names[i], "", nullptr, first + (int)i});
+
+  return Status::ok();
+}
+
+Status BatchInputs::add_file(const string &fname)
+{
+  if (!Archive::is_archive(fname)) {
+    inputs.push_back({fname, fname, nullptr, 0});
+    return Status::ok();
+  }
+
+  archives.emplace_back(new Archive);
+  Archive *arc = archives.back().get();
+  Status stat = arc->open(fname);
+  if (stat.is_error())
+    return stat;
+  for (int i = 0; i < arc->size(); i++)
+    inputs.push_back({fname + "#" + arc->get_index()[i].name, "", arc, i});
+
+  return Status::ok();
+}
+
+Status BatchInputs::add(const string &name)
+{
+  if (name == "" || name == "-")
+    return add_stream(stdin, "stdin");
+
+  if (!is_directory(name))
+    return add_file(name);
+
+  DIR *dir = opendir(name.c_str());
+  if (!dir)
+    return Status::error(
+        msg_str("could not open directory '%s'", name.c_str()));
+
+  // OFF files and archives, in name order
+  vector<string> fnames;
+  struct dirent *ent;
+  while ((ent = readdir(dir))) {
+    string fname = name + "/" + ent->d_name;
+    size_t len = strlen(ent->d_name);
+    if (is_directory(fname))
+      continue;
+    if ((len > 4 && strcmp(ent->d_name + len - 4, ".off") == 0) ||
+        Archive::is_archive(fname))
+      fnames.push_back(fname);
+  }
+  closedir(dir);
+  std::sort(fnames.begin(), fnames.end());
+
+  Status stat;
+  for (auto &fname : fnames)
+    if ((stat = add_file(fname)).is_error())
+      return stat;
+
+  return Status::ok();
+}
+
+Status BatchInputs::read(int idx, Geometry &geom) const
+{
+  const Input &in = inputs[idx];
+  if (in.arc)
+    return in.arc->read(in.idx, geom);
+  else if (in.fname != "")
+    return geom.read(in.fname);
+
+  geom.clear_all();
+  const string &text = stream_models[in.idx];
+#ifdef HAVE_FMEMOPEN
+  FILE *file = fmemopen((void *)text.data(), text.size(), "r");
+#else
+  FILE *file = tmpfile();
+  if (file) {
+    fwrite(text.data(), 1, text.size(), file);
+    rewind(file);
+  }
+#endif
+  if (!file)
+    return Status::error(msg_str("%s: could not read", in.name.c_str()));
+
+  Status stat = geom.read(file);
+  fclose(file);
+  string msg = msg_str("%s: %s", in.name.c_str(), stat.c_msg());
+  if (stat.is_error())
+    stat.set_error(msg);
+  else if (stat.is_warning())
+    stat.set_warning(msg);
+  return stat;
+}
+
+// A value which is a number, in a form that is valid in JSON
+static bool is_number(const string &val)
+{
+  const char *str = val.c_str();
+  const char *digits = (*str == '-') ? str + 1 : str;
+  if (!isdigit(*digits) || strspn(str, "0123456789+-.eE") != val.size())
+    return false;
+  char *end;
+  strtod(str, &end);
+  return *end == '\0';
+}
+
+static void write_json_str(FILE *ofile, const string &str)
+{
+  fputc('"', ofile);
+  for (unsigned char c : str) {
+    if (c == '"' || c == '\\')
+      fprintf(ofile, "\\%c", c);
+    else if (c == '\n')
+      fputs("\\n", ofile);
+    else if (c == '\t')
+      fputs("\\t", ofile);
+    else if (c < 0x20)
+      fprintf(ofile, "\\u%04x", c);
+    else
+      fputc(c, ofile);
+  }
+  fputc('"', ofile);
+}
+
+static void write_csv_val(FILE *ofile, const string &val)
+{
+  if (val.find_first_of(",\"\n\r") == string::npos) {
+    fputs(val.c_str(), ofile);
+    return;
+  }
+  fputc('"', ofile);
+  for (char c : val) {
+    if (c == '"')
+      fputc('"', ofile);
+    fputc(c, ofile);
+  }
+  fputc('"', ofile);
+}
+
+void BatchWriter::write(const BatchRecord &rec)
+{
+  if (format == 'c') {
+    records.push_back(rec);
+    return;
+  }
+
+  fputc('{', ofile);
+  for (unsigned int i = 0; i < rec.size(); i++) {
+    if (i)
+      fputs(", ", ofile);
+    write_json_str(ofile, rec[i].first);
+    fputs(": ", ofile);
+    if (is_number(rec[i].second))
+      fputs(rec[i].second.c_str(), ofile);
+    else
+      write_json_str(ofile, rec[i].second);
+  }
+  fputs("}\n", ofile);
+}
+
+void BatchWriter::finish()
+{
+  if (format != 'c')
+    return;
+
+  // Columns are the field names, in the order they were first seen
+  vector<string> cols;
+  map<string, int> col_idxs;
+  for (auto &rec : records)
+    for (auto &field : rec)
+      if (col_idxs.insert(std::make_pair(field.first, cols.size())).second)
+        cols.push_back(field.first);
+
+  for (unsigned int i = 0; i < cols.size(); i++) {
+    if (i)
+      fputc(',', ofile);
+    write_csv_val(ofile, cols[i]);
+  }
+  fputc('\n', ofile);
+
+  vector<string> vals;
+  for (auto &rec : records) {
+    vals.assign(cols.size(), "");
+    for (auto &field : rec)
+      vals[col_idxs[field.first]] = field.second;
+    for (unsigned int i = 0; i < vals.size(); i++) {
+      if (i)
+        fputc(',', ofile);
+      write_csv_val(ofile, vals[i]);
+    }
+    fputc('\n', ofile);
+  }
+  records.clear();
+}
+
+Status read_batch_format(const char *str, char *fmt)
+{
+  if (strcmp(str, "j") == 0 || strcmp(str, "json") == 0)
+    *fmt = 'j';
+  else if (strcmp(str, "c") == 0 || strcmp(str, "csv") == 0)
+    *fmt = 'c';
+  else
+    return Status::error(
+        msg_str("batch format is '%s', must be j (JSON lines) or c (CSV)",
+                str));
+  return Status::ok();
+}
+
+Status option_status(const Status &stat, char opt)
+{
+  Status opt_stat = stat;
+  string msg = msg_str("option -%c: %s", opt, stat.c_msg());
+  if (stat.is_error())
+    opt_stat.set_error(msg);
+  else if (stat.is_warning())
+    opt_stat.set_warning(msg);
+  return opt_stat;
+}
+
+string capture_output(const std::function<void(FILE *)> &print)
+{
+  string text;
+  FILE *file = tmpfile();
+  if (!file)
+    return text;
+  print(file);
+  long len = ftell(file);
+  if (len > 0) {
+    text.resize(len);
+    rewind(file);
+    text.resize(fread(&text[0], 1, len, file));
+  }
+  fclose(file);
+  return text;
+}
+
+void add_report_fields(BatchRecord &rec, const string &report)
+{
+  string sec;
+  int line_no = 0;
+  size_t pos = 0;
+  while (pos < report.size()) {
+    size_t end = report.find('\n', pos);
+    if (end == string::npos)
+      end = report.size();
+    string line = report.substr(pos, end - pos);
+    pos = end + 1;
+
+    if (line == "")
+      continue;
+    if (line[0] == '[' && line[line.size() - 1] == ']') {
+      sec = line.substr(1, line.size() - 2);
+      line_no = 0;
+      continue;
+    }
+    string prefix = (sec != "") ? sec + "." : string();
+    size_t eq = line.find(" = ");
+    if (eq != string::npos)
+      rec.push_back(
+          std::make_pair(prefix + line.substr(0, eq), line.substr(eq + 3)));
+    else
+      rec.push_back(std::make_pair(prefix + itostr(line_no), line));
+    line_no++;
+  }
+}
+
+void add_general_fields(BatchRecord &rec, Geometry &geom)
+{
+  geom.add_missing_impl_edges();
+  add_report_fields(rec, capture_output([&](FILE *file) {
+                      rep_printer rep(geom, file);
+                      rep.set_sig_dgts(17);
+                      rep.set_center(Vec3d(0, 0, 0));
+                      rep.is_oriented(); // set oriented value before orienting
+                      geom.orient();
+                      if (GeometryInfo(geom).volume() < 0) // inefficient
+                        geom.orient_reverse();
+                      rep.general_sec();
+                    }));
+}
+
+void run_batch(
+    const BatchInputs &inputs,
+    const std::function<Status(int, Geometry &, BatchRecord &)> &process,
+    BatchWriter &writer)
+{
+  int num_models = inputs.size();
+  for (int start = 0; start < num_models; start += batch_block_sz) {
+    int blk_sz = std::min(batch_block_sz, num_models - start);
+    vector<BatchRecord> recs(blk_sz);
+    parallel_for(0, blk_sz, [&](long i) {
+      int idx = start + i;
+      BatchRecord &rec = recs[i];
+      Geometry geom;
+      Status stat = inputs.read(idx, geom);
+      string warn;
+      if (stat.is_warning())
+        warn = stat.msg();
+      if (!stat.is_error()) {
+        stat = process(idx, geom, rec);
+        if (stat.is_warning())
+          warn += ((warn != "") ? "; " : "") + stat.msg();
+      }
+
+      BatchRecord head;
+      head.push_back(std::make_pair("file", inputs.get_name(idx)));
+      if (stat.is_error()) {
+        head.push_back(std::make_pair("error", stat.msg()));
+        rec.clear();
+      }
+      else if (warn != "")
+        head.push_back(std::make_pair("warning", warn));
+      rec.insert(rec.begin(), head.begin(), head.end());
+    });
+
+    for (auto &rec : recs)
+      writer.write(rec);
+  }
+  writer.finish();
+}
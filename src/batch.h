@@ -0,0 +1,164 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*
+   Name: batch.h
+   Description: batch processing of models, with a record for each model
+   Project: Antiprism - http://www.antiprism.com
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../base/antiprism.h"
+
+/// A record of named values, in the order they were added
+typedef std::vector<std::pair<std::string, std::string>> BatchRecord;
+
+/// The models for a batch run
+/** An input may be an OFF file, an archive, which gives all the models it
+ *  holds, a directory, which gives its OFF files and archives in name
+ *  order, or standard input, which may hold several OFF files one after
+ *  the other, or an archive. */
+class BatchInputs {
+private:
+  struct Input {
+    std::string name;          // name for the record
+    std::string fname;         // file to read, if not from an archive
+    const anti::Archive *arc;  // archive holding the model, or null
+    int idx;                   // index in the archive or stream models
+  };
+  std::vector<Input> inputs;
+  std::vector<std::unique_ptr<anti::Archive>> archives;
+  std::vector<std::string> stream_models; // OFF text of streamed models
+
+  anti::Status add_stream(FILE *file, const std::string &name);
+  anti::Status add_file(const std::string &fname);
+
+public:
+  /// Add an input
+  /**\param name a file or directory name, or "" or "-" for standard input.
+   * \return status, evaluates to \c true if the input was added,
+   *  otherwise \c false. */
+  anti::Status add(const std::string &name);
+
+  /// Get the number of models
+  /**\return The number of models. */
+  int size() const { return inputs.size(); }
+
+  /// Get the name of a model
+  /**\param idx the index number of the model.
+   * \return The model name, the file name, or for a model in an archive
+   *  or stream, a name of the form \c file#model. */
+  const std::string &get_name(int idx) const { return inputs[idx].name; }
+
+  /// Read a model
+  /**\param idx the index number of the model.
+   * \param geom used to return the model.
+   * \return status, evaluates to \c true if the model was read,
+   *  otherwise \c false. */
+  anti::Status read(int idx, anti::Geometry &geom) const;
+};
+
+/// Write batch records as JSON lines or CSV
+/** JSON lines records are written as they are given. CSV records are held
+ *  until finish() is called, and the header is the union of the field
+ *  names, in the order they were first seen. JSON values which are numbers
+ *  are written as numbers, and CSV values are only quoted where needed. */
+class BatchWriter {
+private:
+  FILE *ofile;
+  char format;
+  std::vector<BatchRecord> records;
+
+public:
+  /// Constructor
+  /**\param outfile the stream to write to.
+   * \param fmt the format, \c j for JSON lines or \c c for CSV. */
+  BatchWriter(FILE *outfile, char fmt) : ofile(outfile), format(fmt) {}
+
+  /// Write a record
+  /**\param rec the record. */
+  void write(const BatchRecord &rec);
+
+  /// Finish writing, for CSV write the held records
+  void finish();
+};
+
+/// Read a batch format letter
+/**\param str the format, \c j or \c json for JSON lines, \c c or \c csv
+ *  for CSV.
+ * \param fmt used to return the format letter, \c j or \c c.
+ * \return status, evaluates to \c true if the format was valid,
+ *  otherwise \c false. */
+anti::Status read_batch_format(const char *str, char *fmt);
+
+/// Add an option letter to a status message
+/**\param stat the status.
+ * \param opt the option letter.
+ * \return The status, with the message in the form an option message is
+ *  reported by ProgramOpts. */
+anti::Status option_status(const anti::Status &stat, char opt);
+
+/// Capture the text printed to a stream
+/**\param print a function that prints to the stream it is passed.
+ * \return The text that was printed. */
+std::string capture_output(const std::function<void(FILE *)> &print);
+
+/// Add the values of an INI style report to a record
+/** A line of the form <tt>key = value</tt> in section \c sec gives the field
+ *  \c sec.key, and any other line gives the field \c sec.N, where \c N is
+ *  the number of the line in the section, starting from 0.
+ * \param rec the record to add to.
+ * \param report the report text, as printed by rep_printer. */
+void add_report_fields(BatchRecord &rec, const std::string &report);
+
+/// Add the general report values for a model to a record
+/** The values are those of <tt>off_report -S G</tt>.
+ * \param rec the record to add to.
+ * \param geom the model, which is oriented. */
+void add_general_fields(BatchRecord &rec, anti::Geometry &geom);
+
+/// Process the models of a batch, and write a record for each
+/** The models are processed on several threads, and the records are
+ *  written in the order of the inputs. Each record starts with a \c file
+ *  field, and if the model could not be read or processed it has an
+ *  \c error field, otherwise any warning is given in a \c warning field.
+ * \param inputs the models.
+ * \param process the function to process a model, taking the model index,
+ *  the model and the record to add values to.
+ * \param writer where to write the records. */
+void run_batch(const BatchInputs &inputs,
+               const std::function<anti::Status(int, anti::Geometry &,
+                                                BatchRecord &)> &process,
+               BatchWriter &writer);
+
+#endif // BATCH_H
@@ -33,21 +33,25 @@
 #include <stdlib.h>
 
 #include <string>
+#include <vector>
 
 #include "../base/antiprism.h"
+#include "batch.h"
 
 using std::string;
+using std::vector;
 
 using namespace anti;
 
 class ch_opts : public ProgramOpts {
 public:
   bool append_flg;
-  string ifile;
+  char batch_fmt;
+  vector<string> ifiles;
   string ofile;
   string qh_args;
 
-  ch_opts() : ProgramOpts("conv_hull"), append_flg(false) {}
+  ch_opts() : ProgramOpts("conv_hull"), append_flg(false), batch_fmt('\0') {}
   void process_command_line(int argc, char **argv);
   void usage();
 };
@@ -58,9 +62,12 @@ void ch_opts::usage()
    fprintf(stdout,
 "\n"
 "Usage: %s [options] [input_file]\n"
+"       %s -B <fmt> [options] [inputs]\n"
 "\n"
 "Read a file in OFF format and make a convex hull (using Qhull). If\n"
-"input_file is not given the program reads from standard input.\n"
+"input_file is not given the program reads from standard input. With option\n"
+"-B, make the hulls of a batch of models, from files, directories of OFF\n"
+"files, archives, or OFF files one after another on standard input.\n"
 "\n"
 "Options\n"
 "%s"
@@ -68,8 +75,12 @@ void ch_opts::usage()
 "  -Q <args> additional arguments to pass to qhull (unsupported, may not\n"
 "            work, check output)\n"
 "  -o <file> write output to file (default: write to standard output)\n"
+"  -B <fmt>  batch mode, write a record for each hull, with the dimension\n"
+"            and the off_report general values, in the order of the inputs,\n"
+"            to standard output, and write the hulls to archive file -o,\n"
+"            fmt is j - JSON lines, c - CSV\n"
 "\n"
-"\n", prog_name(), help_ver_text);
+"\n", prog_name(), prog_name(), help_ver_text);
 }
 // clang-format on
 
@@ -80,7 +91,7 @@ void ch_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":haQ:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":haQ:o:B:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -97,16 +108,61 @@ void ch_opts::process_command_line(int argc, char **argv)
       qh_args = optarg;
       break;
 
+    case 'B':
+      print_status_or_exit(read_batch_format(optarg, &batch_fmt), c);
+      break;
+
     default:
       error("unknown command line error");
     }
   }
 
-  if (argc - optind > 1)
+  if (!batch_fmt && argc - optind > 1)
     error("too many arguments");
 
-  if (argc - optind == 1)
-    ifile = argv[optind];
+  while (argc - optind)
+    ifiles.push_back(argv[optind++]);
+  if (!ifiles.size())
+    ifiles.push_back("");
+}
+
+// Make hulls of a batch of models, any hulls that are made are written
+// to an archive
+void make_hulls(ch_opts &opts)
+{
+  BatchInputs inputs;
+  for (auto &ifile : opts.ifiles)
+    opts.print_status_or_exit(inputs.add(ifile));
+
+  ArchiveWriter arc;
+  if (opts.ofile != "")
+    opts.print_status_or_exit(arc.open(opts.ofile), 'o');
+
+  vector<Geometry> hulls(inputs.size());
+  BatchWriter writer(stdout, opts.batch_fmt);
+  run_batch(
+      inputs,
+      [&](int idx, Geometry &geom, BatchRecord &rec) {
+        int dimension;
+        Status stat = (opts.append_flg)
+                          ? geom.add_hull(opts.qh_args, &dimension)
+                          : geom.set_hull(opts.qh_args, &dimension);
+        if (stat.is_error())
+          return stat;
+        if (opts.ofile != "")
+          hulls[idx] = geom;
+        rec.push_back(std::make_pair("dimension", itostr(dimension)));
+        add_general_fields(rec, geom);
+        return stat;
+      },
+      writer);
+
+  if (opts.ofile != "") {
+    for (int i = 0; i < inputs.size(); i++)
+      if (hulls[i].is_set())
+        opts.print_status_or_exit(arc.add(inputs.get_name(i), hulls[i]), 'o');
+    opts.print_status_or_exit(arc.close(), 'o');
+  }
 }
 
 int main(int argc, char *argv[])
@@ -114,8 +170,13 @@ int main(int argc, char *argv[])
   ch_opts opts;
   opts.process_command_line(argc, argv);
 
+  if (opts.batch_fmt) {
+    make_hulls(opts);
+    return 0;
+  }
+
   Geometry geom;
-  opts.read_or_error(geom, opts.ifile);
+  opts.read_or_error(geom, opts.ifiles[0]);
 
   int dimension;
   Status stat = (opts.append_flg) ? geom.add_hull(opts.qh_args, &dimension)
@@ -51,12 +51,13 @@ public:
   char method;
   bool keep_flat;
   bool equal_len_div;
+  bool stream_out;
   string ifile;
   string ofile;
 
   geo_opts()
       : ProgramOpts("geodesic"), centre(Vec3d(0, 0, 0)), m(1), n(0),
-        pat_freq(1), use_step_freq(false), method('s')
+        pat_freq(1), use_step_freq(false), method('s'), stream_out(false)
   {
   }
   void process_command_line(int argc, char **argv);
@@ -95,6 +96,8 @@ void geo_opts::usage()
 "                surface of the original polyhedron.\n"
 "  -C <cent> centre of points, in form \"x_val,y_val,z_val\" (default: 0,0,0)\n"
 "            used for geodesic spheres\n"
+"  -S        stream output, write faces as they are generated, without\n"
+"            holding the whole model in memory (for very high frequencies)\n"
 "  -o <file> write output to file (default: write to standard output)\n"
 "\n"
 "\n", prog_name(), help_ver_text);
@@ -108,7 +111,7 @@ void geo_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hf:F:c:M:C:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hf:F:c:M:C:So:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -166,6 +169,10 @@ void geo_opts::process_command_line(int argc, char **argv)
               c);
       break;
 
+    case 'S':
+      stream_out = true;
+      break;
+
     case 'o':
       ofile = optarg;
       break;
@@ -207,6 +214,25 @@ int main(int argc, char **argv)
   Geometry geom;
   opts.read_or_error(geom, opts.ifile);
 
+  if (opts.stream_out) {
+    FILE *ofile = stdout;
+    if (opts.ofile != "" && !(ofile = fopen(opts.ofile.c_str(), "w")))
+      opts.error(msg_str("could not output file '%s'", opts.ofile.c_str()),
+                 'o');
+    if (!write_geodesic_off(ofile, geom, opts.m, opts.n, opts.method,
+                            opts.centre))
+      opts.error(msg_str("invalid pattern m=%d, n=%d", opts.m, opts.n));
+    bool write_err = ferror(ofile);
+    if (ofile != stdout)
+      write_err = (fclose(ofile) != 0) || write_err;
+    else
+      write_err = (fflush(ofile) != 0) || write_err;
+    if (write_err)
+      opts.error(msg_str("could not write output file '%s'",
+                         (opts.ofile != "") ? opts.ofile.c_str() : "stdout"));
+    return 0;
+  }
+
   Geometry geo;
   if (opts.method == 's')
     make_geodesic_sphere(geo, geom, opts.m, opts.n, opts.centre);
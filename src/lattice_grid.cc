@@ -555,11 +555,17 @@ void add_color_struts(Geometry &geom, const double len2, Color &edge_col,
 {
   const vector<Vec3d> &verts = geom.verts();
 
-  for (unsigned int i = 0; i < verts.size(); i++)
-    for (unsigned int j = i; j < verts.size(); j++) {
-      if (fabs((verts[i] - verts[j]).len2() - len2) < eps)
+  // only the points in range need to be checked
+  KDTree tree(verts);
+  double rad = sqrt(len2 + eps) + epsilon;
+  vector<int> nbrs;
+  for (unsigned int i = 0; i < verts.size(); i++) {
+    tree.in_radius(verts[i], rad, nbrs);
+    for (int j : nbrs) {
+      if (j >= (int)i && fabs((verts[i] - verts[j]).len2() - len2) < eps)
         geom.add_edge(make_edge(i, j), edge_col);
     }
+  }
 }
 
 void color_centroid(Geometry &geom, Color &cent_col, const double eps)
@@ -65,6 +65,11 @@ public:
   string map_string;
   int face_opacity;
 
+  string cache_dir;
+
+  string batch_nums;
+  string out_dir;
+
   double epsilon;
 
   miller_opts()
@@ -96,9 +101,16 @@ void miller_opts::usage()
 "Options\n"
 "%s"
 "  -L        list models only\n"
+"  -B <nums> batch mode, generate the models with these Miller list numbers\n"
+"            (no input), e.g. 1-75 or 1,8,20-32. Models are made in parallel,\n"
+"            then written in number order to an archive (see off_batch),\n"
+"            with model names mN, e.g. read m8 as out_file#m8\n"
+"  -D <dir>  batch mode, write each model to a file mN.off in directory dir\n"
 "  -M        merge stellation facelets\n"
 "  -r        rebuild compound model to separate vertices\n"
 "  -O <args> output s - stellation, d - diagram (default: s)\n"
+"  -K <dir>  cache stellation diagrams in directory, to reuse in later runs\n"
+"            (default: $ANTIPRISM_STELLATION_CACHE, if set)\n"
 "  -l <lim>  minimum distance for unique vertex locations as negative exponent\n"
 "               (default: %d giving %.0e)\n"
 "  -o <file> write output to file (default: write to standard output)\n"
@@ -128,7 +140,7 @@ void miller_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hLMrO:V:E:F:T:m:l:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hLMrO:K:B:D:V:E:F:T:m:l:o:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -154,6 +166,18 @@ void miller_opts::process_command_line(int argc, char **argv)
       output_parts = optarg;
       break;
 
+    case 'K':
+      cache_dir = optarg;
+      break;
+
+    case 'B':
+      batch_nums = optarg;
+      break;
+
+    case 'D':
+      out_dir = optarg;
+      break;
+
     case 'V':
       if (strchr("e", *optarg))
         vertex_coloring_method = *optarg;
@@ -213,6 +237,13 @@ void miller_opts::process_command_line(int argc, char **argv)
   if (argc - optind == 1)
     ifile = argv[optind];
 
+  if (batch_nums != "") {
+    if (ifile != "")
+      error("input model cannot be given with batch mode", 'B');
+  }
+  else if (out_dir != "")
+    error("output directory can only be used with batch mode", 'D');
+
   epsilon = (sig_compare != INT_MAX) ? pow(10, -sig_compare) : ::epsilon;
 }
 
@@ -649,14 +680,15 @@ int Miller::get_poly(Geometry &geom, int sym, string cell_str, string sym_str, m
 
     read_idx_list((char *)diagram_list_strings[i].c_str(), idx_lists[i], INT_MAX, false);
 
-    // stellation face index is in the first position
-    int stellation_face_idx = idx_lists[i][0];
-
-    // construct the diagrams
-    if (!diagrams[stellation_face_idx].verts().size())
-      diagrams[stellation_face_idx] = make_stellation_diagram(geom, stellation_face_idx, sym_str);
   }
 
+  // construct the diagrams, stellation face index is in the first position
+  vector<int> stellation_face_idxs;
+  for (auto &idx_list : idx_lists)
+    if (idx_list.size())
+      stellation_face_idxs.push_back(idx_list[0]);
+  make_stellation_diagrams(geom, diagrams, stellation_face_idxs, sym_str);
+
   bool merge_faces = opts.merge_faces;
   bool remove_inline_verts = Miller_items[sym].remove_inline_verts;
   bool split_pinched = true;
@@ -816,6 +848,50 @@ int try_miller(Geometry &geom, miller_opts &opts)
   return(idx);
 }
 
+// make the models in the batch in parallel, and write them in number order
+void make_batch(miller_opts &opts)
+{
+  Miller mill;
+  vector<int> nums;
+  opts.print_status_or_exit(
+      read_idx_list((char *)opts.batch_nums.c_str(), nums,
+                    mill.get_last_M() + 1),
+      'B');
+  for (int num : nums)
+    if (num == 0)
+      opts.error("Miller list numbers start from 1", 'B');
+
+  vector<Geometry> models(nums.size());
+  vector<string> errmsgs(nums.size());
+  parallel_for(0, nums.size(), [&](long i) {
+    // model building may modify the options, so use a copy for each
+    miller_opts model_opts = opts;
+    char errmsg[MSG_SZ] = "";
+    if (make_resource_miller(models[i], std::to_string(nums[i]), false,
+                             model_opts, errmsg))
+      errmsgs[i] = (*errmsg) ? errmsg : "model could not be made";
+  });
+
+  for (unsigned int i = 0; i < nums.size(); i++)
+    if (errmsgs[i] != "")
+      opts.error(msg_str("model %d: %s", nums[i], errmsgs[i].c_str()), 'B');
+
+  if (opts.out_dir != "") {
+    for (unsigned int i = 0; i < nums.size(); i++)
+      opts.write_or_error(models[i],
+                          opts.out_dir + "/m" + std::to_string(nums[i]) +
+                              ".off");
+  }
+  else {
+    ArchiveWriter arc;
+    opts.print_status_or_exit(arc.open(opts.ofile), 'o');
+    for (unsigned int i = 0; i < nums.size(); i++)
+      opts.print_status_or_exit(
+          arc.add("m" + std::to_string(nums[i]), models[i]));
+    opts.print_status_or_exit(arc.close());
+  }
+}
+
 int main(int argc, char *argv[])
 {
   miller_opts opts;
@@ -827,6 +903,13 @@ int main(int argc, char *argv[])
     exit(0);
   }
 
+  set_stellation_diagram_cache(opts.cache_dir);
+
+  if (opts.batch_nums != "") {
+    make_batch(opts);
+    return 0;
+  }
+
   Geometry geom;
   if (try_miller(geom, opts))
     opts.error("model not found");
@@ -6156,11 +6156,86 @@ int ncon_subsystem(Geometry &geom, ncon_opts &opts)
   return ret;
 }
 
-void surface_subsystem(const ncon_opts &opts)
+// report the surfaces of the twisted n-icons of one order
+string surface_report(int ncon_order, char form, const ncon_opts &opts)
 {
   vector<surfaceTable *> surface_table;
   surfaceData sd;
+  string report;
+
+  int last = 0;
+  if (is_even(ncon_order)) {
+    if (form == 'h')
+      last = (int)floor((double)(ncon_order + 2) / 4);
+    else
+      last = (int)floor((double)ncon_order / 4);
+  }
+  else
+    last = (int)floor((double)ncon_order / 2);
+
+  bool point_cut = false;
+  bool hybrid = false;
+  bool info = false;
+
+  if (form == 'n' || form == 'o')
+    point_cut = true;
+  else if (form == 's')
+    point_cut = false;
+  else if (form == 'h')
+    hybrid = true;
+
+  bool none = true;
+
+  if (opts.long_form)
+    report += msg_str("%-5d: ", ncon_order);
+  else
+    report += msg_str("%d: ", ncon_order);
+
+  for (int twist = 2; twist <= last; twist++) {
+    ncon_info(ncon_order, point_cut, twist, hybrid, info, surface_table, sd);
+
+    if ((!is_even(ncon_order) && sd.total_surfaces > 1) ||
+        (form != 's' && sd.total_surfaces > 1) ||
+        (form == 's' && sd.total_surfaces > 2)) {
+      if (!sd.ncon_case2 || (sd.ncon_case2 && !opts.filter_case2)) {
+        if (!none) {
+          if (opts.long_form)
+            report += msg_str("%-5d: ", ncon_order);
+          else
+            report += ", ";
+        }
+        char buffer[MSG_SZ];
+        if (sd.nonchiral)
+          sprintf(buffer, "[%d+%d]", ncon_order, twist);
+        else if (sd.ncon_case2)
+          sprintf(buffer, "{%d+%d}", ncon_order, twist);
+        else
+          sprintf(buffer, "(%d+%d)", ncon_order, twist);
+        if (opts.long_form)
+          report += msg_str("%-15s %5d %10d %13d %10d %13d\n", buffer,
+                            sd.total_surfaces, sd.c_surfaces, sd.d_surfaces,
+                            sd.c_edges, sd.d_edges);
+        else
+          report += buffer;
+        none = false;
+      }
+    }
+  }
+  for (auto entry : surface_table)
+    delete entry;
+
+  if (none) {
+    report += "none";
+    if (opts.long_form)
+      report += "\n";
+  }
+  report += "\n";
 
+  return report;
+}
+
+void surface_subsystem(const ncon_opts &opts)
+{
   char form = opts.ncon_surf[0];
 
   fprintf(stderr, "\n");
@@ -6227,74 +6302,22 @@ void surface_subsystem(const ncon_opts &opts)
             "Discontinuous");
   }
 
-  int last = 0;
+  // orders are reported in parallel, in blocks, and printed in order
+  vector<int> orders;
   for (int ncon_order = ncon_range.front(); ncon_order <= ncon_range.back();
-       ncon_order += inc) {
-    if (is_even(ncon_order)) {
-      if (form == 'h')
-        last = (int)floor((double)(ncon_order + 2) / 4);
-      else
-        last = (int)floor((double)ncon_order / 4);
-    }
-    else
-      last = (int)floor((double)ncon_order / 2);
-
-    bool point_cut = false;
-    bool hybrid = false;
-    bool info = false;
-
-    if (form == 'n' || form == 'o')
-      point_cut = true;
-    else if (form == 's')
-      point_cut = false;
-    else if (form == 'h')
-      hybrid = true;
-
-    bool none = true;
-
-    if (opts.long_form)
-      fprintf(stderr, "%-5d: ", ncon_order);
-    else
-      fprintf(stderr, "%d: ", ncon_order);
-
-    for (int twist = 2; twist <= last; twist++) {
-      ncon_info(ncon_order, point_cut, twist, hybrid, info, surface_table, sd);
-
-      if ((!is_even(ncon_order) && sd.total_surfaces > 1) ||
-          (form != 's' && sd.total_surfaces > 1) ||
-          (form == 's' && sd.total_surfaces > 2)) {
-        if (!sd.ncon_case2 || (sd.ncon_case2 && !opts.filter_case2)) {
-          if (!none) {
-            if (opts.long_form)
-              fprintf(stderr, "%-5d: ", ncon_order);
-            else
-              fprintf(stderr, ", ");
-          }
-          char buffer[MSG_SZ];
-          if (sd.nonchiral)
-            sprintf(buffer, "[%d+%d]", ncon_order, twist);
-          else if (sd.ncon_case2)
-            sprintf(buffer, "{%d+%d}", ncon_order, twist);
-          else
-            sprintf(buffer, "(%d+%d)", ncon_order, twist);
-          if (opts.long_form)
-            fprintf(stderr, "%-15s %5d %10d %13d %10d %13d\n", buffer,
-                    sd.total_surfaces, sd.c_surfaces, sd.d_surfaces, sd.c_edges,
-                    sd.d_edges);
-          else
-            fprintf(stderr, "%s", buffer);
-          none = false;
-        }
-      }
-    }
-    surface_table.clear();
-
-    if (none) {
-      fprintf(stderr, "none");
-      if (opts.long_form)
-        fprintf(stderr, "\n");
-    }
-    fprintf(stderr, "\n");
+       ncon_order += inc)
+    orders.push_back(ncon_order);
+
+  const int block_sz = 256;
+  vector<string> reports;
+  for (unsigned int blk = 0; blk < orders.size(); blk += block_sz) {
+    int blk_end = std::min(blk + block_sz, (unsigned int)orders.size());
+    reports.assign(blk_end - blk, string());
+    parallel_for(blk, blk_end, [&](long i) {
+      reports[i - blk] = surface_report(orders[i], form, opts);
+    });
+    for (const auto &report : reports)
+      fprintf(stderr, "%s", report.c_str());
   }
 }
 
@@ -32,13 +32,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <ctype.h>
+#include <string.h>
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "../base/antiprism.h"
 
+using std::map;
 using std::string;
 using std::vector;
 
@@ -63,8 +68,12 @@ void obj2off_opts::usage()
 "\n"
 "Usage: %s [options] [input_file]\n"
 "\n"
-"Convert files in OBJ format to OFF format. Only v, e and f statements are\n"
-"processed. If input_file is not given the program reads from standard input.\n"
+"Convert files in OBJ format to OFF format. Only v, f, l, p, usemtl and\n"
+"mtllib statements are processed. Faces, lines and points are coloured with\n"
+"their material, using Kd and d from the material file, or a colour in the\n"
+"material name written by off2obj, otherwise an index number. Large files\n"
+"are read in parallel. If input_file is not given the program reads from\n"
+"standard input.\n"
 "\n"
 "Options\n"
 "%s"
@@ -109,11 +118,315 @@ void obj2off_opts::process_command_line(int argc, char **argv)
     ifile = argv[optind];
 }
 
-void convert_obj_to_off(string &file_name, Geometry &geom, char *errmsg)
+namespace {
+
+bool is_obj_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char *skip_obj_space(const char *p, const char *eol)
+{
+  while (p < eol && is_obj_space(*p))
+    p++;
+  return p;
+}
+
+const char *find_obj_space(const char *p, const char *eol)
+{
+  while (p < eol && !is_obj_space(*p))
+    p++;
+  return p;
+}
+
+string obj_token(const char *p, const char *eol)
+{
+  return string(p, find_obj_space(p, eol));
+}
+
+const char *find_eol(const char *p, const char *end)
+{
+  const char *eol = (const char *)memchr(p, '\n', end - p);
+  return eol ? eol : end;
+}
+
+// Read a floating point number which ends at whitespace or the end of the
+// line, and move p past it
+bool read_obj_double(const char *&p, const char *eol, double *val)
+{
+  // strtod would skip whitespace, including the newline
+  if (p == eol || is_obj_space(*p))
+    return false;
+  char *num_end;
+  *val = strtod(p, &num_end);
+  if (num_end == p || num_end > eol ||
+      (num_end < eol && !is_obj_space(*num_end)) || !std::isfinite(*val))
+    return false;
+  p = num_end;
+  return true;
+}
+
+// Read an integer, and return a pointer to the character after it, or
+// nullptr if there is no integer or it is out of range
+const char *read_obj_int(const char *p, const char *eol, long *val)
+{
+  bool neg = false;
+  if (p < eol && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    p++;
+  }
+  const char *digits = p;
+  long num = 0;
+  while (p < eol && *p >= '0' && *p <= '9') {
+    num = num * 10 + (*p - '0');
+    if (num > INT_MAX)
+      return nullptr;
+    p++;
+  }
+  if (p == digits)
+    return nullptr;
+  *val = neg ? -num : num;
+  return p;
+}
+
+// A face, polyline or set of points, with its vertex indexes
+struct ObjElem {
+  char type; // 'f', 'l' or 'p'
+  int mtl;   // index in block materials, or -1 for material in use before
+  long start; // position of first vertex index in the block indexes
+  int size;   // number of vertex indexes
+};
+
+// The statements read from a block of lines of an OBJ file. Vertex indexes
+// are converted to start from 0. Relative (negative) indexes are converted
+// to be relative to the first vertex of the block, and their positions
+// are recorded so the number of vertices in earlier blocks can be added.
+struct ObjBlock {
+  const char *begin;
+  const char *end;
+  vector<Vec3d> verts;
+  vector<int> idxs;
+  vector<long> rel_idxs;
+  vector<ObjElem> elems;
+  vector<string> mtls;
+  map<string, int> mtl_idxs;
+  int cur_mtl = -1;
+  vector<string> mtl_libs;
+  long lines = 0;
+  long err_line = 0; // line in block of first error, or 0 if no error
+  string err_msg;
+};
+
+Status parse_obj_line(ObjBlock &blk, const char *p, const char *eol)
+{
+  const char *key = skip_obj_space(p, eol);
+  const char *key_end = find_obj_space(key, eol);
+  string key_str(key, key_end);
+  p = key_end;
+
+  if (key_str == "v") { // only use x y z
+    Vec3d v;
+    for (int i = 0; i < 3; i++) {
+      p = skip_obj_space(p, eol);
+      if (p == eol)
+        return Status::error("vertex: less than three coordinates");
+      if (!read_obj_double(p, eol, &v[i]))
+        return Status::error(msg_str("vertex: invalid coordinate '%s'",
+                                     obj_token(p, eol).c_str()));
+    }
+    blk.verts.push_back(v);
+  }
+  else if (key_str == "f" || key_str == "l" || key_str == "p") {
+    const char *elem_name =
+        (*key == 'f') ? "face" : (*key == 'l') ? "line" : "point";
+    ObjElem elem = {*key, blk.cur_mtl, (long)blk.idxs.size(), 0};
+    while ((p = skip_obj_space(p, eol)) < eol) {
+      long idx;
+      const char *idx_end = read_obj_int(p, eol, &idx);
+      if (!idx_end || idx == 0 ||
+          (idx_end < eol && !is_obj_space(*idx_end) && *idx_end != '/'))
+        return Status::error(msg_str("%s: invalid vertex index '%s'",
+                                     elem_name, obj_token(p, eol).c_str()));
+      p = find_obj_space(idx_end, eol); // skip texture and normal indexes
+      if (idx < 0) {
+        blk.rel_idxs.push_back(blk.idxs.size());
+        idx += blk.verts.size();
+      }
+      else
+        idx--; // obj files start indexes from 1
+      blk.idxs.push_back(idx);
+    }
+    elem.size = blk.idxs.size() - elem.start;
+    if (elem.size < ((*key == 'l') ? 2 : 1))
+      return Status::error(msg_str("%s: not enough vertex indexes", elem_name));
+    blk.elems.push_back(elem);
+  }
+  else if (key_str == "usemtl") {
+    p = skip_obj_space(p, eol);
+    const char *name_end = eol;
+    while (name_end > p && is_obj_space(name_end[-1]))
+      name_end--;
+    string name(p, name_end);
+    auto mi = blk.mtl_idxs.find(name);
+    if (mi == blk.mtl_idxs.end()) {
+      mi = blk.mtl_idxs.insert(std::make_pair(name, (int)blk.mtls.size()))
+               .first;
+      blk.mtls.push_back(name);
+    }
+    blk.cur_mtl = mi->second;
+  }
+  else if (key_str == "mtllib") {
+    while ((p = skip_obj_space(p, eol)) < eol) {
+      const char *name_end = find_obj_space(p, eol);
+      blk.mtl_libs.push_back(string(p, name_end));
+      p = name_end;
+    }
+  }
+
+  return Status::ok();
+}
+
+void parse_obj_block(ObjBlock &blk)
 {
-  if (errmsg)
-    *errmsg = '\0';
+  // count the vertex and element lines to reserve space
+  long num_verts = 0;
+  long num_elems = 0;
+  for (const char *p = blk.begin; p < blk.end; p++) {
+    const char *eol = find_eol(p, blk.end);
+    p = skip_obj_space(p, eol);
+    if (eol - p > 1 && is_obj_space(p[1])) {
+      if (*p == 'v')
+        num_verts++;
+      else if (*p == 'f' || *p == 'l' || *p == 'p')
+        num_elems++;
+    }
+    p = eol;
+  }
+  blk.verts.reserve(num_verts);
+  blk.elems.reserve(num_elems);
+  blk.idxs.reserve(3 * num_elems);
+
+  for (const char *p = blk.begin; p < blk.end; p++) {
+    const char *eol = find_eol(p, blk.end);
+    blk.lines++;
+    Status stat = parse_obj_line(blk, p, eol);
+    if (stat.is_error()) {
+      blk.err_line = blk.lines;
+      blk.err_msg = stat.msg();
+      return;
+    }
+    p = eol;
+  }
+}
+
+Status read_file_to_buffer(FILE *ifile, string &buf)
+{
+  // reserve the file size, if it can be found
+  if (fseek(ifile, 0, SEEK_END) == 0) {
+    long sz = ftell(ifile);
+    if (sz > 0)
+      buf.reserve(sz + 1);
+    rewind(ifile);
+  }
+
+  const size_t block_sz = 1 << 20;
+  size_t len = 0;
+  while (true) {
+    buf.resize(len + block_sz);
+    size_t num_read = fread(&buf[len], 1, block_sz, ifile);
+    len += num_read;
+    if (num_read < block_sz)
+      break;
+  }
+  buf.resize(len);
+  if (ferror(ifile))
+    return Status::error("error reading input file");
 
+  return Status::ok();
+}
+
+// Colours from material Kd (diffuse colour) and d or Tr (transparency)
+Status read_mtl_file(const string &file_name, map<string, Color> &mtl_cols)
+{
+  FILE *mfile = fopen(file_name.c_str(), "r");
+  if (!mfile)
+    return Status::error(
+        msg_str("could not open material file '%s'", file_name.c_str()));
+  string buf;
+  Status stat = read_file_to_buffer(mfile, buf);
+  fclose(mfile);
+  if (stat.is_error())
+    return stat;
+
+  string name;
+  Vec4d col(0.0, 0.0, 0.0, 1.0);
+  auto add_mtl = [&]() {
+    if (name != "")
+      mtl_cols[name] = Color(col);
+  };
+
+  const char *end = buf.c_str() + buf.size();
+  for (const char *p = buf.c_str(); p < end; p++) {
+    const char *eol = find_eol(p, end);
+    const char *key = skip_obj_space(p, eol);
+    const char *key_end = find_obj_space(key, eol);
+    string key_str(key, key_end);
+    p = skip_obj_space(key_end, eol);
+    if (key_str == "newmtl") {
+      add_mtl();
+      const char *name_end = eol;
+      while (name_end > p && is_obj_space(name_end[-1]))
+        name_end--;
+      name = string(p, name_end);
+      col = Vec4d(0.0, 0.0, 0.0, 1.0);
+    }
+    else if (key_str == "Kd") {
+      for (int i = 0; i < 3; i++) {
+        if (!read_obj_double(p, eol, &col[i]))
+          break;
+        p = skip_obj_space(p, eol);
+      }
+    }
+    else if (key_str == "d" || key_str == "Tr") {
+      double val;
+      if (read_obj_double(p, eol, &val))
+        col[3] = (key_str == "d") ? val : 1.0 - val;
+    }
+    p = eol;
+  }
+  add_mtl();
+
+  return Status::ok();
+}
+
+// Colour for a material: from a material file, or the colour in the name
+// of a material written by off2obj, otherwise the next index number
+Color get_mtl_col(const string &name, const map<string, Color> &mtl_cols,
+                  int *next_idx)
+{
+  if (name == "color_vert_default" || name == "color_edge_default" ||
+      name == "color_face_default")
+    return Color();
+
+  auto mi = mtl_cols.find(name);
+  if (mi != mtl_cols.end())
+    return mi->second;
+
+  unsigned int rgba[4];
+  int len = 0;
+  if (sscanf(name.c_str(), "color_%2x%2x%2x%2x%n", &rgba[0], &rgba[1],
+             &rgba[2], &rgba[3], &len) == 4 &&
+      len == (int)name.size())
+    return Color((int)rgba[0], (int)rgba[1], (int)rgba[2], (int)rgba[3]);
+
+  return Color((*next_idx)++);
+}
+
+} // namespace
+
+Status read_obj(string file_name, Geometry &geom)
+{
+  ProfileScope prof("obj_read");
   FILE *ifile;
   if (file_name == "" || file_name == "-") {
     ifile = stdin;
@@ -121,60 +434,152 @@ void convert_obj_to_off(string &file_name, Geometry &geom, char *errmsg)
   }
   else {
     ifile = fopen(file_name.c_str(), "r");
-    if (!ifile) {
-      if (errmsg)
-        snprintf(errmsg, MSG_SZ, "could not open input file \'%s\'",
-                 file_name.c_str());
-    }
+    if (!ifile)
+      return Status::error(
+          msg_str("could not open input file '%s'", file_name.c_str()));
   }
 
-  char parse_key[] = " ";
-
-  int offset = 1; // obj files start indexes from 1
+  string buf;
+  Status stat = read_file_to_buffer(ifile, buf);
+  if (ifile != stdin)
+    fclose(ifile);
+  if (stat.is_error())
+    return stat;
+
+  // Split large files into blocks of whole lines to parse in parallel
+  const long min_block_sz = 1 << 22;
+  long num_blocks = std::max(
+      1L, std::min(4L * get_num_threads(), (long)buf.size() / min_block_sz));
+  vector<ObjBlock> blks(num_blocks);
+  const char *buf_end = buf.c_str() + buf.size();
+  const char *p = buf.c_str();
+  for (long i = 0; i < num_blocks; i++) {
+    blks[i].begin = p;
+    if (i == num_blocks - 1)
+      p = buf_end;
+    else {
+      p = std::min(buf_end, std::max(p, buf.c_str() + (i + 1) * buf.size() /
+                                                         num_blocks));
+      p = std::min(buf_end, find_eol(p, buf_end) + 1);
+    }
+    blks[i].end = p;
+  }
+  profile_count("obj_blocks", num_blocks);
 
-  char *line = nullptr;
-  while (read_line(ifile, &line) == 0) {
-    for (char *p = line; *p; p++) // convert whitespace to spaces
-      if (isspace(*p))
-        *p = ' ';
+  {
+    ProfileScope prof_parse("obj_parse");
+    parallel_for(0, num_blocks, [&](long i) { parse_obj_block(blks[i]); });
+  }
 
-    char *ptok = strtok(line, parse_key);
-    char key = ptok ? *ptok : '\0';
-    int idx;
+  ProfileScope prof_merge("obj_merge");
+  // Add the vertices, and resolve relative indexes and block materials
+  vector<string> mtls;
+  map<string, int> mtl_idxs;
+  vector<string> mtl_libs;
+  vector<int> elem_mtls;
+  long num_verts = 0;
+  long num_elems = 0;
+  long num_faces = 0;
+  long num_lines = 0;
+  for (auto &blk : blks) {
+    if (blk.err_line)
+      return Status::error(msg_str("line %ld: %s", num_lines + blk.err_line,
+                                   blk.err_msg.c_str()));
+    num_verts += blk.verts.size();
+    num_elems += blk.elems.size();
+    for (const auto &elem : blk.elems)
+      num_faces += (elem.type == 'f');
+    num_lines += blk.lines;
+    mtl_libs.insert(mtl_libs.end(), blk.mtl_libs.begin(), blk.mtl_libs.end());
+  }
 
-    // only use x y z
-    if (key == 'v') {
-      double coord[3];
-      for (double &j : coord) {
-        ptok = strtok(nullptr, parse_key);
-        sscanf(ptok, "%lf", &j);
+  geom.raw_verts().reserve(geom.verts().size() + num_verts);
+  geom.raw_faces().reserve(geom.faces().size() + num_faces);
+  elem_mtls.reserve(num_elems);
+  int cur_mtl = -1;
+  for (auto &blk : blks) {
+    int v_offset = geom.verts().size();
+    for (long pos : blk.rel_idxs)
+      blk.idxs[pos] += v_offset;
+    geom.raw_verts().insert(geom.raw_verts().end(), blk.verts.begin(),
+                            blk.verts.end());
+    vector<Vec3d>().swap(blk.verts);
+
+    vector<int> blk2mtl(blk.mtls.size());
+    for (unsigned int i = 0; i < blk.mtls.size(); i++) {
+      auto mi = mtl_idxs.find(blk.mtls[i]);
+      if (mi == mtl_idxs.end()) {
+        mi = mtl_idxs.insert(std::make_pair(blk.mtls[i], (int)mtls.size()))
+                 .first;
+        mtls.push_back(blk.mtls[i]);
       }
-      geom.add_vert(Vec3d(coord[0], coord[1], coord[2]));
+      blk2mtl[i] = mi->second;
     }
-    else if (key == 'f' || key == 'l') {
-      vector<int> indexes;
-      ptok = strtok(nullptr, parse_key);
-      while (ptok != nullptr) {
-        sscanf(ptok, "%d", &idx);
-        indexes.push_back(idx - offset);
-        ptok = strtok(nullptr, parse_key);
+    for (const auto &elem : blk.elems)
+      elem_mtls.push_back((elem.mtl < 0) ? cur_mtl : blk2mtl[elem.mtl]);
+    if (blk.cur_mtl >= 0)
+      cur_mtl = blk2mtl[blk.cur_mtl];
+  }
+
+  // Find the material colours
+  map<string, Color> mtl_cols;
+  string dir = file_name.substr(0, basename2(file_name.c_str()) -
+                                       file_name.c_str());
+  for (const auto &lib : mtl_libs) {
+    string path = (lib[0] == '/' || file_name == "stdin") ? lib : dir + lib;
+    Status mtl_stat = read_mtl_file(path, mtl_cols);
+    if (mtl_stat.is_error() && stat.is_ok())
+      stat = Status::warning(mtl_stat.msg());
+  }
+  vector<Color> cols(mtls.size());
+  int next_idx = 0;
+  for (unsigned int i = 0; i < mtls.size(); i++)
+    cols[i] = get_mtl_col(mtls[i], mtl_cols, &next_idx);
+
+  // Add the elements, colouring them with their material colour
+  const int last_vert = geom.verts().size() - 1;
+  const char *elem_names[] = {"face", "line", "point"};
+  std::set<std::pair<int, int>> edges;
+  for (const auto &e : geom.edges())
+    edges.insert(std::make_pair(e[0], e[1]));
+  long elem_no = 0;
+  long type_cnts[] = {0, 0, 0};
+  for (auto &blk : blks) {
+    for (const auto &elem : blk.elems) {
+      const int *idxs = blk.idxs.data() + elem.start;
+      const int type_no = (elem.type == 'f') ? 0 : (elem.type == 'l') ? 1 : 2;
+      type_cnts[type_no]++;
+      for (int i = 0; i < elem.size; i++)
+        if (idxs[i] < 0 || idxs[i] > last_vert)
+          return Status::error(
+              msg_str("%s %ld: vertex index '%d' is not in range 1 to %d",
+                      elem_names[type_no], type_cnts[type_no], idxs[i] + 1,
+                      last_vert + 1));
+
+      int mtl = elem_mtls[elem_no++];
+      Color col = (mtl < 0) ? Color() : cols[mtl];
+      if (type_no == 0) // face
+        geom.add_face(vector<int>(idxs, idxs + elem.size), col);
+      else if (type_no == 1) { // polyline, add edges between neighbours
+        for (int i = 0; i < elem.size - 1; i++) {
+          vector<int> edge = make_edge(idxs[i], idxs[i + 1]);
+          if (edge[0] != edge[1] &&
+              edges.insert(std::make_pair(edge[0], edge[1])).second)
+            geom.add_edge_raw(edge, col);
+        }
+      }
+      else if (col.is_set()) { // points, only set the colour
+        for (int i = 0; i < elem.size; i++)
+          geom.colors(VERTS).set(idxs[i], col);
       }
-      if (key == 'f')
-        geom.add_face(indexes);
-      else if (key == 'l')
-        geom.add_edge(indexes);
-    }
-    else if (key == 'p') {
-      ptok = strtok(nullptr, parse_key);
-      sscanf(ptok, "%d", &idx);
-      geom.colors(VERTS).set(idx - offset, Color());
     }
-
-    free(line);
+    vector<int>().swap(blk.idxs);
+    vector<ObjElem>().swap(blk.elems);
   }
+  if (profiling_enabled())
+    profile_mem("obj_buffer", buf.capacity());
 
-  if (file_name != "stdin")
-    fclose(ifile);
+  return stat;
 }
 
 int main(int argc, char *argv[])
@@ -184,11 +589,7 @@ int main(int argc, char *argv[])
 
   Geometry geom;
 
-  char errmsg[MSG_SZ];
-  // obj is enough like OFF that it can be parsed and converted in line
-  convert_obj_to_off(opts.ifile, geom, errmsg);
-  if (*errmsg)
-    opts.error(errmsg);
+  opts.print_status_or_exit(read_obj(opts.ifile, geom));
 
   opts.write_or_error(geom, opts.ofile, opts.sig_digits);
 
@@ -29,10 +29,12 @@
 */
 
 #include <ctype.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
+#include <set>
 #include <stack>
 #include <string>
 #include <utility>
@@ -42,6 +44,7 @@
 
 using std::map;
 using std::pair;
+using std::set;
 using std::stack;
 using std::string;
 using std::vector;
@@ -69,6 +72,10 @@ public:
 };
 
 class XML_writer {
+private:
+  string buf;                                 // output not yet written
+  static const size_t buf_block_sz = 1 << 16; // write when this size
+
 protected:
   FILE *ofile;
   stack<string> tag_names;
@@ -86,8 +93,15 @@ protected:
   }
 
 public:
-  XML_writer(FILE *file) : in_line_level(-1) { ofile = file; };
+  XML_writer(FILE *file) : in_line_level(-1)
+  {
+    ofile = file;
+    buf.reserve(buf_block_sz + MSG_SZ);
+  };
+  ~XML_writer() { flush(); }
   FILE *get_ofile() const { return ofile; }
+  void print(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  void flush();
   void print_open(const XML_elem &tag) { open_tag(tag, false); }
   void print_open(string name) { open_tag(XML_elem(name), false); }
   void print_open_empty(const XML_elem &tag) { open_tag(tag, true); }
@@ -99,38 +113,66 @@ public:
   }
 
   void print_close();
-  string indent(int off = 0) const
-  {
-    return string((off + (int)tag_names.size()) * 2, ' ');
-  }
-  void print_indent() const { fprintf(ofile, "%s", indent().c_str()); }
-  void print_newline() const { fprintf(ofile, "\n"); }
+  int indent(int off = 0) const { return (off + (int)tag_names.size()) * 2; }
+  void print_indent(int off = 0) { print("%*s", indent(off), ""); }
+  void print_newline() { print("\n"); }
 };
 
 // --------------------------------------------------------------------------
 // XML implementation
 
+void XML_writer::print(const char *fmt, ...)
+{
+  // format into a local buffer, and only format again if it is too short
+  char str[MSG_SZ];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(str, MSG_SZ, fmt, args);
+  va_end(args);
+  if (len < 0)
+    return;
+  if ((size_t)len < sizeof(str))
+    buf.append(str, len);
+  else {
+    size_t sz = buf.size();
+    buf.resize(sz + len + 1);
+    va_start(args, fmt);
+    vsnprintf(&buf[sz], len + 1, fmt, args);
+    va_end(args);
+    buf.resize(sz + len);
+  }
+  if (buf.size() > buf_block_sz)
+    flush();
+}
+
+void XML_writer::flush()
+{
+  if (buf.empty())
+    return;
+  fwrite(buf.data(), 1, buf.size(), ofile);
+  buf.clear();
+}
+
 void XML_writer::open_tag(const XML_elem &tag, bool empty)
 {
-  fprintf(ofile, "%s<%s",
-          is_in_line() ? "" : indent().c_str(), // if in_line, suppress indent
-          tag.get_name().c_str());
+  // if in_line, suppress indent
+  print("%*s<%s", is_in_line() ? 0 : indent(), "", tag.get_name().c_str());
   vector<pair<string, string>>::const_iterator vi;
   for (vi = tag.get_attrs().begin(); vi != tag.get_attrs().end(); ++vi)
-    fprintf(ofile, " %s=\"%s\"", vi->first.c_str(), vi->second.c_str());
+    print(" %s=\"%s\"", vi->first.c_str(), vi->second.c_str());
   if (!empty)
     tag_names.push(tag.get_name());
-  fprintf(ofile, "%s>%s", empty ? " /" : "",
-          is_in_line() ? "" : "\n"); // if in_line, suppress newline
+  print("%s>%s", empty ? " /" : "",
+        is_in_line() ? "" : "\n"); // if in_line, suppress newline
   in_line_update();
 }
 
 void XML_writer::print_close()
 {
-  fprintf(ofile, "%s</%s>%s",
-          is_in_line() ? "" : indent(-1).c_str(), // if in_line, suppress indent
-          tag_names.top().c_str(),
-          is_in_line(-1) ? "" : "\n"); // if final close of in_line, add newline
+  print("%*s</%s>%s",
+        is_in_line() ? 0 : indent(-1), "", // if in_line, suppress indent
+        tag_names.top().c_str(),
+        is_in_line(-1) ? "" : "\n"); // if final close of in_line, add newline
   tag_names.pop();
   in_line_update();
 }
@@ -140,7 +182,7 @@ void XML_writer::print_open_close(const XML_elem &tag, string data)
   if (!is_in_line())
     in_line();
   print_open(tag);
-  fprintf(ofile, "%s", data.c_str());
+  print("%s", data.c_str());
   print_close();
 }
 
@@ -151,17 +193,17 @@ class Collada_writer : public XML_writer {
 private:
   int smooth_level; // controls number faces in sphere and cylinder elems
 
-  static void get_unique_cols(const map<Color, vector<int>> *col2elems,
-                              map<Color, string> *cols);
-  static void add_col2elems(DisplayPoly &disp,
-                            map<Color, vector<int>> *col2elems);
-  static void get_col2elems(const Scene &scen,
-                            map<Color, vector<int>> *col2elems);
+  static Color elem_col(DisplayPoly &disp, int type, int idx);
+  static void add_cols(DisplayPoly &disp, int type, set<Color> *cols);
+  static void get_face_col2elems(DisplayPoly &disp,
+                                 map<Color, vector<int>> *col2elems);
+  template <typename FUNC> static void for_each_disp(const Scene &scen, FUNC f);
 
   static string col2hex(const Color &col);
-  static string format_vec(const Vec3d &v, int sig_digits);
   static string id_tag(const string &name, int g, int d);
 
+  void print_vec(const Vec3d &v, int sig_digits);
+
   void print_asset();
 
   void print_effect(const Color &col, const string &col_str);
@@ -183,6 +225,10 @@ private:
   void print_geometry_cylinder();
   void print_library_geometries(const Scene &scen, int sig_digits);
 
+  void print_elem_node(const string &id, const string &geom_name,
+                       const string &col_str, const Vec3d &scale);
+  void print_library_nodes(const Scene &scen);
+
   void print_library_visual_scene_faces(DisplayPoly &disp, const string &id);
   void print_library_visual_scene_verts(DisplayPoly &disp, const string &id);
   void print_library_visual_scene_edges(DisplayPoly &disp, const string &id);
@@ -202,72 +248,66 @@ public:
 // --------------------------------------------------------------------------
 // Collada class implementation
 
-void Collada_writer::get_unique_cols(const map<Color, vector<int>> *col2elems,
-                                     map<Color, string> *cols)
+Color Collada_writer::elem_col(DisplayPoly &disp, int type, int idx)
 {
-  // Copy the colors from all elements into a single set
-  map<Color, vector<int>>::const_iterator mi;
-  for (int elem = 0; elem < 3; elem++)
-    for (mi = col2elems[elem].begin(); mi != col2elems[elem].end(); ++mi)
-      (*cols)[mi->first] = col2hex(mi->first);
-}
-
-void Collada_writer::add_col2elems(DisplayPoly &disp,
-                                   map<Color, vector<int>> *col2elems)
-{
-  if (disp.elem(VERTS).get_show()) {
-    const vector<Vec3d> &vs = disp.get_disp_geom().verts();
-    for (unsigned int i = 0; i < vs.size(); i++) {
-      Color col = disp.get_disp_geom().colors(VERTS).get((int)i);
-      if (col.is_index())
-        col = disp.clrng(VERTS).get_col(col.get_index());
-      if (!col.is_value())
-        col = disp.def_col(VERTS); // use default
-      if (col.is_value() && !col.is_invisible())
-        col2elems[0][col].push_back(i);
-    }
-  }
-  if (disp.elem(EDGES).get_show()) {
-    const vector<vector<int>> &es = disp.get_disp_geom().edges();
-    for (unsigned int i = 0; i < es.size(); i++) {
-      Color col = disp.get_disp_geom().colors(EDGES).get((int)i);
-      if (col.is_index())
-        col = disp.clrng(EDGES).get_col(col.get_index());
-      if (!col.is_value())
-        col = disp.def_col(EDGES); // use default
-      if (col.is_value() && !col.is_invisible())
-        col2elems[1][col].push_back(i);
-    }
-  }
-  if (disp.elem(FACES).get_show()) {
-    const vector<vector<int>> &fs = disp.get_disp_geom().faces();
-    for (unsigned int i = 0; i < fs.size(); i++) {
-      if (fs[i].size() < 3) // skip degenerate polygons
-        continue;
-      Color col = disp.get_disp_geom().colors(FACES).get((int)i);
-      if (col.is_index())
-        col = disp.clrng(FACES).get_col(col.get_index());
-      if (!col.is_value())
-        col = disp.def_col(FACES); // use default
-      if (col.is_value() && !col.is_invisible())
-        col2elems[2][col].push_back(i);
-    }
+  Color col = disp.get_disp_geom().colors(type).get(idx);
+  if (col.is_index())
+    col = disp.get_clrngs()[type].get_col(col.get_index());
+  if (!col.is_value())
+    col = disp.def_col(type); // use default
+  if (!col.is_value() || col.is_invisible())
+    col = Color(); // not displayed
+  return col;
+}
+
+void Collada_writer::add_cols(DisplayPoly &disp, int type, set<Color> *cols)
+{
+  if (!disp.elem(type).get_show())
+    return;
+  const Geometry &geom = disp.get_disp_geom();
+  int num_elems = (type == VERTS)   ? geom.verts().size()
+                  : (type == EDGES) ? geom.edges().size()
+                                    : geom.faces().size();
+  for (int i = 0; i < num_elems; i++) {
+    if (type == FACES && geom.faces(i).size() < 3) // skip degenerate polygons
+      continue;
+    Color col = elem_col(disp, type, i);
+    if (col.is_set())
+      cols->insert(col);
   }
 }
 
-void Collada_writer::get_col2elems(const Scene &scen,
-                                   map<Color, vector<int>> col2elems[3])
+void Collada_writer::get_face_col2elems(DisplayPoly &disp,
+                                        map<Color, vector<int>> *col2elems)
 {
-  for (int elem = 0; elem < 3; elem++)
-    col2elems[elem].clear();
+  col2elems->clear();
+  if (!disp.elem(FACES).get_show())
+    return;
+  const vector<vector<int>> &fs = disp.get_disp_geom().faces();
+  for (unsigned int i = 0; i < fs.size(); i++) {
+    if (fs[i].size() < 3) // skip degenerate polygons
+      continue;
+    Color col = elem_col(disp, FACES, i);
+    if (col.is_set())
+      (*col2elems)[col].push_back(i);
+  }
+}
 
+// Call f(disp, id) for each polyhedron display in the scene
+template <typename FUNC>
+void Collada_writer::for_each_disp(const Scene &scen, FUNC f)
+{
+  int g = 0; // geometry order index
   vector<SceneGeometry>::const_iterator geo;
   for (geo = scen.get_geoms().begin(); geo != scen.get_geoms().end(); ++geo) {
+    int d = 0; // geometry display type order index
     vector<GeometryDisplay *>::const_iterator dsp;
     for (dsp = geo->get_disps().begin(); dsp != geo->get_disps().end(); ++dsp) {
       if (DisplayPoly *disp_p = dynamic_cast<DisplayPoly *>(*dsp))
-        add_col2elems(*disp_p, col2elems);
+        f(*disp_p, id_tag(geo->get_name(), g, d));
+      d++;
     }
+    g++;
   }
 }
 
@@ -278,16 +318,14 @@ string Collada_writer::col2hex(const Color &col)
   return val;
 }
 
-string Collada_writer::format_vec(const Vec3d &v, int sig_digits)
+void Collada_writer::print_vec(const Vec3d &v, int sig_digits)
 {
-  char buf[MSG_SZ];
   if (sig_digits > 0)
-    snprintf(buf, MSG_SZ, "%.*g %.*g %.*g", sig_digits, v[0], sig_digits, v[1],
-             sig_digits, v[2]);
+    print("%.*g %.*g %.*g", sig_digits, v[0], sig_digits, v[1], sig_digits,
+          v[2]);
   else
-    snprintf(buf, MSG_SZ, "%.*f %.*f %.*f", -sig_digits, v[0], -sig_digits,
-             v[1], -sig_digits, v[2]);
-  return buf;
+    print("%.*f %.*f %.*f", -sig_digits, v[0], -sig_digits, v[1], -sig_digits,
+          v[2]);
 }
 
 string Collada_writer::id_tag(const string &name, int g, int d)
@@ -329,16 +367,16 @@ void Collada_writer::print_effect(const Color &col, const string &col_str)
   in_line();
   print_open("diffuse");
   print_open("color");
-  fprintf(ofile, "%.4f %.4f %.4f %.4f", cv[0], cv[1], cv[2], cv[3]);
+  print("%.4f %.4f %.4f %.4f", cv[0], cv[1], cv[2], cv[3]);
   print_close(); // color
   print_close(); // diffuse
 
   in_line();
   print_open("transparency");
   print_open("float");
-  fprintf(ofile, "%4f", cv[3]); // alpha from color
-  print_close();                // float
-  print_close();                // transparency
+  print("%4f", cv[3]); // alpha from color
+  print_close();       // float
+  print_close();       // transparency
 
   print_close(); // phong
   print_close(); // technique
@@ -357,23 +395,20 @@ void Collada_writer::print_material(const string &col_str)
 
 void Collada_writer::print_library_effects_and_materials(const Scene &scen)
 {
-  print_open("library_effects");
-
-  map<Color, vector<int>> col2elems[3];
-  get_col2elems(scen, col2elems);
-  map<Color, string> cols;
-  get_unique_cols(col2elems, &cols);
-
-  map<Color, string>::const_iterator mi;
-  for (mi = cols.begin(); mi != cols.end(); ++mi)
-    print_effect(mi->first, mi->second);
+  set<Color> cols;
+  for_each_disp(scen, [&](DisplayPoly &disp, const string &) {
+    for (int type = 0; type < 3; type++)
+      add_cols(disp, type, &cols);
+  });
 
+  print_open("library_effects");
+  for (const auto &col : cols)
+    print_effect(col, col2hex(col));
   print_close(); // library_effects
 
   print_open("library_materials");
-  for (mi = cols.begin(); mi != cols.end(); ++mi)
-    print_material(mi->second);
-
+  for (const auto &col : cols)
+    print_material(col2hex(col));
   print_close(); // library_materials
 }
 
@@ -381,8 +416,10 @@ void Collada_writer::print_vertex_coords(const vector<Vec3d> &vecs,
                                          int sig_digits)
 {
   print_indent();
-  for (const auto &vec : vecs)
-    fprintf(ofile, "%s ", format_vec(vec, sig_digits).c_str());
+  for (const auto &vec : vecs) {
+    print_vec(vec, sig_digits);
+    print(" ");
+  }
   print_newline();
 }
 
@@ -420,9 +457,8 @@ void Collada_writer::print_geometry_vecs(const string &id,
 void Collada_writer::print_face_sizes(const Geometry &geom,
                                       const vector<int> &face_idxs)
 {
-  for (int f_idx : face_idxs) {
-    fprintf(ofile, "%lu ", (unsigned long)geom.faces(f_idx).size());
-  }
+  for (int f_idx : face_idxs)
+    print("%lu ", (unsigned long)geom.faces(f_idx).size());
 }
 
 void Collada_writer::print_face_indices(const Geometry &geom,
@@ -430,12 +466,14 @@ void Collada_writer::print_face_indices(const Geometry &geom,
                                         bool with_normals)
 {
   for (int f_idx : face_idxs) {
-    for (unsigned int j = 0; j < geom.faces(f_idx).size(); j++)
-      for (int cnt = 0; cnt < 1 + with_normals; cnt++)
-        fprintf(ofile, "%d ", geom.faces(f_idx, j));
+    for (int v_idx : geom.faces(f_idx)) {
+      if (with_normals)
+        print("%d %d ", v_idx, v_idx);
+      else
+        print("%d ", v_idx);
+    }
   }
 }
-
 void Collada_writer::print_geometry(const string &id, const Geometry &geom,
                                     const map<Color, vector<int>> &g_col2elems,
                                     bool triangulate, int sig_digits,
@@ -459,7 +497,7 @@ void Collada_writer::print_geometry(const string &id, const Geometry &geom,
   map<Color, vector<int>>::const_iterator mi;
   for (mi = g_col2elems.begin(); mi != g_col2elems.end(); ++mi) {
     const Color &face_col = mi->first;
-    const vector<int> face_idxs = mi->second;
+    const vector<int> &face_idxs = mi->second;
     string imat = "im_" + ((mat != "") ? mat : col2hex(face_col));
     print_open(XML_elem(triangulate ? "triangles" : "polylist")
                    .add_attr("material", imat)
@@ -530,27 +568,18 @@ void Collada_writer::print_library_geometries(const Scene &scen, int sig_digits)
   print_open("library_geometries");
   bool include_vert_geometry = false;
   bool include_edge_geometry = false;
-  int g = 0;
-  vector<SceneGeometry>::const_iterator geo;
-  for (geo = scen.get_geoms().begin(); geo != scen.get_geoms().end(); ++geo) {
-    vector<GeometryDisplay *>::const_iterator dsp;
-    int d = 0;
-    for (dsp = geo->get_disps().begin(); dsp != geo->get_disps().end(); ++dsp) {
-      if (DisplayPoly *disp_p = dynamic_cast<DisplayPoly *>(*dsp)) {
-        if (disp_p->elem(FACES).get_show()) {
-          map<Color, vector<int>> g_col2elems[3];
-          add_col2elems(*disp_p, g_col2elems);
-          print_geometry(id_tag(geo->get_name(), g, d), disp_p->get_disp_geom(),
-                         g_col2elems[2], disp_p->get_triangulate(), sig_digits);
-        }
-        if (disp_p->elem(VERTS).get_show())
-          include_vert_geometry = true;
-        if (disp_p->elem(EDGES).get_show())
-          include_edge_geometry = true;
-      }
+  for_each_disp(scen, [&](DisplayPoly &disp, const string &id) {
+    if (disp.elem(FACES).get_show()) {
+      map<Color, vector<int>> col2elems;
+      get_face_col2elems(disp, &col2elems);
+      print_geometry(id, disp.get_disp_geom(), col2elems,
+                     disp.get_triangulate(), sig_digits);
     }
-    g++;
-  }
+    if (disp.elem(VERTS).get_show())
+      include_vert_geometry = true;
+    if (disp.elem(EDGES).get_show())
+      include_edge_geometry = true;
+  });
 
   if (include_vert_geometry)
     print_geometry_sphere();
@@ -560,6 +589,56 @@ void Collada_writer::print_library_geometries(const Scene &scen, int sig_digits)
   print_close(); // library_geometries
 }
 
+void Collada_writer::print_elem_node(const string &id,
+                                     const string &geom_name,
+                                     const string &col_str, const Vec3d &scale)
+{
+  print_open(XML_elem("node").add_id(id));
+  print_indent();
+  print("<scale>");
+  print_vec(scale, 8);
+  print("</scale>\n");
+  print_open(
+      XML_elem("instance_geometry").add_attr("url", "#geometry_" + geom_name));
+  print_open("bind_material");
+  print_open("technique_common");
+  print_open_empty(XML_elem("instance_material")
+                       .add_attr("symbol", "im_" + geom_name)
+                       .add_attr("target", "#m_" + col_str));
+  print_close(); // technique_common
+  print_close(); // bind_materials
+  print_close(); // instance_geometry
+  print_close(); // node
+}
+
+void Collada_writer::print_library_nodes(const Scene &scen)
+{
+  // A node for each colour of vertex sphere and edge cylinder in each
+  // display, which the element nodes instance
+  bool started = false;
+  for_each_disp(scen, [&](DisplayPoly &disp, const string &id) {
+    set<Color> cols[2];
+    add_cols(disp, VERTS, &cols[VERTS]);
+    add_cols(disp, EDGES, &cols[EDGES]);
+    if (!started && (cols[VERTS].size() || cols[EDGES].size())) {
+      print_open("library_nodes");
+      started = true;
+    }
+    double v_rad = disp.get_vert_rad();
+    for (const auto &col : cols[VERTS])
+      print_elem_node("vert_" + id + "_" + col2hex(col),
+                      "vertex_sphere", col2hex(col),
+                      Vec3d(v_rad, v_rad, v_rad));
+    double e_rad = disp.get_edge_rad();
+    for (const auto &col : cols[EDGES])
+      print_elem_node("edge_" + id + "_" + col2hex(col),
+                      "edge_cylinder", col2hex(col),
+                      Vec3d(e_rad, e_rad, 1));
+  });
+  if (started)
+    print_close(); // library_nodes
+}
+
 void Collada_writer::print_library_visual_scene_faces(DisplayPoly &disp,
                                                       const string &id)
 {
@@ -567,15 +646,12 @@ void Collada_writer::print_library_visual_scene_faces(DisplayPoly &disp,
   print_open("bind_material");
   print_open("technique_common");
 
-  map<Color, vector<int>> g_col2elems[3];
-  add_col2elems(disp, g_col2elems);
-  map<Color, string> cols;
-  get_unique_cols(g_col2elems, &cols);
-  map<Color, string>::const_iterator mi;
-  for (mi = cols.begin(); mi != cols.end(); ++mi)
+  set<Color> cols;
+  add_cols(disp, FACES, &cols);
+  for (const auto &col : cols)
     print_open_empty(XML_elem("instance_material")
-                         .add_attr("symbol", "im_" + mi->second)
-                         .add_attr("target", "#m_" + mi->second));
+                         .add_attr("symbol", "im_" + col2hex(col))
+                         .add_attr("target", "#m_" + col2hex(col)));
 
   print_close(); // technique_common
   print_close(); // bind_materials
@@ -588,29 +664,15 @@ void Collada_writer::print_library_visual_scene_verts(DisplayPoly &disp,
   print_open(XML_elem("node").add_id("geometry_verts" + id));
   const Geometry &dgeom = disp.get_disp_geom();
   for (unsigned int i = 0; i < dgeom.verts().size(); i++) {
-    Color col = disp.get_disp_geom().colors(VERTS).get((int)i);
-    if (col.is_index())
-      col = disp.clrng(VERTS).get_col(col.get_index());
-    if (!col.is_value())
-      col = disp.def_col(VERTS); // use default
-    if (col.is_value() && !col.is_invisible()) {
-      print_open("node");
-
-      print_open_close("translate", format_vec(dgeom.verts(i), 8));
-      print_open_close("scale",
-                       format_vec(Vec3d(1, 1, 1) * disp.get_vert_rad(), 8));
-      print_open(XML_elem("instance_geometry")
-                     .add_attr("url", "#geometry_vertex_sphere"));
-      print_open("bind_material");
-      print_open("technique_common");
-      print_open_empty(XML_elem("instance_material")
-                           .add_attr("symbol", "im_vertex_sphere")
-                           .add_attr("target", "#m_" + col2hex(col)));
-      print_close(); // technique_common
-      print_close(); // bind_materials
-      print_close(); // instance_geometry
-      print_close(); // node
-    }
+    Color col = elem_col(disp, VERTS, i);
+    if (!col.is_set())
+      continue;
+    print_indent();
+    print("<node><translate>");
+    print_vec(dgeom.verts(i), 8);
+    print("</translate><instance_node url=\"#vert_%s_%02x%02x%02x%02x\" />"
+          "</node>\n",
+          id.c_str(), col[0], col[1], col[2], col[3]);
   }
   print_close(); // node
 }
@@ -621,39 +683,26 @@ void Collada_writer::print_library_visual_scene_edges(DisplayPoly &disp,
   print_open(XML_elem("node").add_id("geometry_edges" + id));
   const Geometry &dgeom = disp.get_disp_geom();
   for (unsigned int i = 0; i < dgeom.edges().size(); i++) {
-    Color col = disp.get_disp_geom().colors(EDGES).get((int)i);
-    if (col.is_index())
-      col = disp.clrng(EDGES).get_col(col.get_index());
-    if (!col.is_value())
-      col = disp.def_col(EDGES); // use default
-    if (col.is_value() && !col.is_invisible()) {
-      print_open("node");
-
-      Vec3d mid = dgeom.edge_cent(i);
-      Vec3d dir = dgeom.edge_vec(i);
-      double ht = dir.len();
-      dir /= ht;                                 // to unit
-      double ang = -acos(safe_for_trig(dir[2])); // ang betwn dir and y-axis
-      Vec3d axis = vcross(dir, Vec3d(0, 0, 2)).unit(); // axis
-      print_open_close("translate", format_vec(mid, 8));
-      print_open_close("rotate",
-                       format_vec(axis, 8) + " " + dtostr(rad2deg(ang), 8));
-      print_open_close(
-          "scale",
-          format_vec(Vec3d(disp.get_edge_rad(), disp.get_edge_rad(), ht), 8));
-
-      print_open(XML_elem("instance_geometry")
-                     .add_attr("url", "#geometry_edge_cylinder"));
-      print_open("bind_material");
-      print_open("technique_common");
-      print_open_empty(XML_elem("instance_material")
-                           .add_attr("symbol", "im_edge_cylinder")
-                           .add_attr("target", "#m_" + col2hex(col)));
-      print_close(); // technique_common
-      print_close(); // bind_materials
-      print_close(); // instance_geometry
-      print_close(); // node
-    }
+    Color col = elem_col(disp, EDGES, i);
+    if (!col.is_set())
+      continue;
+    Vec3d mid = dgeom.edge_cent(i);
+    Vec3d dir = dgeom.edge_vec(i);
+    double ht = dir.len();
+    if (ht == 0.0) // no direction
+      continue;
+    dir /= ht;                                 // to unit
+    double ang = -acos(safe_for_trig(dir[2])); // ang betwn dir and z-axis
+    Vec3d axis = vcross(dir, Vec3d(0, 0, 1));
+    axis = (axis.len2() > epsilon * epsilon) ? axis.unit() : Vec3d::X;
+    print_indent();
+    print("<node><translate>");
+    print_vec(mid, 8);
+    print("</translate><rotate>");
+    print_vec(axis, 8);
+    print(" %.8g</rotate><scale>1 1 %.8g</scale>", rad2deg(ang), ht);
+    print("<instance_node url=\"#edge_%s_%02x%02x%02x%02x\" /></node>\n",
+          id.c_str(), col[0], col[1], col[2], col[3]);
   }
   print_close(); // node
 }
@@ -665,25 +714,14 @@ void Collada_writer::print_library_visual_scenes(const Scene &scen)
       XML_elem("visual_scene").add_id("scene_0").add_attr("name", "Scene_0"));
   print_open(XML_elem("node").add_id("visgeom_0").add_attr("type", "NODE"));
 
-  int g = 0; // geometry order index
-  vector<SceneGeometry>::const_iterator geo;
-  for (geo = scen.get_geoms().begin(); geo != scen.get_geoms().end(); ++geo) {
-    int d = 0; // geometry display type order index
-    vector<GeometryDisplay *>::const_iterator dsp;
-    for (dsp = geo->get_disps().begin(); dsp != geo->get_disps().end(); ++dsp) {
-      if (DisplayPoly *disp_p = dynamic_cast<DisplayPoly *>(*dsp)) {
-        string id = id_tag(geo->get_name(), g, d);
-        if (disp_p->elem(FACES).get_show())
-          print_library_visual_scene_faces(*disp_p, id);
-        if (disp_p->elem(VERTS).get_show())
-          print_library_visual_scene_verts(*disp_p, id);
-        if (disp_p->elem(EDGES).get_show())
-          print_library_visual_scene_edges(*disp_p, id);
-      }
-      d++;
-    }
-    g++;
-  }
+  for_each_disp(scen, [&](DisplayPoly &disp, const string &id) {
+    if (disp.elem(FACES).get_show())
+      print_library_visual_scene_faces(disp, id);
+    if (disp.elem(VERTS).get_show())
+      print_library_visual_scene_verts(disp, id);
+    if (disp.elem(EDGES).get_show())
+      print_library_visual_scene_edges(disp, id);
+  });
   print_close(); // node
 
   print_close(); // visual_scenes
@@ -700,7 +738,7 @@ void Collada_writer::print_scene()
 
 bool Collada_writer::write(const Scene &scen, int sig_digits)
 {
-  fprintf(ofile, "<?xml version=\"1.0\"?>\n");
+  print("<?xml version=\"1.0\"?>\n");
   print_open(
       XML_elem("COLLADA")
           .add_attr("xmlns", "http://www.collada.org/2005/11/COLLADASchema")
@@ -709,10 +747,12 @@ bool Collada_writer::write(const Scene &scen, int sig_digits)
   print_asset();
   print_library_effects_and_materials(scen);
   print_library_geometries(scen, sig_digits);
+  print_library_nodes(scen);
   print_library_visual_scenes(scen);
   print_scene();
 
   print_close(); // collada
+  flush();
   return true;
 }
 
@@ -843,11 +883,20 @@ int main(int argc, char *argv[])
       opts.error("could not open output file \'" + opts.ofile + "\'");
   }
 
-  Collada_writer collada(ofile, opts.smooth_lvl);
-  collada.write(scen, opts.sig_digits);
+  {
+    // the writer flushes its buffer when destroyed, before the file is closed
+    Collada_writer collada(ofile, opts.smooth_lvl);
+    collada.write(scen, opts.sig_digits);
+  }
 
-  if (opts.ofile != "")
-    fclose(ofile);
+  bool write_err = ferror(ofile);
+  if (ofile != stdout)
+    write_err = (fclose(ofile) != 0) || write_err;
+  else
+    write_err = (fflush(ofile) != 0) || write_err;
+  if (write_err)
+    opts.error(msg_str("could not write output file '%s'",
+                       (opts.ofile != "") ? opts.ofile.c_str() : "stdout"));
 
   return 0;
 }
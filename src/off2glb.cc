@@ -0,0 +1,720 @@
+/*
+   Copyright (c) 2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*
+   Name: off2glb.cc
+   Description: convert from OFF to binary glTF (GLB)
+   Project: Antiprism - http://www.antiprism.com
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../base/antiprism.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+using namespace anti;
+
+// --------------------------------------------------------------------------
+// glTF class
+
+class GLB_writer {
+private:
+  int smooth_level; // controls number faces in sphere and cylinder elems
+
+  // JSON for each item of the top level arrays
+  vector<string> nodes;
+  vector<string> meshes;
+  vector<string> materials;
+  vector<string> accessors;
+  vector<string> buffer_views;
+  bool instancing;
+
+  vector<unsigned char> bin; // binary buffer
+  map<Color, int> col2mat;   // material index for each colour
+
+  // shared accessors for the vertex sphere and edge cylinder meshes
+  // (positions, normals, indices), or -1 if not added yet
+  int sphere_accs[3];
+  int cylinder_accs[3];
+
+  static Color elem_col(DisplayPoly &disp, int type, int idx);
+  template <typename FUNC> static void for_each_disp(const Scene &scen, FUNC f);
+
+  static string json_str(const string &str);
+  static string json_floats(const float *vals, int num);
+  static string json_array(const vector<string> &items);
+
+  int add_buffer_view(const void *data, size_t bytes, int target);
+  int add_floats(const vector<float> &vals, int comps, int target,
+                 bool min_max = false);
+  int add_indices(const vector<uint32_t> &idxs);
+  int add_material(const Color &col);
+  int add_mesh(const int accs[3], const Color &col);
+
+  void add_faces(DisplayPoly &disp, const string &id);
+  void add_sphere_accessors();
+  void add_cylinder_accessors();
+  void add_verts(DisplayPoly &disp, const string &id);
+  void add_edges(DisplayPoly &disp, const string &id);
+  void add_instances(const string &name, int mesh,
+                     const vector<float> &trans, const vector<float> &rots,
+                     const vector<float> &scales);
+
+  string json();
+
+public:
+  GLB_writer(int smooth) : instancing(false)
+  {
+    set_smooth_level(smooth);
+    for (int i = 0; i < 3; i++)
+      sphere_accs[i] = cylinder_accs[i] = -1;
+  }
+  void set_smooth_level(int smooth) { smooth_level = smooth < 1 ? 1 : smooth; }
+  Status write(FILE *ofile, const Scene &scen);
+};
+
+// --------------------------------------------------------------------------
+// glTF class implementation
+
+// Constants from the glTF specification
+enum {
+  GLTF_FLOAT = 5126,
+  GLTF_UNSIGNED_INT = 5125,
+  GLTF_ARRAY_BUFFER = 34962,
+  GLTF_ELEMENT_ARRAY_BUFFER = 34963,
+};
+
+Color GLB_writer::elem_col(DisplayPoly &disp, int type, int idx)
+{
+  Color col = disp.get_disp_geom().colors(type).get(idx);
+  if (col.is_index())
+    col = disp.get_clrngs()[type].get_col(col.get_index());
+  if (!col.is_value())
+    col = disp.def_col(type); // use default
+  if (!col.is_value() || col.is_invisible())
+    col = Color(); // not displayed
+  return col;
+}
+
+// Call f(disp, id) for each polyhedron display in the scene
+template <typename FUNC>
+void GLB_writer::for_each_disp(const Scene &scen, FUNC f)
+{
+  int g = 0; // geometry order index
+  vector<SceneGeometry>::const_iterator geo;
+  for (geo = scen.get_geoms().begin(); geo != scen.get_geoms().end(); ++geo) {
+    int d = 0; // geometry display type order index
+    vector<GeometryDisplay *>::const_iterator dsp;
+    for (dsp = geo->get_disps().begin(); dsp != geo->get_disps().end(); ++dsp) {
+      if (DisplayPoly *disp_p = dynamic_cast<DisplayPoly *>(*dsp))
+        f(*disp_p, itostr(g) + "_" + itostr(d) + "_" + geo->get_name());
+      d++;
+    }
+    g++;
+  }
+}
+
+string GLB_writer::json_str(const string &str)
+{
+  string ret = "\"";
+  for (unsigned char c : str) {
+    if (c == '"' || c == '\\')
+      ret += string("\\") + (char)c;
+    else if (c == '\n')
+      ret += "\\n";
+    else if (c == '\t')
+      ret += "\\t";
+    else if (c < 0x20)
+      ret += msg_str("\\u%04x", c);
+    else
+      ret += (char)c;
+  }
+  return ret + "\"";
+}
+
+string GLB_writer::json_floats(const float *vals, int num)
+{
+  // 9 significant digits, so the values read back exactly
+  string str = "[";
+  for (int i = 0; i < num; i++)
+    str += msg_str("%s%.9g", i ? "," : "", vals[i]);
+  return str + "]";
+}
+
+string GLB_writer::json_array(const vector<string> &items)
+{
+  string str = "[";
+  for (unsigned int i = 0; i < items.size(); i++)
+    str += (i ? "," : "") + items[i];
+  return str + "]";
+}
+
+int GLB_writer::add_buffer_view(const void *data, size_t bytes, int target)
+{
+  // all components are 4 bytes, so views stay aligned
+  size_t offset = bin.size();
+  bin.resize(offset + bytes);
+  memcpy(bin.data() + offset, data, bytes);
+
+  // glTF binary data is little endian
+  const uint32_t one = 1;
+  if (*(const unsigned char *)&one == 0) {
+    for (size_t i = offset; i < bin.size(); i += 4) {
+      std::swap(bin[i], bin[i + 3]);
+      std::swap(bin[i + 1], bin[i + 2]);
+    }
+  }
+
+  string view = msg_str("{\"buffer\":0,\"byteOffset\":%lu,\"byteLength\":%lu",
+                        (unsigned long)offset, (unsigned long)bytes);
+  if (target)
+    view += msg_str(",\"target\":%d", target);
+  buffer_views.push_back(view + "}");
+  return buffer_views.size() - 1;
+}
+
+int GLB_writer::add_floats(const vector<float> &vals, int comps, int target,
+                           bool min_max)
+{
+  int view = add_buffer_view(vals.data(), vals.size() * sizeof(float), target);
+  long count = vals.size() / comps;
+  const char *types[] = {"", "SCALAR", "VEC2", "VEC3", "VEC4"};
+  string acc = msg_str("{\"bufferView\":%d,\"componentType\":%d,"
+                       "\"count\":%ld,\"type\":\"%s\"",
+                       view, GLTF_FLOAT, count, types[comps]);
+  if (min_max && count) { // required for positions
+    float min[4], max[4];
+    for (int j = 0; j < comps; j++)
+      min[j] = max[j] = vals[j];
+    for (long i = 1; i < count; i++)
+      for (int j = 0; j < comps; j++) {
+        min[j] = std::min(min[j], vals[i * comps + j]);
+        max[j] = std::max(max[j], vals[i * comps + j]);
+      }
+    acc += ",\"min\":" + json_floats(min, comps) +
+           ",\"max\":" + json_floats(max, comps);
+  }
+  accessors.push_back(acc + "}");
+  return accessors.size() - 1;
+}
+
+int GLB_writer::add_indices(const vector<uint32_t> &idxs)
+{
+  int view = add_buffer_view(idxs.data(), idxs.size() * sizeof(uint32_t),
+                             GLTF_ELEMENT_ARRAY_BUFFER);
+  accessors.push_back(msg_str("{\"bufferView\":%d,\"componentType\":%d,"
+                              "\"count\":%lu,\"type\":\"SCALAR\"}",
+                              view, GLTF_UNSIGNED_INT,
+                              (unsigned long)idxs.size()));
+  return accessors.size() - 1;
+}
+
+int GLB_writer::add_material(const Color &col)
+{
+  auto mi = col2mat.find(col);
+  if (mi != col2mat.end())
+    return mi->second;
+
+  // glTF colour factors are linear, Antiprism colours are sRGB
+  Vec4d cv = col.get_vec4d();
+  float lin[4];
+  for (int i = 0; i < 3; i++)
+    lin[i] = (cv[i] <= 0.04045) ? cv[i] / 12.92
+                                : pow((cv[i] + 0.055) / 1.055, 2.4);
+  lin[3] = cv[3];
+
+  string mat = "{\"pbrMetallicRoughness\":{\"baseColorFactor\":" +
+               json_floats(lin, 4) +
+               ",\"metallicFactor\":0,\"roughnessFactor\":0.5}"
+               ",\"doubleSided\":true";
+  if (col[3] < 255)
+    mat += ",\"alphaMode\":\"BLEND\"";
+  materials.push_back(mat + "}");
+  int idx = materials.size() - 1;
+  col2mat[col] = idx;
+  return idx;
+}
+
+int GLB_writer::add_mesh(const int accs[3], const Color &col)
+{
+  meshes.push_back(msg_str("{\"primitives\":[{\"attributes\":{\"POSITION\":%d,"
+                           "\"NORMAL\":%d},\"indices\":%d,\"material\":%d}]}",
+                           accs[0], accs[1], accs[2], add_material(col)));
+  return meshes.size() - 1;
+}
+
+void GLB_writer::add_faces(DisplayPoly &disp, const string &id)
+{
+  const Geometry &geom = disp.get_disp_geom();
+  map<Color, vector<int>> col2elems;
+  long num_verts = 0;
+  for (unsigned int i = 0; i < geom.faces().size(); i++) {
+    if (geom.faces(i).size() < 3) // skip degenerate polygons
+      continue;
+    Color col = elem_col(disp, FACES, i);
+    if (col.is_set()) {
+      col2elems[col].push_back(i);
+      num_verts += geom.faces(i).size();
+    }
+  }
+  if (!num_verts)
+    return;
+
+  // Each face has its own copy of its vertices, with the face normal, so
+  // faces are flat shaded. Faces are grouped by colour, with a primitive
+  // for each colour that indexes the shared positions and normals.
+  vector<float> pos;
+  vector<float> norms;
+  pos.reserve(3 * num_verts);
+  norms.reserve(3 * num_verts);
+  vector<vector<uint32_t>> prim_idxs;
+  for (const auto &kp : col2elems) {
+    prim_idxs.push_back(vector<uint32_t>());
+    vector<uint32_t> &idxs = prim_idxs.back();
+    for (int f_idx : kp.second) {
+      const vector<int> &face = geom.faces(f_idx);
+      // a degenerate face has no normal, so give it any unit normal
+      Vec3d norm = geom.face_norm(f_idx);
+      norm = (norm.len() > epsilon) ? norm.unit() : Vec3d::Z;
+      uint32_t start = pos.size() / 3;
+      for (int v_idx : face) {
+        const Vec3d &v = geom.verts(v_idx);
+        for (int j = 0; j < 3; j++) {
+          pos.push_back(v[j]);
+          norms.push_back(norm[j]);
+        }
+      }
+      for (unsigned int j = 1; j < face.size() - 1; j++) { // triangle fan
+        idxs.push_back(start);
+        idxs.push_back(start + j);
+        idxs.push_back(start + j + 1);
+      }
+    }
+  }
+
+  int pos_acc = add_floats(pos, 3, GLTF_ARRAY_BUFFER, true);
+  int norm_acc = add_floats(norms, 3, GLTF_ARRAY_BUFFER);
+  string prims;
+  int p = 0;
+  for (const auto &kp : col2elems) {
+    int idx_acc = add_indices(prim_idxs[p]);
+    prims += msg_str("%s{\"attributes\":{\"POSITION\":%d,\"NORMAL\":%d},"
+                     "\"indices\":%d,\"material\":%d}",
+                     p ? "," : "", pos_acc, norm_acc, idx_acc,
+                     add_material(kp.first));
+    p++;
+  }
+  meshes.push_back("{\"primitives\":[" + prims + "]}");
+  nodes.push_back("{\"name\":" + json_str("faces_" + id) +
+                  msg_str(",\"mesh\":%d}", (int)meshes.size() - 1));
+}
+
+void GLB_writer::add_sphere_accessors()
+{
+  // unit sphere, smooth shaded
+  Geometry geom;
+  geom.read_resource("std_geo_" + itostr(smooth_level));
+  vector<float> pos;
+  vector<float> norms;
+  for (const auto &v : geom.verts()) {
+    Vec3d norm = v.unit();
+    for (int j = 0; j < 3; j++) {
+      pos.push_back(norm[j]);
+      norms.push_back(norm[j]);
+    }
+  }
+  vector<uint32_t> idxs;
+  for (const auto &face : geom.faces())
+    for (unsigned int j = 1; j < face.size() - 1; j++) {
+      idxs.push_back(face[0]);
+      idxs.push_back(face[j]);
+      idxs.push_back(face[j + 1]);
+    }
+
+  sphere_accs[0] = add_floats(pos, 3, GLTF_ARRAY_BUFFER, true);
+  sphere_accs[1] = add_floats(norms, 3, GLTF_ARRAY_BUFFER);
+  sphere_accs[2] = add_indices(idxs);
+}
+
+void GLB_writer::add_cylinder_accessors()
+{
+  // cylinder of radius 1 along the z-axis, from z=-0.5 to z=0.5, with
+  // smooth shaded sides and flat caps
+  int n = 6 * smooth_level;
+  vector<float> pos;
+  vector<float> norms;
+  vector<uint32_t> idxs;
+  auto add_vert = [&](double x, double y, double z, double nx, double ny,
+                      double nz) {
+    float vals[] = {(float)x, (float)y, (float)z,
+                    (float)nx, (float)ny, (float)nz};
+    pos.insert(pos.end(), vals, vals + 3);
+    norms.insert(norms.end(), vals + 3, vals + 6);
+  };
+
+  for (int i = 0; i < n; i++) { // sides
+    double ang = 2 * M_PI * i / n;
+    add_vert(cos(ang), sin(ang), -0.5, cos(ang), sin(ang), 0);
+    add_vert(cos(ang), sin(ang), 0.5, cos(ang), sin(ang), 0);
+    uint32_t a = 2 * i;
+    uint32_t b = 2 * ((i + 1) % n);
+    uint32_t tris[] = {a, b, a + 1, a + 1, b, b + 1};
+    idxs.insert(idxs.end(), tris, tris + 6);
+  }
+  for (int cap = 0; cap < 2; cap++) { // caps
+    double z = cap ? 0.5 : -0.5;
+    uint32_t start = pos.size() / 3;
+    for (int i = 0; i < n; i++) {
+      double ang = 2 * M_PI * i / n;
+      add_vert(cos(ang), sin(ang), z, 0, 0, 2 * z);
+      if (i > 1) { // triangle fan
+        uint32_t tri[] = {start, start + i - 1, start + i};
+        if (!cap)
+          std::swap(tri[1], tri[2]);
+        idxs.insert(idxs.end(), tri, tri + 3);
+      }
+    }
+  }
+
+  cylinder_accs[0] = add_floats(pos, 3, GLTF_ARRAY_BUFFER, true);
+  cylinder_accs[1] = add_floats(norms, 3, GLTF_ARRAY_BUFFER);
+  cylinder_accs[2] = add_indices(idxs);
+}
+
+void GLB_writer::add_instances(const string &name, int mesh,
+                               const vector<float> &trans,
+                               const vector<float> &rots,
+                               const vector<float> &scales)
+{
+  string attrs = msg_str("\"TRANSLATION\":%d", add_floats(trans, 3, 0));
+  if (rots.size())
+    attrs += msg_str(",\"ROTATION\":%d", add_floats(rots, 4, 0));
+  attrs += msg_str(",\"SCALE\":%d", add_floats(scales, 3, 0));
+  nodes.push_back("{\"name\":" + json_str(name) +
+                  msg_str(",\"mesh\":%d,\"extensions\":"
+                          "{\"EXT_mesh_gpu_instancing\":{\"attributes\":"
+                          "{%s}}}}",
+                          mesh, attrs.c_str()));
+  instancing = true;
+}
+
+void GLB_writer::add_verts(DisplayPoly &disp, const string &id)
+{
+  // An instanced sphere node for each vertex colour
+  const Geometry &geom = disp.get_disp_geom();
+  map<Color, vector<int>> col2elems;
+  for (unsigned int i = 0; i < geom.verts().size(); i++) {
+    Color col = elem_col(disp, VERTS, i);
+    if (col.is_set())
+      col2elems[col].push_back(i);
+  }
+  if (col2elems.empty())
+    return;
+
+  if (sphere_accs[0] < 0)
+    add_sphere_accessors();
+  float rad = disp.get_vert_rad();
+  int c = 0;
+  for (const auto &kp : col2elems) {
+    vector<float> trans;
+    trans.reserve(3 * kp.second.size());
+    for (int v_idx : kp.second)
+      for (int j = 0; j < 3; j++)
+        trans.push_back(geom.verts(v_idx)[j]);
+    vector<float> scales(trans.size(), rad);
+    add_instances("verts_" + id + "_" + itostr(c++),
+                  add_mesh(sphere_accs, kp.first), trans, vector<float>(),
+                  scales);
+  }
+}
+
+void GLB_writer::add_edges(DisplayPoly &disp, const string &id)
+{
+  // An instanced cylinder node for each edge colour
+  const Geometry &geom = disp.get_disp_geom();
+  map<Color, vector<int>> col2elems;
+  for (unsigned int i = 0; i < geom.edges().size(); i++) {
+    Color col = elem_col(disp, EDGES, i);
+    if (col.is_set() && geom.edge_vec(i).len2() > 0) // skip zero length
+      col2elems[col].push_back(i);
+  }
+  if (col2elems.empty())
+    return;
+
+  if (cylinder_accs[0] < 0)
+    add_cylinder_accessors();
+  float rad = disp.get_edge_rad();
+  int c = 0;
+  for (const auto &kp : col2elems) {
+    vector<float> trans, rots, scales;
+    trans.reserve(3 * kp.second.size());
+    rots.reserve(4 * kp.second.size());
+    scales.reserve(3 * kp.second.size());
+    for (int e_idx : kp.second) {
+      Vec3d mid = geom.edge_cent(e_idx);
+      Vec3d dir = geom.edge_vec(e_idx);
+      double ht = dir.len();
+      dir /= ht;
+      // quaternion (x, y, z, w) rotating the z-axis onto dir
+      Vec3d axis = vcross(Vec3d::Z, dir);
+      double w = 1 + dir[2];
+      Vec3d q_xyz = axis;
+      if (w < epsilon) { // opposite to z-axis, half turn about x-axis
+        q_xyz = Vec3d::X;
+        w = 0;
+      }
+      double q_len = sqrt(q_xyz.len2() + w * w);
+      for (int j = 0; j < 3; j++) {
+        trans.push_back(mid[j]);
+        rots.push_back(q_xyz[j] / q_len);
+      }
+      rots.push_back(w / q_len);
+      scales.push_back(rad);
+      scales.push_back(rad);
+      scales.push_back(ht);
+    }
+    add_instances("edges_" + id + "_" + itostr(c++),
+                  add_mesh(cylinder_accs, kp.first), trans, rots, scales);
+  }
+}
+
+string GLB_writer::json()
+{
+  vector<string> node_idxs;
+  for (unsigned int i = 0; i < nodes.size(); i++)
+    node_idxs.push_back(itostr(i));
+
+  string str = "{\"asset\":{\"version\":\"2.0\",\"generator\":"
+               "\"off2glb (Antiprism - http://www.antiprism.com)\"}";
+  if (instancing)
+    str += ",\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"]"
+           ",\"extensionsRequired\":[\"EXT_mesh_gpu_instancing\"]";
+  // arrays cannot be empty, so a scene with nothing visible has no nodes
+  if (nodes.size()) {
+    str += ",\"scene\":0,\"scenes\":[{\"nodes\":" + json_array(node_idxs) +
+           "}]";
+    str += ",\"nodes\":" + json_array(nodes);
+  }
+  else
+    str += ",\"scene\":0,\"scenes\":[{}]";
+  if (meshes.size())
+    str += ",\"meshes\":" + json_array(meshes);
+  if (materials.size())
+    str += ",\"materials\":" + json_array(materials);
+  if (accessors.size()) {
+    str += ",\"accessors\":" + json_array(accessors);
+    str += ",\"bufferViews\":" + json_array(buffer_views);
+    str += msg_str(",\"buffers\":[{\"byteLength\":%lu}]",
+                   (unsigned long)bin.size());
+  }
+  return str + "}";
+}
+
+Status GLB_writer::write(FILE *ofile, const Scene &scen)
+{
+  ProfileScope prof("glb_write");
+  for_each_disp(scen, [&](DisplayPoly &disp, const string &id) {
+    if (disp.elem(FACES).get_show())
+      add_faces(disp, id);
+    if (disp.elem(VERTS).get_show())
+      add_verts(disp, id);
+    if (disp.elem(EDGES).get_show())
+      add_edges(disp, id);
+  });
+
+  // JSON chunk is padded with spaces, and binary chunk with zeros, to
+  // a multiple of 4 bytes
+  string json_chunk = json();
+  json_chunk.resize((json_chunk.size() + 3) & ~3, ' ');
+  bin.resize((bin.size() + 3) & ~3, 0);
+
+  // header ("glTF", version, length), and headers of JSON and BIN chunks
+  uint32_t hdr_vals[] = {0x46546C67,
+                         2,
+                         (uint32_t)(28 + json_chunk.size() + bin.size()),
+                         (uint32_t)json_chunk.size(),
+                         0x4E4F534A,
+                         (uint32_t)bin.size(),
+                         0x004E4942};
+  if (!bin.size())
+    hdr_vals[2] -= 8; // no BIN chunk
+  unsigned char words[4 * 7];
+  for (int w = 0; w < 7; w++)
+    for (int i = 0; i < 4; i++) // little endian
+      words[4 * w + i] = (hdr_vals[w] >> (8 * i)) & 0xFF;
+
+  fwrite(words, 1, 20, ofile);
+  fwrite(json_chunk.data(), 1, json_chunk.size(), ofile);
+  if (bin.size()) {
+    fwrite(words + 20, 1, 8, ofile);
+    fwrite(bin.data(), 1, bin.size(), ofile);
+  }
+  if (ferror(ofile))
+    return Status::error("could not write output file");
+
+  return Status::ok();
+}
+
+// --------------------------------------------------------------------------
+// Options class
+
+class o2g_opts : public ViewOpts {
+public:
+  int smooth_lvl;
+  string ofile;
+
+  o2g_opts() : ViewOpts("off2glb"), smooth_lvl(3) {}
+  void usage();
+  void process_command_line(int argc, char **argv);
+};
+
+// --------------------------------------------------------------------------
+// Options implementation
+
+// clang-format off
+void o2g_opts::usage()
+{
+   fprintf(stdout,
+"\n"
+"Usage: %s [options] [input_file]\n"
+"\n"
+"Convert an OFF file to binary glTF (GLB) file format. Faces are flat\n"
+"shaded triangles grouped by colour. Vertex spheres and edge cylinders are\n"
+"written as instanced meshes (extension EXT_mesh_gpu_instancing).\n"
+"\n"
+"Options\n"
+"%s"
+"  -v <rad>  radius of vertex spheres, or 'b' to have radius of balls\n"
+"            of the maximum size without overlap (default: ball_rad/15)\n"
+"  -e <rad>  radius of edge cylinders (default: vertex_rad/1.5)\n"
+"  -V <col>  default vertex colour, in form 'R,G,B,A' (3 or 4 values\n"
+"            0.0-1.0, or 0-255) or hex 'xFFFFFF' (default: 1.0,0.5,0.0)\n"
+"  -E <col>  default edge colour, in form 'R,G,B,A' (3 or 4 values\n"
+"            0.0-1.0, or 0-255) or hex 'xFFFFFF', 'x' to hide implicit edges\n"
+"            (default: 0.8,0.6,0.8)\n"
+"  -F <col>  default face colour, in form 'R,G,B,A' (3 or 4 values\n"
+"            0.0-1.0, or 0-255) or hex 'xFFFFFF' (default: 0.8,0.9,0.9)\n"
+"  -x <elms> hide elements. The element string can include v, e and f\n"
+"            to hide vertices, edges and faces\n"
+"  -t <disp> select face parts to display according to winding number from:\n"
+"            odd, nonzero (default), positive, negative, no_triangulation\n"
+"            (triangulate each polygon as a fan)\n"
+"  -m <maps> a comma separated list of colour maps used to transform colour\n"
+"            indexes, a part consisting of letters from v, e, f, selects \n"
+"            the element types to apply the map list to (default 'vef').\n"
+"  -K <lvl>  a positive integer to specify the level of smoothing (using more\n"
+"            polygons) of the vertex spheres and edge cylinders (default: %d)\n"
+"  -o <file> write output to file (default: write to standard output)\n"
+"\n"
+"\n", prog_name(), help_ver_text, smooth_lvl);
+}
+// clang-format on
+
+void o2g_opts::process_command_line(int argc, char **argv)
+{
+  opterr = 0;
+  int c;
+  Status stat;
+
+  handle_long_opts(argc, argv);
+
+  while ((c = getopt(argc, argv, ":hv:e:V:E:F:x:t:m:K:o:")) != -1) {
+    if (common_opts(c, optopt))
+      continue;
+
+    switch (c) {
+
+    case 'K':
+      print_status_or_exit(read_int(optarg, &smooth_lvl), c);
+      if (smooth_lvl < 1)
+        error("smooth level cannot be less than 1", c);
+      if (smooth_lvl > 7)
+        warning("higher values increase the model size and may not be "
+                "visually distinguishable from a lower value",
+                c);
+      break;
+
+    case 'o':
+      ofile = optarg;
+      break;
+
+    default:
+      if (!(stat = read_disp_option(c, optarg))) {
+        if (stat.is_warning())
+          warning(stat.msg(), c);
+        else
+          error(stat.msg(), c);
+      }
+    }
+  }
+
+  if (!get_geom_defs().elem(VERTS).get_show() &&
+      !get_geom_defs().elem(EDGES).get_show() &&
+      !get_geom_defs().elem(FACES).get_show())
+    error("cannot hide all elements", 'x');
+
+  if (argc - optind >= 1)
+    while (argc - optind >= 1)
+      ifiles.push_back(argv[optind++]);
+  else
+    ifiles.push_back("");
+}
+
+// --------------------------------------------------------------------------
+// Main
+
+int main(int argc, char *argv[])
+{
+  o2g_opts opts;
+  opts.process_command_line(argc, argv);
+  Scene scen = opts.scen_defs;
+  opts.set_view_vals(scen);
+
+  FILE *ofile = stdout; // write to stdout by default
+  if (opts.ofile != "") {
+    ofile = fopen(opts.ofile.c_str(), "wb");
+    if (ofile == nullptr)
+      opts.error("could not open output file \'" + opts.ofile + "\'");
+  }
+
+  GLB_writer glb(opts.smooth_lvl);
+  opts.print_status_or_exit(glb.write(ofile, scen));
+
+  bool write_err = (ofile != stdout) ? fclose(ofile) != 0 : fflush(ofile) != 0;
+  if (write_err)
+    opts.error(msg_str("could not write output file '%s'",
+                       (opts.ofile != "") ? opts.ofile.c_str() : "stdout"));
+
+  return 0;
+}
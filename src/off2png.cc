@@ -0,0 +1,305 @@
+/*
+   Copyright (c) 2003-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*
+   Name: off2png.cc
+   Description: render an OFF file to an image in PNG or PPM format
+   Project: Antiprism - http://www.antiprism.com
+*/
+
+#include "../base/antiprism.h"
+#include "batch.h"
+
+#include <string.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+using namespace anti;
+
+class o2png_opts : public ViewOpts {
+public:
+  int width;
+  int height;
+  int samples;
+  string format;
+  string odir;
+  string ofile;
+
+  o2png_opts()
+      : ViewOpts("off2png"), width(512), height(512), samples(2)
+  {
+  }
+
+  void process_command_line(int argc, char **argv);
+  void usage();
+};
+
+// clang-format off
+void o2png_opts::usage()
+{
+   fprintf(stdout,
+"\n"
+"Usage: %s [options] input_files\n"
+"\n"
+"Render files in OFF format to an image in PNG (or PPM) format, without\n"
+"a display. The view is the same as the initial view in antiview. If\n"
+"input_files are not given the program reads from standard input.\n"
+"\n"
+"Options\n"
+"%s"
+"  -v <rad>  radius of vertex spheres, or 'b' to have radius of balls\n"
+"            of the maximum size without overlap (default: ball_rad/15)\n"
+"  -e <rad>  radius of edge cylinders (default: vertex_rad/1.5)\n"
+"  -V <col>  default vertex colour, in form 'R,G,B,A' (3 or 4 values\n"
+"            0.0-1.0, or 0-255) or hex 'xFFFFFF' (default: 1.0,0.5,0.0)\n"
+"  -E <col>  default edge colour, in form 'R,G,B,A' (3 or 4 values\n"
+"            0.0-1.0, or 0-255) or hex 'xFFFFFF', 'x' to hide implicit edges\n"
+"            (default: 0.8,0.6,0.8)\n"
+"  -F <col>  default face colour, in form 'R,G,B,A' (3 or 4 values\n"
+"            0.0-1.0, or 0-255) or hex 'xFFFFFF' (default: 0.8,0.9,0.9)\n"
+"  -x <elms> hide elements. The element string can include v, e and f\n"
+"            to hide vertices, edges and faces\n"
+"  -s <syms> show symmetry elements. The element string can include\n"
+"               x - rotation axes\n"
+"               m - mirror planes\n"
+"               r - rotation-reflection planes\n"
+"               a - all elements (same as xmr)\n"
+"  -m <maps> a comma separated list of colour maps used to transform colour\n"
+"            indexes, a part consisting of letters from v, e, f, selects \n"
+"            the element types to apply the map list to (default 'vef').\n"
+"  -t <disp> select face parts to display according to winding number from:\n"
+"            odd, nonzero (default), positive, negative, no_triangulation\n"
+"            (use native polygon display)\n"
+"  -S <size> image size in pixels, 'width,height' or a single value for\n"
+"            a square image (default: 512)\n"
+"  -A <num>  antialiasing, the number of samples along each side of a pixel,\n"
+"            which also blends transparent elements (default: 2)\n"
+"  -T <type> image type, png or ppm (default: ppm if the output file name\n"
+"            ends in .ppm, otherwise png)\n"
+"  -O <dir>  write an image of each model, rather than one image of all\n"
+"            the models, to files in this directory named after the model\n"
+"            (with its number added if models have the same name). An\n"
+"            input may also be an archive or a directory of models. The\n"
+"            models are rendered in parallel, and a JSON line is written\n"
+"            for each model\n"
+"  -o <file> write output to file (default: write to standard output)\n"
+"\n"
+"  Scene options\n"
+"%s"
+"\n"
+"\n", prog_name(), help_ver_text, help_scene_text);
+}
+// clang-format on
+
+void o2png_opts::process_command_line(int argc, char **argv)
+{
+  Status stat;
+  opterr = 0;
+  int c;
+
+  handle_long_opts(argc, argv);
+
+  while ((c = getopt(argc, argv, ":hv:e:V:E:F:m:x:s:t:S:A:T:O:o:D:C:L:R:B:")) !=
+         -1) {
+    if (common_opts(c, optopt))
+      continue;
+
+    switch (c) {
+    case 'S': {
+      vector<int> sizes;
+      print_status_or_exit(read_int_list(optarg, sizes, true, 2), c);
+      if (sizes.size() == 0)
+        error("no image size given", c);
+      if (sizes[0] < 1 || sizes.back() < 1)
+        error("image size must be positive", c);
+      width = sizes[0];
+      height = sizes.back();
+      break;
+    }
+
+    case 'A':
+      print_status_or_exit(read_int(optarg, &samples), c);
+      if (samples < 1 || samples > 8)
+        error("number of samples must be between 1 and 8", c);
+      break;
+
+    case 'T':
+      if (strcmp(optarg, "png") && strcmp(optarg, "ppm"))
+        error(msg_str("image type '%s' must be png or ppm", optarg), c);
+      format = optarg;
+      break;
+
+    case 'O':
+      odir = optarg;
+      break;
+
+    case 'o':
+      ofile = optarg;
+      break;
+
+    default:
+      if (!(stat = read_disp_option(c, optarg))) {
+        if (stat.is_warning())
+          warning(stat.msg(), c);
+        else
+          error(stat.msg(), c);
+      }
+    }
+  }
+
+  if (odir != "" && ofile != "")
+    error("cannot write one output file for images of each model", 'o');
+
+  if (format == "") {
+    size_t len = ofile.size();
+    format = (len > 4 && ofile.compare(len - 4, 4, ".ppm") == 0) ? "ppm"
+                                                                 : "png";
+  }
+
+  if (argc - optind >= 1)
+    while (argc - optind >= 1)
+      ifiles.push_back(argv[optind++]);
+  else
+    ifiles.push_back("");
+}
+
+// Image name for a model, from the model name without any directory,
+// archive name or OFF extension
+string image_base_name(const string &model_name)
+{
+  string name = model_name;
+  size_t pos = name.find_last_of("/#");
+  if (pos != string::npos)
+    name = name.substr(pos + 1);
+  if (name.size() > 4 && name.compare(name.size() - 4, 4, ".off") == 0)
+    name.resize(name.size() - 4);
+  if (name == "" || name == "-")
+    name = "stdin";
+  return name;
+}
+
+// Image file names for the models. Models with the same image name have
+// their index number added, so that each model has its own file.
+vector<string> image_file_names(const o2png_opts &opts,
+                                const BatchInputs &inputs)
+{
+  vector<string> names(inputs.size());
+  map<string, int> name_cnts;
+  for (int i = 0; i < inputs.size(); i++) {
+    names[i] = image_base_name(inputs.get_name(i));
+    name_cnts[names[i]]++;
+  }
+
+  set<string> used;
+  for (const auto &kp : name_cnts)
+    used.insert(kp.first);
+  for (int i = 0; i < inputs.size(); i++) {
+    if (name_cnts[names[i]] > 1) {
+      string name = names[i] + "_" + std::to_string(i);
+      while (used.count(name))
+        name += "_" + std::to_string(i);
+      used.insert(name);
+      names[i] = name;
+    }
+  }
+
+  for (auto &name : names)
+    name = opts.odir + "/" + name + "." + opts.format;
+  return names;
+}
+
+// Render each model to its own image file
+void process_batch(const o2png_opts &opts)
+{
+  BatchInputs inputs;
+  for (auto &ifile : opts.ifiles)
+    opts.print_status_or_exit(inputs.add(ifile));
+
+  RasterWriter raster;
+  raster.set_size(opts.width, opts.height);
+  raster.set_samples(opts.samples);
+
+  vector<string> img_names = image_file_names(opts, inputs);
+  BatchWriter writer(stdout, 'j');
+  run_batch(
+      inputs,
+      [&](int idx, Geometry &geom, BatchRecord &rec) {
+        Scene scen;
+        string name = inputs.get_name(idx);
+        Status stat = opts.set_view_vals(scen, geom, basename2(name.c_str()));
+        const string &img_name = img_names[idx];
+        FILE *ofile = fopen(img_name.c_str(), "wb");
+        if (ofile == nullptr)
+          return Status::error("could not open output file \'" + img_name +
+                               "\'");
+        Status wstat = raster.write(ofile, scen, opts.format);
+        if (fclose(ofile) != 0 && !wstat.is_error())
+          wstat.set_error("could not write output file \'" + img_name + "\'");
+        if (wstat.is_error())
+          return wstat;
+        rec.push_back(std::make_pair("image", img_name));
+        return stat;
+      },
+      writer);
+}
+
+int main(int argc, char *argv[])
+{
+  o2png_opts opts;
+  opts.process_command_line(argc, argv);
+
+  if (opts.odir != "") {
+    process_batch(opts);
+    return 0;
+  }
+
+  Scene scen = opts.scen_defs;
+  opts.set_view_vals(scen);
+
+  FILE *ofile = stdout; // write to stdout by default
+  if (opts.ofile != "") {
+    ofile = fopen(opts.ofile.c_str(), "wb");
+    if (ofile == nullptr)
+      opts.error("could not open output file \'" + opts.ofile + "\'");
+  }
+
+  RasterWriter raster;
+  raster.set_size(opts.width, opts.height);
+  raster.set_samples(opts.samples);
+  opts.print_status_or_exit(raster.write(ofile, scen, opts.format));
+
+  bool write_err = (ofile != stdout) ? fclose(ofile) != 0 : fflush(ofile) != 0;
+  if (write_err)
+    opts.error(msg_str("could not write output file '%s'",
+                       (opts.ofile != "") ? opts.ofile.c_str() : "stdout"));
+
+  return 0;
+}
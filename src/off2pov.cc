@@ -75,6 +75,9 @@ void o2p_opts::usage()
 "%s"
 "  -O <type> output type, can be: 'a' all in one POV file (default),\n"
 "            's' separate files, 'o' objects only, 't' template only\n"
+"  -M        compact output for large models, faces are written as mesh2\n"
+"            objects and vertices and edges as unions grouped by colour\n"
+"            (the disp_vertex, disp_edge and disp_face macros are not used)\n"
 "  -i <fils> include files (separated by commas) for every POV geometry\n"
 "  -j <fils> include files (separated by commas) for the POV scene file\n"
 "  -J <fils> include files (separated by commas) containing additional POV\n"
@@ -93,7 +96,7 @@ void o2p_opts::usage()
 "  Precision options\n"
 "%s"
 "\n"
-"\n", prog_name(), help_ver_text, help_view_text,
+"\n", prog_name(), help_ver_no_threads_text, help_view_text,
       help_scene_text, help_prec_text);
 }
 // clang-format on
@@ -106,9 +109,9 @@ void o2p_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv,
-                     ":hv:e:V:E:F:m:x:s:n:o:D:C:L:R:P:W:S:B:d:t:I:j:J:i:O:")) !=
-         -1) {
+  while ((c = getopt(
+              argc, argv,
+              ":hv:e:V:E:F:m:x:s:n:o:D:C:L:R:P:W:S:B:d:t:I:j:J:i:O:M")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -153,6 +156,10 @@ void o2p_opts::process_command_line(int argc, char **argv)
       o_type = *optarg;
       break;
 
+    case 'M':
+      get_geom_defs().set_pov_mesh(true);
+      break;
+
     default:
       if (!(stat = read_disp_option(c, optarg))) {
         if (stat.is_warning())
@@ -64,6 +64,8 @@ void o2v_opts::usage()
 "%s"
 "%s"
 "  -l        use lines for edges, points for vertices, in default colours\n"
+"  -M        compact output for large models, vertex and edge elements\n"
+"            use a prototype for each colour, faces use indexed colours\n"
 "  -o <file> write output to file (default: write to standard output)\n"
 "\n"
 "  Scene options\n"
@@ -86,7 +88,7 @@ void o2v_opts::process_command_line(int argc, char **argv)
   handle_long_opts(argc, argv);
 
   while ((c = getopt(argc, argv,
-                     ":hv:e:V:E:F:m:x:n:s:lo:D:C:L:R:P:I:B:d:t:")) != -1) {
+                     ":hv:e:V:E:F:m:x:n:s:lMo:D:C:L:R:P:I:B:d:t:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -99,6 +101,10 @@ void o2v_opts::process_command_line(int argc, char **argv)
       get_geom_defs().set_use_lines(true);
       break;
 
+    case 'M':
+      get_geom_defs().set_vrml_compact(true);
+      break;
+
     case 'd':
       print_status_or_exit(read_int(optarg, &sig_dgts), c);
       if (sig_dgts < 1)
@@ -0,0 +1,210 @@
+/*
+   Copyright (c) 2006-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*
+   Name: off_batch.cc
+   Description: make many resource models, and write them to an archive
+   Project: Antiprism - http://www.antiprism.com
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ctype.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../base/antiprism.h"
+
+using std::string;
+using std::vector;
+
+using namespace anti;
+
+class ob_opts : public ProgramOpts {
+public:
+  vector<string> names;
+  bool print_times;
+  bool append;
+  int sig_digits;
+  string ofile;
+
+  ob_opts()
+      : ProgramOpts("off_batch"), print_times(false),
+        append(false), sig_digits(DEF_SIG_DGTS)
+  {
+  }
+  void process_command_line(int argc, char **argv);
+  void usage();
+};
+
+// clang-format off
+void ob_opts::usage()
+{
+   fprintf(stdout,
+"\n"
+"Usage: %s [options] model_name ...\n"
+"\n"
+"Make resource models (run 'off_util -H models' for a list) in parallel,\n"
+"and write them to a single archive file, with an index of the models.\n"
+"A name may include a number range, which is expanded into a model name\n"
+"for each number, e.g. u1-80 (uniform), j1-92 (Johnson), w1-119\n"
+"(Wenninger), u1-80_d (uniform duals) or std_j1-92 (raw Johnson). A model\n"
+"in an archive can be read by any program as archive#model_name\n"
+"\n"
+"Options\n"
+"%s"
+"  -t        print the time taken to make each model (to standard error)\n"
+"  -a        append the models to the output file, if it is an archive\n"
+"  -d <dgts> number of significant digits (default %d) or if negative\n"
+"            then the number of digits after the decimal point\n"
+"  -o <file> write output to file (default: write to standard output)\n"
+"\n"
+"\n", prog_name(), help_ver_text, DEF_SIG_DGTS);
+}
+// clang-format on
+
+// Expand a name like u1-80 or std_u1-80_d into a name for each number,
+// otherwise return the name unchanged.
+static Status expand_name(const string &name, vector<string> &names)
+{
+  size_t pre_len = (name.compare(0, 4, "std_") == 0) ? 4 : 0;
+  while (pre_len < name.size() && isalpha(name[pre_len]))
+    pre_len++;
+  size_t dash = name.find('-', pre_len);
+  size_t suf_pos = name.find_first_not_of("0123456789", dash + 1);
+  if (suf_pos == string::npos)
+    suf_pos = name.size();
+  if (pre_len == 0 || dash == string::npos || dash == pre_len ||
+      suf_pos == dash + 1 ||
+      name.find_first_not_of("0123456789", pre_len) != dash) {
+    names.push_back(name);
+    return Status::ok();
+  }
+
+  int first = atoi(name.substr(pre_len, dash - pre_len).c_str());
+  int last = atoi(name.substr(dash + 1, suf_pos - dash - 1).c_str());
+  if (last < first)
+    return Status::error(
+        msg_str("name '%s': last number is less than first", name.c_str()));
+
+  string prefix = name.substr(0, pre_len);
+  string suffix = name.substr(suf_pos);
+  for (int i = first; i <= last; i++)
+    names.push_back(prefix + std::to_string(i) + suffix);
+
+  return Status::ok();
+}
+
+void ob_opts::process_command_line(int argc, char **argv)
+{
+  opterr = 0;
+  int c;
+
+  handle_long_opts(argc, argv);
+
+  while ((c = getopt(argc, argv, ":htad:o:")) != -1) {
+    if (common_opts(c, optopt))
+      continue;
+
+    switch (c) {
+    case 't':
+      print_times = true;
+      break;
+
+    case 'a':
+      append = true;
+      break;
+
+    case 'd':
+      print_status_or_exit(read_int(optarg, &sig_digits), c);
+      break;
+
+    case 'o':
+      ofile = optarg;
+      break;
+
+    default:
+      error("unknown command line error");
+    }
+  }
+
+  if (argc - optind < 1)
+    error("no model names given");
+
+  for (int i = optind; i < argc; i++)
+    print_status_or_exit(expand_name(argv[i], names));
+}
+
+int main(int argc, char *argv[])
+{
+  ob_opts opts;
+  opts.process_command_line(argc, argv);
+
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+
+  int num_models = opts.names.size();
+  vector<Geometry> geoms(num_models);
+  vector<Status> stats(num_models);
+  vector<double> times(num_models);
+  parallel_for(0, num_models, [&](long i) {
+    auto model_start = clock::now();
+    stats[i] = geoms[i].read_resource(opts.names[i]);
+    times[i] = std::chrono::duration<double>(clock::now() - model_start)
+                   .count();
+  });
+
+  for (int i = 0; i < num_models; i++)
+    opts.print_status_or_exit(stats[i],
+                              msg_str("model '%s'", opts.names[i].c_str()));
+
+  ArchiveWriter archive;
+  opts.print_status_or_exit(archive.open(opts.ofile, opts.append), 'o');
+  for (int i = 0; i < num_models; i++)
+    opts.print_status_or_exit(
+        archive.add(opts.names[i], geoms[i], opts.sig_digits));
+  opts.print_status_or_exit(archive.close());
+
+  if (opts.print_times) {
+    double total = 0;
+    for (int i = 0; i < num_models; i++) {
+      fprintf(stderr, "%-24s %10.3f ms  (V=%lu, F=%lu)\n",
+              opts.names[i].c_str(), times[i] * 1000,
+              (unsigned long)geoms[i].verts().size(),
+              (unsigned long)geoms[i].faces().size());
+      total += times[i];
+    }
+    double elapsed = std::chrono::duration<double>(clock::now() - start)
+                         .count();
+    fprintf(stderr, "%d models: %.3f ms model time, %.3f ms elapsed, "
+                    "%d thread%s\n",
+            num_models, total * 1000, elapsed * 1000, get_num_threads(),
+            (get_num_threads() == 1) ? "" : "s");
+  }
+
+  return 0;
+}
@@ -122,6 +122,11 @@ public:
   char edge_type;
   unsigned int selection;
 
+  bool proper_report;
+  long proper_iters;
+  unsigned int proper_seed;
+  double proper_secs;
+
   Coloring clrngs[3];
 
   char range_elems;
@@ -134,8 +139,9 @@ public:
 
   o_col_opts()
       : ProgramOpts("off_color"), v_col_op(0), e_col_op(0), f_col_op(0),
-        edge_type('x'), selection(0), range_elems(ELEM_NONE),
-        v2i_elems(ELEM_NONE)
+        edge_type('x'), selection(0), proper_report(false),
+        proper_iters(100000), proper_seed(0), proper_secs(0),
+        range_elems(ELEM_NONE), v2i_elems(ELEM_NONE)
   {
   }
 
@@ -222,6 +228,12 @@ void o_col_opts::usage()
 "            a comma and elements to map from v, e, f (H0:1S0:1V0:1A0:1,vef)\n"
 "  -I <elms> map color values to index numbers (after other procesing)\n"
 "            elements to map are from v, e and f (default none)\n"
+"  -P <its>  proper colouring, maximum steps of each search for fewer\n"
+"            colours (0 for no search), optionally followed by a comma and\n"
+"            a random seed, and a comma and a time limit for the searches in\n"
+"            seconds (0 for no limit, a limit makes the result depend on the\n"
+"            speed of the machine). Print the number of colours used and a\n"
+"            lower bound for the minimum (default: 100000,0,0 and no print)\n"
 "  -w <wdth> width of sphere containing points (default: calculated)\n"
 "  -U <typs> colour only elements with particular current colour types:\n"
 "            u - unset, i - indexed, v - visible colour value, x - invisible.\n"
@@ -243,7 +255,7 @@ void o_col_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hv:f:e:E:s:m:c:l:U:o:r:I:")) != -1) {
+  while ((c = getopt(argc, argv, ":hv:f:e:E:s:m:c:l:P:U:o:r:I:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -322,6 +334,32 @@ void o_col_opts::process_command_line(int argc, char **argv)
       print_status_or_exit(read_colorings(clrngs, optarg), c);
       break;
 
+    case 'P': {
+      split_line(optarg, parts, ",");
+      if (parts.size() == 0)
+        error("no search steps given", c);
+      if (parts.size() > 3)
+        error("too many comma separated parts", c);
+      int num;
+      print_status_or_exit(read_int(parts[0], &num), c);
+      if (num < 0)
+        error("number of search steps cannot be negative", c);
+      proper_iters = num;
+      if (parts.size() > 1) {
+        print_status_or_exit(read_int(parts[1], &num), c);
+        if (num < 0)
+          error("random seed cannot be negative", c);
+        proper_seed = num;
+      }
+      if (parts.size() > 2) {
+        print_status_or_exit(read_double(parts[2], &proper_secs), c);
+        if (proper_secs < 0)
+          error("time limit cannot be negative", c);
+      }
+      proper_report = true;
+      break;
+    }
+
     case 'r': {
       char r_elems;
       ColorValuesToRangeHsva col_proc;
@@ -481,6 +519,14 @@ bool warn_if_not_subgroup(const ProgramOpts &opts, char opt,
   return true; // is subgroup
 }
 
+void print_proper_report(const o_col_opts &opts, const Coloring &clrng,
+                         const char *elems)
+{
+  opts.message(msg_str("proper colouring of %s: %d colours, lower bound %d",
+                       elems, clrng.get_proper_num_cols(),
+                       clrng.get_proper_lower_bound()));
+}
+
 int main(int argc, char *argv[])
 {
   o_col_opts opts;
@@ -549,6 +595,7 @@ int main(int argc, char *argv[])
 
   Coloring &fc = opts.clrngs[FACES];
   fc.set_geom(&geom);
+  fc.set_proper_opts(opts.proper_seed, opts.proper_iters, opts.proper_secs);
   if (opts.f_col_op) {
     char op = opts.f_col_op;
     ColorMap *cmap = nullptr;
@@ -564,8 +611,11 @@ int main(int argc, char *argv[])
       fc.f_one_col(opts.f_col);
     else if (strchr("uU", op))
       fc.f_unique(op == 'U');
-    else if (strchr("pP", op))
+    else if (strchr("pP", op)) {
       fc.f_proper(op == 'P');
+      if (opts.proper_report)
+        print_proper_report(opts, fc, "faces");
+    }
     else if (strchr("sS", op))
       fc.f_sets(sym_equivs[2], op == 'S');
     else if (strchr("nN", op))
@@ -588,6 +638,7 @@ int main(int argc, char *argv[])
 
   Coloring &ec = opts.clrngs[EDGES];
   ec.set_geom(&geom);
+  ec.set_proper_opts(opts.proper_seed, opts.proper_iters, opts.proper_secs);
   if (opts.e_col_op) {
     char op = opts.e_col_op;
     ColorMap *cmap = nullptr;
@@ -603,8 +654,11 @@ int main(int argc, char *argv[])
       ec.e_one_col(opts.e_col);
     else if (strchr("uU", op))
       ec.e_unique(op == 'U');
-    else if (strchr("pP", op))
+    else if (strchr("pP", op)) {
       ec.e_proper(op == 'P');
+      if (opts.proper_report)
+        print_proper_report(opts, ec, "edges");
+    }
     else if (strchr("sS", op))
       ec.e_sets(sym_equivs[1], op == 'S');
     else if (strchr("kK", op))
@@ -625,6 +679,7 @@ int main(int argc, char *argv[])
 
   Coloring &vc = opts.clrngs[VERTS];
   vc.set_geom(&geom);
+  vc.set_proper_opts(opts.proper_seed, opts.proper_iters, opts.proper_secs);
   if (opts.v_col_op) {
     char op = opts.v_col_op;
     ColorMap *cmap = nullptr;
@@ -640,8 +695,11 @@ int main(int argc, char *argv[])
       vc.v_one_col(opts.v_col);
     else if (strchr("uU", op))
       vc.v_unique(op == 'U');
-    else if (strchr("pP", op))
+    else if (strchr("pP", op)) {
       vc.v_proper(op == 'P');
+      if (opts.proper_report)
+        print_proper_report(opts, vc, "vertices");
+    }
     else if (strchr("sS", op))
       vc.v_sets(sym_equivs[0], op == 'S');
     else if (strchr("nN", op))
@@ -0,0 +1,443 @@
+/*
+   Copyright (c) 2006-2016, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*
+   Name: off_pipe.cc
+   Description: pass models through a chain of operations, in memory
+   Project: Antiprism - http://www.antiprism.com
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../base/antiprism.h"
+
+using std::set;
+using std::string;
+using std::vector;
+
+using namespace anti;
+
+// A stage operates on a model, in place
+typedef std::function<Status(Geometry &)> Stage;
+
+class op_opts : public ProgramOpts {
+public:
+  vector<string> ifiles;
+  string ofile;
+
+  vector<Stage> stages;
+  double epsilon;
+
+  op_opts() : ProgramOpts("off_pipe"), epsilon(0) {}
+
+  void process_command_line(int argc, char **argv);
+  void usage();
+};
+
+// clang-format off
+void op_opts::usage()
+{
+   fprintf(stdout,
+"\n"
+"Usage: %s [options] [input_files]\n"
+"\n"
+"Pass each input model through a chain of stages, in the order the stages\n"
+"are given, without writing any intermediate files. If there are several\n"
+"input models they are processed in parallel, and written to an archive in\n"
+"the order they were given (an input archive is taken as all the models it\n"
+"holds). If input_files is not given the program reads from standard input.\n"
+"\n"
+"Options\n"
+"%s"
+"  -S <stg>  add a stage to the chain. The stage is a name followed by any\n"
+"            comma separated arguments\n"
+"              merge[,elems]  merge coincident elements, any of v, e, f,\n"
+"                   or s to only sort elements (default: vef)\n"
+"              sym[,sub[,conj[,realign]]]  align with the standard position\n"
+"                   of a (sub)symmetry, arguments as for off_trans -y\n"
+"                   (default: full)\n"
+"              centre  translate centroid to origin\n"
+"              scale,fact  scale by a factor\n"
+"              rotate,X,Y,Z  rotate about the axes, angles in degrees\n"
+"              translate,X,Y,Z  translate\n"
+"              dual[,rad]  polar reciprocal about the centroid (default\n"
+"                   radius: average nearest distance of edges to centroid)\n"
+"              canonical[,itrs]  canonicalize, base/dual method (default\n"
+"                   number of iterations: -1, until it completes)\n"
+"              color,elem,type  color elements, elem is v, e or f, type is\n"
+"                   as for off_color, one of: u,U unique, p,P proper,\n"
+"                   s,S symmetry, k,K parts (e, f), n,N sides (f)\n"
+"  -l <lim>  minimum distance for unique vertex locations as negative exponent\n"
+"               (default: %d giving %.0e)\n"
+"  -o <file> write output to file (default: write to standard output)\n"
+"\n"
+"\n", prog_name(), help_ver_text, int(-log(::epsilon)/log(10) + 0.5),
+   ::epsilon);
+}
+// clang-format on
+
+static Status read_doubles(const vector<char *> &parts, vector<double> &nums,
+                           unsigned int num_args)
+{
+  if (parts.size() - 1 != num_args)
+    return Status::error(
+        msg_str("stage '%s' takes %u number%s", parts[0], num_args,
+                (num_args == 1) ? "" : "s"));
+  nums.resize(num_args);
+  for (unsigned int i = 0; i < num_args; i++) {
+    Status stat = read_double(parts[i + 1], &nums[i]);
+    if (stat.is_error())
+      return Status::error(
+          msg_str("stage '%s': %s", parts[0], stat.c_msg()));
+  }
+  return Status::ok();
+}
+
+static Status color_stage(Geometry &geom, int elem_type, char op)
+{
+  vector<vector<set<int>>> sym_equivs;
+  if (strchr("sS", op)) {
+    Symmetry sym(geom);
+    get_equiv_elems(geom, sym.get_trans(), &sym_equivs);
+  }
+
+  Coloring clrng(&geom);
+  clrng.add_cmap(colormap_from_name("spread"));
+  if (elem_type == FACES) {
+    if (strchr("uU", op))
+      clrng.f_unique(op == 'U');
+    else if (strchr("pP", op))
+      clrng.f_proper(op == 'P');
+    else if (strchr("sS", op))
+      clrng.f_sets(sym_equivs[2], op == 'S');
+    else if (strchr("kK", op))
+      clrng.f_parts(op == 'K');
+    else if (strchr("nN", op))
+      clrng.f_sides(op == 'N');
+  }
+  else if (elem_type == EDGES) {
+    if (strchr("uU", op))
+      clrng.e_unique(op == 'U');
+    else if (strchr("pP", op))
+      clrng.e_proper(op == 'P');
+    else if (strchr("sS", op))
+      clrng.e_sets(sym_equivs[1], op == 'S');
+    else if (strchr("kK", op))
+      clrng.e_parts(op == 'K');
+  }
+  else {
+    if (strchr("uU", op))
+      clrng.v_unique(op == 'U');
+    else if (strchr("pP", op))
+      clrng.v_proper(op == 'P');
+    else if (strchr("sS", op))
+      clrng.v_sets(sym_equivs[0], op == 'S');
+  }
+  return Status::ok();
+}
+
+// Make a stage from its description, and check the arguments
+static Status make_stage(char *desc, Stage &stage, double eps)
+{
+  vector<char *> parts;
+  split_line(desc, parts, ",", true);
+  if (parts.size() == 0)
+    return Status::error("stage name not given");
+
+  string name = parts[0];
+  int num_args = parts.size() - 1;
+  vector<double> nums;
+  Status stat;
+
+  if (name == "merge") {
+    if (num_args > 1)
+      return Status::error("stage 'merge' takes at most one argument");
+    string elems = (num_args) ? parts[1] : "vef";
+    if (strspn(elems.c_str(), "vefs") != elems.size() ||
+        (elems.find('s') != string::npos && elems.size() > 1))
+      return Status::error(msg_str(
+          "stage 'merge': elements are '%s', must be from v, e, f, or s",
+          elems.c_str()));
+    if (elems == "s")
+      elems = "";
+    stage = [=](Geometry &geom) {
+      merge_coincident_elements(geom, elems, eps);
+      return Status::ok();
+    };
+  }
+  else if (name == "sym") {
+    if (num_args > 3)
+      return Status::error("stage 'sym' takes at most three arguments");
+    string sub_name = (num_args > 0) ? parts[1] : "full";
+    int conj = 0;
+    if (num_args > 1 && !(stat = read_int(parts[2], &conj)))
+      return Status::error(
+          msg_str("stage 'sym': conjugation number: %s", stat.c_msg()));
+    string realign = (num_args > 2) ? parts[3] : "";
+    Symmetry sub_sym;
+    if (sub_name != "full" && !(stat = sub_sym.init(sub_name, Trans3d())))
+      return Status::error(
+          msg_str("stage 'sym': sub-symmetry type: %s", stat.c_msg()));
+    stage = [=](Geometry &geom) {
+      Symmetry full_sym(geom);
+      Symmetry sym;
+      Status stat = full_sym.get_sub_sym(
+          (sub_name == "full") ? full_sym : sub_sym, &sym, conj);
+      if (stat.is_error())
+        return Status::error(msg_str("sub-symmetry: %s", stat.c_msg()));
+      if (realign != "" &&
+          (stat = sym.get_autos().set_realignment(realign)).is_error())
+        return Status::error(
+            msg_str("sub-symmetry realignment: %s", stat.c_msg()));
+      geom.transform(sym.get_autos().get_realignment() * sym.get_to_std());
+      return Status::ok();
+    };
+  }
+  else if (name == "centre" || name == "center") {
+    if (num_args)
+      return Status::error("stage 'centre' takes no arguments");
+    stage = [](Geometry &geom) {
+      geom.transform(Trans3d::translate(-geom.centroid()));
+      return Status::ok();
+    };
+  }
+  else if (name == "scale") {
+    if (!(stat = read_doubles(parts, nums, 1)))
+      return stat;
+    Trans3d trans = Trans3d::scale(nums[0]);
+    stage = [=](Geometry &geom) {
+      geom.transform(trans);
+      return Status::ok();
+    };
+  }
+  else if (name == "rotate") {
+    if (!(stat = read_doubles(parts, nums, 3)))
+      return stat;
+    Trans3d trans = Trans3d::rotate(
+        Vec3d(deg2rad(nums[0]), deg2rad(nums[1]), deg2rad(nums[2])));
+    stage = [=](Geometry &geom) {
+      geom.transform(trans);
+      return Status::ok();
+    };
+  }
+  else if (name == "translate") {
+    if (!(stat = read_doubles(parts, nums, 3)))
+      return stat;
+    Trans3d trans = Trans3d::translate(Vec3d(nums[0], nums[1], nums[2]));
+    stage = [=](Geometry &geom) {
+      geom.transform(trans);
+      return Status::ok();
+    };
+  }
+  else if (name == "dual") {
+    double rad = 0;
+    if (num_args) {
+      if (!(stat = read_doubles(parts, nums, 1)))
+        return stat;
+      rad = nums[0];
+      if (fabs(rad) < eps)
+        return Status::error("stage 'dual': radius cannot be zero");
+    }
+    stage = [=](Geometry &geom) {
+      Vec3d cent = geom.centroid();
+      double recip_rad = rad;
+      if (recip_rad == 0) {
+        GeometryInfo info(geom);
+        info.set_center(cent);
+        if (!info.num_iedges())
+          return Status::error("dual: model has no edges");
+        recip_rad = info.iedge_dist_lims().sum / info.num_iedges();
+      }
+      Geometry dual;
+      get_dual(dual, geom, recip_rad, cent);
+      geom = dual;
+      return Status::ok();
+    };
+  }
+  else if (name == "canonical") {
+    int num_iters = -1;
+    if (num_args > 1)
+      return Status::error("stage 'canonical' takes at most one argument");
+    if (num_args && !(stat = read_int(parts[1], &num_iters)))
+      return Status::error(
+          msg_str("stage 'canonical': iterations: %s", stat.c_msg()));
+    stage = [=](Geometry &geom) {
+      if (!canonicalize_bd(geom, num_iters, -1, eps))
+        return Status::warning("canonical: did not complete");
+      return Status::ok();
+    };
+  }
+  else if (name == "color" || name == "colour") {
+    if (num_args != 2)
+      return Status::error("stage 'color' takes two arguments");
+    const char *elem = parts[1];
+    const char *op = parts[2];
+    int elem_type = (strcmp(elem, "f") == 0)   ? FACES
+                    : (strcmp(elem, "e") == 0) ? EDGES
+                    : (strcmp(elem, "v") == 0) ? VERTS
+                                               : -1;
+    if (elem_type < 0)
+      return Status::error(
+          msg_str("stage 'color': element is '%s', must be v, e or f", elem));
+    const char *ops = (elem_type == FACES)   ? "uUpPsSkKnN"
+                      : (elem_type == EDGES) ? "uUpPsSkK"
+                                             : "uUpPsS";
+    if (strlen(op) != 1 || !strchr(ops, *op))
+      return Status::error(msg_str(
+          "stage 'color': type for element %s is '%s', must be one of %s",
+          elem, op, ops));
+    char col_op = *op;
+    stage = [=](Geometry &geom) {
+      return color_stage(geom, elem_type, col_op);
+    };
+  }
+  else
+    return Status::error(msg_str("unknown stage '%s'", name.c_str()));
+
+  return Status::ok();
+}
+
+void op_opts::process_command_line(int argc, char **argv)
+{
+  opterr = 0;
+  int c;
+
+  int sig_compare = INT_MAX;
+  vector<string> stage_descs;
+
+  handle_long_opts(argc, argv);
+
+  while ((c = getopt(argc, argv, ":hS:l:o:")) != -1) {
+    if (common_opts(c, optopt))
+      continue;
+
+    switch (c) {
+    case 'S':
+      stage_descs.push_back(optarg);
+      break;
+
+    case 'l':
+      print_status_or_exit(read_int(optarg, &sig_compare), c);
+      if (sig_compare < 0) {
+        warning("limit is negative, and so ignored", c);
+      }
+      if (sig_compare > DEF_SIG_DGTS) {
+        warning("limit is very small, may not be attainable", c);
+      }
+      break;
+
+    case 'o':
+      ofile = optarg;
+      break;
+
+    default:
+      error("unknown command line error");
+    }
+  }
+
+  for (int i = optind; i < argc; i++)
+    ifiles.push_back(argv[i]);
+  if (ifiles.size() == 0)
+    ifiles.push_back("");
+
+  epsilon = (sig_compare != INT_MAX) ? pow(10, -sig_compare) : ::epsilon;
+
+  // stages are made after epsilon is known
+  for (auto &desc : stage_descs) {
+    Stage stage;
+    print_status_or_exit(make_stage(&desc[0], stage, epsilon), 'S');
+    stages.push_back(stage);
+  }
+}
+
+// An input model, from a file or from an archive
+struct PipeInput {
+  string name;
+  const Archive *arc;
+  int arc_idx;
+};
+
+int main(int argc, char *argv[])
+{
+  op_opts opts;
+  opts.process_command_line(argc, argv);
+
+  // expand whole archives into their models
+  vector<PipeInput> inputs;
+  vector<std::unique_ptr<Archive>> archives;
+  for (auto &ifile : opts.ifiles) {
+    if (ifile != "" && ifile != "-" && Archive::is_archive(ifile)) {
+      archives.emplace_back(new Archive);
+      opts.print_status_or_exit(archives.back()->open(ifile));
+      for (int i = 0; i < archives.back()->size(); i++)
+        inputs.push_back(
+            {archives.back()->get_index()[i].name, archives.back().get(), i});
+    }
+    else
+      inputs.push_back({ifile, nullptr, 0});
+  }
+
+  int num_models = inputs.size();
+  vector<Geometry> geoms(num_models);
+  vector<vector<Status>> stats(num_models);
+  parallel_for(0, num_models, [&](long i) {
+    const PipeInput &in = inputs[i];
+    Status stat = (in.arc) ? in.arc->read(in.arc_idx, geoms[i])
+                           : geoms[i].read(in.name);
+    stats[i].push_back(stat);
+    for (unsigned int j = 0; j < opts.stages.size() && !stat.is_error();
+         j++) {
+      stat = opts.stages[j](geoms[i]);
+      stats[i].push_back(stat);
+    }
+  });
+
+  // report in input order, and stop at the first error
+  for (int i = 0; i < num_models; i++)
+    for (auto &stat : stats[i])
+      opts.print_status_or_exit(
+          stat, (num_models > 1)
+                    ? msg_str("model '%s'", inputs[i].name.c_str())
+                    : string());
+
+  if (num_models == 1 && !inputs[0].arc)
+    opts.write_or_error(geoms[0], opts.ofile);
+  else {
+    ArchiveWriter arc;
+    opts.print_status_or_exit(arc.open(opts.ofile), 'o');
+    for (int i = 0; i < num_models; i++)
+      opts.print_status_or_exit(arc.add(inputs[i].name, geoms[i]));
+    opts.print_status_or_exit(arc.close());
+  }
+
+  return 0;
+}
@@ -38,6 +38,7 @@
 #include <vector>
 
 #include "../base/antiprism.h"
+#include "batch.h"
 #include "rep_print.h"
 
 using std::pair;
@@ -56,21 +57,25 @@ public:
   vector<vector<int>> extra_faces;
   vector<vector<int>> extra_edges;
   vector<int> idxs;
+  vector<std::pair<char, char *>> args; // options applied to the model
   int sig_digits;
   string query;
   bool orient;
   char edge_type;
-  string ifile;
+  char batch_fmt;
+  vector<string> ifiles;
   string ofile;
 
   oq_opts()
       : ProgramOpts("off_query"), center(Vec3d(0, 0, 0)),
-        center_is_centroid(false), sig_digits(17), orient(true), edge_type('a')
+        center_is_centroid(false), sig_digits(17), orient(true),
+        edge_type('a'), batch_fmt('\0')
   {
   }
 
   void process_command_line(int argc, char **argv);
-  void post_process_command_line(int argc, char **argv, Geometry &geom);
+  // set the elements to query from the options that depend on the model
+  Status set_elems(Geometry &geom, vector<Status> &warns);
   void usage();
 };
 
@@ -80,8 +85,11 @@ void oq_opts::usage()
    fprintf(stdout,
 "\n"
 "Usage: %s [options] query [input_file]\n"
+"       %s -B <fmt> [options] query [inputs]\n"
 "\n"
 "Read a file in OFF format and list element data for specified elements.\n"
+"With option -B, query a batch of models, from files, directories of OFF\n"
+"files, archives, or OFF files one after another on standard input.\n"
 "Added elements of the query type are also added to the query list.\n"
 "Added elements are referred to by xN, where N is the order the element\n"
 "was added (starting with 0). Query is a list of letters, the first is the\n"
@@ -124,8 +132,12 @@ void oq_opts::usage()
 "  -o <file> write output to file (default: write to standard output)\n"
 "  -d <dgts> number of significant digits (default 17) or if negative\n"
 "            then the number of digits after the decimal point\n"
+"  -B <fmt>  batch mode, write a record for each model, with a value for\n"
+"            each element, keyed by the query type letter and the element\n"
+"            index, in the order of the inputs, fmt is j - JSON lines,\n"
+"            c - CSV\n"
 "\n"
-"\n", prog_name(), help_ver_text);
+"\n", prog_name(), prog_name(), help_ver_text);
 }
 // clang-format on
 
@@ -141,11 +153,10 @@ void oq_opts::process_command_line(int argc, char **argv)
 {
   opterr = 0;
   int c;
-  vector<pair<char, char *>> args;
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hc:I:v:f:e:kE:o:d:")) != -1) {
+  while ((c = getopt(argc, argv, ":hc:I:v:f:e:kE:o:d:B:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -156,7 +167,23 @@ void oq_opts::process_command_line(int argc, char **argv)
       edge_type = *optarg;
       break;
 
-    default:
+    case 'k':
+      orient = false;
+      break;
+
+    case 'd':
+      print_status_or_exit(read_int(optarg, &sig_digits), c);
+      break;
+
+    case 'o':
+      ofile = optarg;
+      break;
+
+    case 'B':
+      print_status_or_exit(read_batch_format(optarg, &batch_fmt), c);
+      break;
+
+    default: // elements and centre depend on the model
       args.push_back(pair<char, char *>(c, optarg));
     }
   }
@@ -168,11 +195,36 @@ void oq_opts::process_command_line(int argc, char **argv)
     error("the first letter of the query must be V, E or F");
   query = argv[optind++];
 
-  if (argc - optind == 1)
-    ifile = argv[optind];
-
-  read_or_error(geom, ifile);
+  // Check the query letters before any model is processed
+  const char *letters = (query[0] == 'V')   ? "cdfaoFngK"
+                        : (query[0] == 'E') ? "vfacdCDlK"
+                                            : "vnNasdACplPK";
+  size_t len = strspn(query.c_str() + 1, letters) + 1;
+  if (len < query.size())
+    error(msg_str("unknown query letter '%c'", query[len]),
+          string() + query[0] + " query");
+
+  if (batch_fmt) {
+    while (argc - optind)
+      ifiles.push_back(argv[optind++]);
+  }
+  else if (argc - optind == 1)
+    ifiles.push_back(argv[optind]);
+  if (!ifiles.size())
+    ifiles.push_back("");
+
+  if (!batch_fmt) {
+    read_or_error(geom, ifiles[0]);
+    vector<Status> warns;
+    Status stat = set_elems(geom, warns);
+    for (auto &warn : warns)
+      print_status_or_exit(warn);
+    print_status_or_exit(stat);
+  }
+}
 
+Status oq_opts::set_elems(Geometry &geom, vector<Status> &warns)
+{
   if (edge_type == 'a')
     geom.add_missing_impl_edges();
   else if (edge_type == 'i') {
@@ -191,62 +243,53 @@ void oq_opts::process_command_line(int argc, char **argv)
   else
     max_elem_sz = geom.faces().size();
 
+  Status stat;
   for (auto &arg : args) {
-    c = arg.first;
-    char *optarg = arg.second;
+    char c = arg.first;
+    string arg_str = arg.second; // the list readers modify the argument
+    char *optarg = &arg_str[0];
     switch (c) {
     case 'c':
       if (strcmp(optarg, "C") == 0)
         center_is_centroid = true;
-      else
-        print_status_or_exit(center.read(optarg), c);
+      else if (!(stat = center.read(optarg)))
+        return option_status(stat, c);
       break;
 
     case 'I':
-      print_status_or_exit(read_idx_list(optarg, idx_list, max_elem_sz, false),
-                           c);
+      if (!(stat = read_idx_list(optarg, idx_list, max_elem_sz, false)))
+        return option_status(stat, c);
       if (!idx_list.size())
-        warning("file contains no elements of this query type", c);
+        warns.push_back(option_status(
+            Status::warning("file contains no elements of this query type"),
+            c));
       add_to_list(idxs, idx_list);
       break;
 
     case 'v':
-      print_status_or_exit(vec.read(optarg), c);
+      if (!(stat = vec.read(optarg)))
+        return option_status(stat, c);
       extra_verts.push_back(vec);
       break;
 
     case 'f':
-      print_status_or_exit(
-          read_idx_list(optarg, idx_list, geom.verts().size(), true), c);
+      if (!(stat = read_idx_list(optarg, idx_list, geom.verts().size(), true)))
+        return option_status(stat, c);
       extra_faces.push_back(idx_list);
       break;
 
     case 'e':
-      print_status_or_exit(
-          read_idx_list(optarg, idx_list, geom.verts().size(), true), c);
+      if (!(stat = read_idx_list(optarg, idx_list, geom.verts().size(), true)))
+        return option_status(stat, c);
       if (!is_even(idx_list.size()))
-        error("odd number of vertex index numbers", c);
+        return option_status(
+            Status::error("odd number of vertex index numbers"), c);
       for (unsigned int i = 0; i < idx_list.size() / 2; i++) {
         edge[0] = idx_list[2 * i];
         edge[1] = idx_list[2 * i + 1];
         extra_edges.push_back(edge);
       }
       break;
-
-    case 'k':
-      orient = false;
-      break;
-
-    case 'd':
-      print_status_or_exit(read_int(optarg, &sig_digits), c);
-      break;
-
-    case 'o':
-      ofile = optarg;
-      break;
-
-    default:
-      error("unknown command line error");
     }
   }
 
@@ -267,21 +310,25 @@ void oq_opts::process_command_line(int argc, char **argv)
   for (auto &extra_face : extra_faces)
     for (int j : extra_face)
       if (j > total_verts - 1)
-        error(msg_str("extra face vertex x%d out of range",
-                      j - (int)geom.verts().size()),
-              'f');
+        return option_status(
+            Status::error(msg_str("extra face vertex x%d out of range",
+                                  j - (int)geom.verts().size())),
+            'f');
 
   for (auto &extra_edge : extra_edges)
     for (int j : extra_edge)
       if (j > total_verts - 1)
-        error(msg_str("extra edge vertex x%d out of range",
-                      j - (int)geom.verts().size()),
-              'e');
+        return option_status(
+            Status::error(msg_str("extra edge vertex x%d out of range",
+                                  j - (int)geom.verts().size())),
+            'e');
 
   int total_elems = max_elem_sz + query_elems_added;
   for (int idx : idxs)
     if (idx > total_elems - 1)
-      error(msg_str("index x%d out of range", idx - max_elem_sz), 'I');
+      return option_status(
+          Status::error(msg_str("index x%d out of range", idx - max_elem_sz)),
+          'I');
 
   if (!idxs.size()) { // default, process all if none specified
     char all[MSG_SZ] = "-";
@@ -289,7 +336,10 @@ void oq_opts::process_command_line(int argc, char **argv)
     add_to_list(idxs, idx_list);
   }
   if (!idxs.size()) // default, process all if none specified
-    error("no elements of the query type are in the geometry or were added");
+    return Status::error(
+        "no elements of the query type are in the geometry or were added");
+
+  return Status::ok();
 }
 
 void vertex_query(FILE *ofile, rep_printer &rep, oq_opts &opts)
@@ -449,25 +499,14 @@ void face_query(FILE *ofile, rep_printer &rep, oq_opts &opts)
   }
 }
 
-int main(int argc, char *argv[])
+// Query a model, the model is modified
+void query(Geometry &geom, oq_opts &opts, FILE *ofile)
 {
-  oq_opts opts;
-  opts.process_command_line(argc, argv);
-  Geometry &geom = opts.geom;
-
-  if (opts.center_is_centroid)
-    opts.center = geom.centroid();
-
-  FILE *ofile = stdout; // write to stdout by default
-  if (opts.ofile != "") {
-    ofile = fopen(opts.ofile.c_str(), "w");
-    if (ofile == nullptr)
-      opts.error("could not open output file '%s'", opts.ofile.c_str());
-  }
+  Vec3d center = (opts.center_is_centroid) ? geom.centroid() : opts.center;
 
   rep_printer rep(geom, ofile);
   rep.set_sig_dgts(opts.sig_digits);
-  rep.set_center(opts.center);
+  rep.set_center(center);
   rep.is_oriented(); // set oriented value before orienting
   if (opts.orient) {
     geom.orient();
@@ -498,6 +537,62 @@ int main(int argc, char *argv[])
     face_query(ofile, rep, opts);
     break;
   }
+}
+
+// Add the rows of a query to a record, keyed by element
+void add_query_fields(BatchRecord &rec, char elem, const string &rows)
+{
+  size_t pos = 0;
+  while (pos < rows.size()) {
+    size_t end = rows.find('\n', pos);
+    if (end == string::npos)
+      end = rows.size();
+    string row = rows.substr(pos, end - pos);
+    pos = end + 1;
+
+    size_t comma = row.find(',');
+    string key = string() + elem + row.substr(0, comma);
+    string val = (comma != string::npos) ? row.substr(comma + 1) : "";
+    rec.push_back(std::make_pair(key, val));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  oq_opts opts;
+  opts.process_command_line(argc, argv);
+
+  BatchInputs inputs;
+  if (opts.batch_fmt)
+    for (auto &ifile : opts.ifiles)
+      opts.print_status_or_exit(inputs.add(ifile));
+
+  FILE *ofile = stdout; // write to stdout by default
+  if (opts.ofile != "") {
+    ofile = fopen(opts.ofile.c_str(), "w");
+    if (ofile == nullptr)
+      opts.error("could not open output file '%s'", opts.ofile.c_str());
+  }
+
+  if (opts.batch_fmt) {
+    BatchWriter writer(ofile, opts.batch_fmt);
+    run_batch(
+        inputs,
+        [&](int, Geometry &geom, BatchRecord &rec) {
+          oq_opts model_opts = opts; // elements are set for each model
+          vector<Status> warns;
+          Status stat = model_opts.set_elems(geom, warns);
+          if (stat.is_error())
+            return stat;
+          string rows = capture_output(
+              [&](FILE *file) { query(geom, model_opts, file); });
+          add_query_fields(rec, opts.query[0], rows);
+          return (warns.size()) ? warns[0] : stat;
+        },
+        writer);
+  }
+  else
+    query(opts.geom, opts, ofile);
 
   if (opts.ofile == "")
     fclose(ofile);
@@ -37,6 +37,7 @@
 #include <vector>
 
 #include "../base/antiprism.h"
+#include "batch.h"
 #include "rep_print.h"
 
 using std::set;
@@ -56,13 +57,14 @@ public:
   bool detect_symmetry;
   string sub_sym;
   char edge_type;
-  string ifile;
+  char batch_fmt;
+  vector<string> ifiles;
   string ofile;
 
   or_opts()
       : ProgramOpts("off_report"), center(Vec3d(0, 0, 0)),
         center_is_centroid(false), sig_digits(17), orient(true),
-        detect_symmetry(false), edge_type('a')
+        detect_symmetry(false), edge_type('a'), batch_fmt('\0')
   {
   }
 
@@ -76,8 +78,11 @@ void or_opts::usage()
    fprintf(stdout,
 "\n"
 "Usage: %s [options] [input_file]\n"
+"       %s -B <fmt> [options] [inputs]\n"
 "\n"
-"Read a file in OFF format and generate a report\n"
+"Read a file in OFF format and generate a report. With option -B, report on\n"
+"a batch of models, from files, directories of OFF files, archives, or\n"
+"OFF files one after another on standard input.\n"
 "\n"
 "Options\n"
 "%s"
@@ -103,8 +108,11 @@ void or_opts::usage()
 "  -o <file> write output to file (default: write to standard output)\n"
 "  -d <dgts> number of significant digits (default 17) or if negative\n"
 "            then the number of digits after the decimal point\n"
+"  -B <fmt>  batch mode, report on each model as a record of 'section.key'\n"
+"            values, in the order of the inputs, fmt is j - JSON lines,\n"
+"            c - CSV\n"
 "\n"
-"\n", prog_name(), help_ver_text);
+"\n", prog_name(), prog_name(), help_ver_text);
 }
 // clang-format on
 
@@ -115,7 +123,7 @@ void or_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hc:S:C:kE:y:o:d:")) != -1) {
+  while ((c = getopt(argc, argv, ":hc:S:C:kE:y:o:d:B:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -194,16 +202,22 @@ void or_opts::process_command_line(int argc, char **argv)
       ofile = optarg;
       break;
 
+    case 'B':
+      print_status_or_exit(read_batch_format(optarg, &batch_fmt), c);
+      break;
+
     default:
       error("unknown command line error");
     }
   }
 
-  if (argc - optind > 1)
+  if (!batch_fmt && argc - optind > 1)
     error("too many arguments");
 
-  if (argc - optind == 1)
-    ifile = argv[optind];
+  while (argc - optind)
+    ifiles.push_back(argv[optind++]);
+  if (!ifiles.size())
+    ifiles.push_back("");
 
   if (sections == "" && counts == "") {
     warning("no print options set, setting option -S G");
@@ -282,14 +296,9 @@ void print_counts(rep_printer &rep, const char *counts)
   }
 }
 
-int main(int argc, char *argv[])
+// Report on a model, the model is modified
+Status report(Geometry &geom, or_opts &opts, FILE *ofile)
 {
-  or_opts opts;
-  opts.process_command_line(argc, argv);
-
-  Geometry geom;
-  opts.read_or_error(geom, opts.ifile);
-
   if (opts.edge_type == 'a')
     geom.add_missing_impl_edges();
   else if (opts.edge_type == 'i') {
@@ -297,22 +306,14 @@ int main(int argc, char *argv[])
     geom.add_missing_impl_edges();
   }
 
-  if (opts.center_is_centroid)
-    opts.center = geom.centroid();
-
-  FILE *ofile = stdout; // write to stdout by default
-  if (opts.ofile != "") {
-    ofile = fopen(opts.ofile.c_str(), "w");
-    if (ofile == nullptr)
-      opts.error("could not open output file '" + opts.ofile + "'");
-  }
+  Vec3d center = (opts.center_is_centroid) ? geom.centroid() : opts.center;
 
   rep_printer rep(geom, ofile);
   rep.set_sig_dgts(opts.sig_digits);
-  rep.set_center(opts.center);
+  rep.set_center(center);
 
   if (opts.detect_symmetry && !rep.set_sub_symmetry(opts.sub_sym))
-    opts.error(("could not set subsymmetry: " + opts.sub_sym).c_str(), 'y');
+    return Status::error("could not set subsymmetry: " + opts.sub_sym);
 
   rep.is_oriented(); // set oriented value before orienting
   if (opts.orient) {
@@ -324,6 +325,46 @@ int main(int argc, char *argv[])
   print_sections(rep, opts.sections.c_str());
   print_counts(rep, opts.counts.c_str());
 
+  return Status::ok();
+}
+
+int main(int argc, char *argv[])
+{
+  or_opts opts;
+  opts.process_command_line(argc, argv);
+
+  BatchInputs inputs;
+  Geometry geom;
+  if (opts.batch_fmt) {
+    for (auto &ifile : opts.ifiles)
+      opts.print_status_or_exit(inputs.add(ifile));
+  }
+  else
+    opts.read_or_error(geom, opts.ifiles[0]);
+
+  FILE *ofile = stdout; // write to stdout by default
+  if (opts.ofile != "") {
+    ofile = fopen(opts.ofile.c_str(), "w");
+    if (ofile == nullptr)
+      opts.error("could not open output file '" + opts.ofile + "'");
+  }
+
+  if (opts.batch_fmt) {
+    BatchWriter writer(ofile, opts.batch_fmt);
+    run_batch(
+        inputs,
+        [&](int, Geometry &geom, BatchRecord &rec) {
+          Status stat;
+          add_report_fields(rec, capture_output([&](FILE *file) {
+                              stat = report(geom, opts, file);
+                            }));
+          return stat;
+        },
+        writer);
+  }
+  else
+    opts.print_status_or_exit(report(geom, opts, ofile), 'y');
+
   if (opts.ofile == "")
     fclose(ofile);
 
@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <ctype.h>
+#include <functional>
 #include <map>
 #include <math.h>
 #include <memory>
@@ -41,6 +42,7 @@
 
 #include "../base/antiprism.h"
 
+#include "batch.h"
 #include "help.h"
 
 using std::map;
@@ -1172,16 +1174,27 @@ bool add_elements(Geometry &geom, vector<string> add_elems, char *errmsg)
   return true;
 }
 
+// An operation on the model, in place
+typedef std::function<Status(Geometry &)> Operation;
+
 class pr_opts : public ProgramOpts {
 public:
-  Geometry geom;
+  vector<string> ifiles;
+  vector<Operation> ops;
   int sig_digits;
+  char batch_fmt;
 
   string ofile;
 
-  pr_opts() : ProgramOpts("off_util"), sig_digits(DEF_SIG_DGTS) {}
+  pr_opts()
+      : ProgramOpts("off_util"), sig_digits(DEF_SIG_DGTS), batch_fmt('\0')
+  {
+  }
   void process_command_line(int argc, char **argv);
   void usage();
+
+  // apply the operations in order, stopping at an error
+  Status apply_ops(Geometry &geom, vector<Status> &warns) const;
 };
 
 // clang-format off
@@ -1199,7 +1212,10 @@ void pr_opts::usage()
 "vertices, and converting edges to quadrilaterals. Operations are performeded\n"
 "in the order they are given on the command line. input_files is the list of\n"
 "files to process, which may include 'null' as an empty geometry, or if not\n"
-"given the program reads from standard input.\n"
+"given the program reads from standard input. With option -B, the input\n"
+"models are processed separately, as a batch, and the inputs may also be\n"
+"directories of OFF files, archives, or OFF files one after another on\n"
+"standard input.\n"
 "\n"
 "Options\n"
 "%s"
@@ -1268,6 +1284,10 @@ void pr_opts::usage()
 "  -d <dgts> number of significant digits (default %d) or if negative\n"
 "            then the number of digits after the decimal point\n"
 "  -o <file> write output to file (default: write to standard output)\n"
+"  -B <fmt>  batch mode, write a record for each processed model, with the\n"
+"            off_report general values, in the order of the inputs, to\n"
+"            standard output, and write the models to archive file -o,\n"
+"            fmt is j - JSON lines, c - CSV\n"
 "\n"
 "\n", prog_name(), help_ver_text, int(-log(::epsilon)/log(10) + 0.5), ::epsilon, DEF_SIG_DGTS);
 }
@@ -1318,7 +1338,6 @@ const char *get_help(const char *name)
 
 void pr_opts::process_command_line(int argc, char **argv)
 {
-  char errmsg[MSG_SZ];
   opterr = 0;
   int c;
   vector<char *> parts;
@@ -1331,7 +1350,8 @@ void pr_opts::process_command_line(int argc, char **argv)
   handle_long_opts(argc, argv);
 
   bool trailing_option_l = false; // to warn if there is an -l after a -M
-  while ((c = getopt(argc, argv, ":hH:st:O:d:x:eD:K:A:c:gT:SM:l:u:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hH:st:O:d:x:eD:K:A:c:gT:SM:l:u:o:B:")) !=
+         -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -1357,35 +1377,31 @@ void pr_opts::process_command_line(int argc, char **argv)
   if (trailing_option_l)
     warning("limit ignored as not followed by a merge operation (-M)", 'l');
 
-  vector<string> ifiles;
   while (argc - optind)
     ifiles.push_back(string(argv[optind++]));
 
   if (!ifiles.size())
     ifiles.push_back("");
 
-  // Append all input files
-  for (auto &ifile : ifiles) {
-    Geometry geom_arg;
-    if (ifile != "null")
-      read_or_error(geom_arg, ifile);
-    geom.append(geom_arg);
-  }
-
+  // Operations are made from the arguments in order, so an operation uses
+  // the settings, like -l, given before it
   int sig_compare = INT_MAX;
-  vector<string> add_elems;
 
   for (auto &arg : args) {
     c = arg.first;
     char *optarg = arg.second;
     switch (c) {
-    case 'O':
+    case 'O': {
       print_status_or_exit(get_arg_id(optarg, &arg_id,
                                       "positive=1|negative=2|reverse=3|flip=4",
                                       argmatch_add_id_maps),
                            c);
-      print_status_or_exit(geom.orient(atoi(arg_id.c_str())), c);
+      int orient_type = atoi(arg_id.c_str());
+      ops.push_back([=](Geometry &geom) {
+        return option_status(geom.orient(orient_type), c);
+      });
       break;
+    }
 
     case 'T': {
       vector<char *> parts;
@@ -1403,68 +1419,59 @@ void pr_opts::process_command_line(int argc, char **argv)
           error("truncation vertex order is not positive", c);
       }
 
-      truncate_verts(geom, trunc_ratio, trunc_v_ord);
+      ops.push_back([=](Geometry &geom) {
+        truncate_verts(geom, trunc_ratio, trunc_v_ord);
+        return Status::ok();
+      });
       break;
     }
 
     case 's':
-      make_skeleton(geom);
+      ops.push_back([](Geometry &geom) {
+        make_skeleton(geom);
+        return Status::ok();
+      });
       break;
 
-    case 't':
+    case 't': {
       if (!get_arg_id(optarg, &arg_id,
                       "odd|nonzero|positive|negative|triangulate=1"))
         error(msg_str("invalid winding rule '%s'", optarg).c_str(), c);
 
-      triangulate_faces(geom, TESS_WINDING_ODD + atoi(arg_id.c_str()));
+      unsigned int winding_rule = TESS_WINDING_ODD + atoi(arg_id.c_str());
+      ops.push_back([=](Geometry &geom) {
+        triangulate_faces(geom, winding_rule);
+        return Status::ok();
+      });
       break;
+    }
 
     case 'd':
       print_status_or_exit(read_int(optarg, &sig_digits), c);
       break;
 
-    case 'x':
+    case 'x': {
       if (strspn(optarg, "vefVEFD") != strlen(optarg))
         error(msg_str("elements to hide are %s, can only include "
                       "vefVEFD\n",
                       optarg),
               c);
-      filter(geom, optarg);
+      string elems = optarg;
+      ops.push_back([=](Geometry &geom) {
+        filter(geom, elems.c_str());
+        return Status::ok();
+      });
       break;
+    }
 
     case 'e':
-      geom.add_missing_impl_edges();
+      ops.push_back([](Geometry &geom) {
+        geom.add_missing_impl_edges();
+        return Status::ok();
+      });
       break;
 
-    case 'D': {
-      bool invert = (optarg[strlen(optarg) - 1] == '%') ? true : false;
-      bool forward_error =
-          ((strlen(optarg) > 1) && (optarg[strlen(optarg) - 2] == '%')) ? true
-                                                                        : false;
-      vector<char *> entries;
-      split_line(optarg, entries, "%");
-      if (!entries.size())
-        error("invalid argument", c);
-      if (entries.size() > 1 || forward_error)
-        error("extra characters found after %", c);
-      vector<string> del_elems;
-      del_elems.push_back(entries[0]);
-      string invert_del;
-      if (invert) {
-        if (entries[0][0] == 'f' || entries[0][0] == 'F')
-          invert_del = 'f';
-        else if (entries[0][0] == 'e' || entries[0][0] == 'E')
-          invert_del = 'e';
-        else if (entries[0][0] == 'v')
-          invert_del = 'v';
-      }
-      if (!delete_elements(geom, del_elems, false, invert_del, false, errmsg))
-        error(errmsg, c);
-      if (*errmsg)
-        warning(errmsg);
-      break;
-    }
-
+    case 'D':
     case 'K': {
       bool invert = (optarg[strlen(optarg) - 1] == '%') ? true : false;
       bool forward_error =
@@ -1487,29 +1494,51 @@ void pr_opts::process_command_line(int argc, char **argv)
         else if (entries[0][0] == 'v')
           invert_del = 'v';
       }
-      if (!delete_elements(geom, del_elems, true, invert_del, false, errmsg))
-        error(errmsg, c);
+      bool keep = (c == 'K');
+      ops.push_back([=](Geometry &geom) {
+        char errmsg[MSG_SZ];
+        vector<string> elems = del_elems;
+        if (!delete_elements(geom, elems, keep, invert_del, false, errmsg))
+          return option_status(Status::error(errmsg), c);
+        if (!keep && *errmsg)
+          return Status::warning(errmsg);
+        return Status::ok();
+      });
       break;
     }
 
-    case 'A':
-      add_elems.clear();
-      add_elems.push_back(optarg);
-      if (!add_elements(geom, add_elems, errmsg))
-        error(errmsg, c);
+    case 'A': {
+      vector<string> add_elems(1, optarg);
+      ops.push_back([=](Geometry &geom) {
+        char errmsg[MSG_SZ];
+        vector<string> elems = add_elems;
+        if (!add_elements(geom, elems, errmsg))
+          return option_status(Status::error(errmsg), c);
+        return Status::ok();
+      });
       break;
+    }
 
     case 'g':
-      geometry_only(geom);
+      ops.push_back([](Geometry &geom) {
+        geometry_only(geom);
+        return Status::ok();
+      });
       break;
 
     case 'c':
       print_status_or_exit(close_col.read(optarg), c);
-      close_poly_basic(geom, close_col);
+      ops.push_back([=](Geometry &geom) {
+        close_poly_basic(geom, close_col);
+        return Status::ok();
+      });
       break;
 
     case 'S':
-      project_onto_sphere(geom);
+      ops.push_back([](Geometry &geom) {
+        project_onto_sphere(geom);
+        return Status::ok();
+      });
       break;
 
     case 'M': {
@@ -1552,27 +1581,32 @@ void pr_opts::process_command_line(int argc, char **argv)
       // Process
       double epsilon =
           (sig_compare != INT_MAX) ? pow(10, -sig_compare) : ::epsilon;
-      if (*elems == 'b') {
-        merge_coincident_elements(geom, "ve", blend_type, epsilon);
-        Geometry tmp = geom;
-        vector<map<int, set<int>>> equiv_elems;
-        check_congruence(geom, tmp, &equiv_elems, epsilon);
-        vector<int> del_faces;
-        map<int, set<int>>::iterator mi;
-        for (mi = equiv_elems[2].begin(); mi != equiv_elems[2].end(); ++mi) {
-          set<int>::iterator si;
-          si = mi->second.begin();
-          ++si;
-          if (si != mi->second.end() && *si < (int)(geom.faces().size())) {
-            for (si = mi->second.begin(); si != mi->second.end(); ++si) {
-              del_faces.push_back(*si);
+      string merge_elems = elems;
+      ops.push_back([=](Geometry &geom) {
+        if (merge_elems == "b") {
+          merge_coincident_elements(geom, "ve", blend_type, epsilon);
+          Geometry tmp = geom;
+          vector<map<int, set<int>>> equiv_elems;
+          check_congruence(geom, tmp, &equiv_elems, epsilon);
+          vector<int> del_faces;
+          map<int, set<int>>::iterator mi;
+          for (mi = equiv_elems[2].begin(); mi != equiv_elems[2].end(); ++mi) {
+            set<int>::iterator si;
+            si = mi->second.begin();
+            ++si;
+            if (si != mi->second.end() && *si < (int)(geom.faces().size())) {
+              for (si = mi->second.begin(); si != mi->second.end(); ++si) {
+                del_faces.push_back(*si);
+              }
             }
           }
+          geom.del(FACES, del_faces);
         }
-        geom.del(FACES, del_faces);
-      }
-      else
-        merge_coincident_elements(geom, elems, blend_type, epsilon);
+        else
+          merge_coincident_elements(geom, merge_elems.c_str(), blend_type,
+                                    epsilon);
+        return Status::ok();
+      });
       break;
     }
 
@@ -1610,10 +1644,13 @@ void pr_opts::process_command_line(int argc, char **argv)
           unzip_z_align = true;
       }
 
-      if (!unzip_poly(geom, unzip_root, unzip_frac, unzip_centre, unzip_z_align,
-                      errmsg))
-        error(errmsg, 'u');
-
+      ops.push_back([=](Geometry &geom) {
+        char errmsg[MSG_SZ];
+        if (!unzip_poly(geom, unzip_root, unzip_frac, unzip_centre,
+                        unzip_z_align, errmsg))
+          return option_status(Status::error(errmsg), 'u');
+        return Status::ok();
+      });
       break;
     }
 
@@ -1621,18 +1658,95 @@ void pr_opts::process_command_line(int argc, char **argv)
       ofile = optarg;
       break;
 
+    case 'B':
+      print_status_or_exit(read_batch_format(optarg, &batch_fmt), c);
+      break;
+
     default:
       error("unknown command line error");
     }
   }
 }
 
+Status pr_opts::apply_ops(Geometry &geom, vector<Status> &warns) const
+{
+  for (auto &op : ops) {
+    Status stat = op(geom);
+    if (stat.is_error())
+      return stat;
+    else if (stat.is_warning())
+      warns.push_back(stat);
+  }
+  return Status::ok();
+}
+
+// Apply the operations to a batch of models, the results are written to
+// an archive
+void process_batch(pr_opts &opts)
+{
+  BatchInputs inputs;
+  for (auto &ifile : opts.ifiles)
+    if (ifile != "null")
+      opts.print_status_or_exit(inputs.add(ifile));
+
+  ArchiveWriter arc;
+  if (opts.ofile != "")
+    opts.print_status_or_exit(arc.open(opts.ofile), 'o');
+
+  vector<Geometry> results(inputs.size());
+  vector<bool> made(inputs.size(), false);
+  BatchWriter writer(stdout, opts.batch_fmt);
+  run_batch(
+      inputs,
+      [&](int idx, Geometry &geom, BatchRecord &rec) {
+        vector<Status> warns;
+        Status stat = opts.apply_ops(geom, warns);
+        if (stat.is_error())
+          return stat;
+        if (opts.ofile != "") {
+          results[idx] = geom;
+          made[idx] = true;
+        }
+        add_general_fields(rec, geom);
+        return (warns.size()) ? warns[0] : stat;
+      },
+      writer);
+
+  if (opts.ofile != "") {
+    for (int i = 0; i < inputs.size(); i++)
+      if (made[i])
+        opts.print_status_or_exit(
+            arc.add(inputs.get_name(i), results[i], opts.sig_digits), 'o');
+    opts.print_status_or_exit(arc.close(), 'o');
+  }
+}
+
 int main(int argc, char *argv[])
 {
   pr_opts opts;
   opts.process_command_line(argc, argv);
 
-  opts.write_or_error(opts.geom, opts.ofile, opts.sig_digits);
+  if (opts.batch_fmt) {
+    process_batch(opts);
+    return 0;
+  }
+
+  // Append all input files
+  Geometry geom;
+  for (auto &ifile : opts.ifiles) {
+    Geometry geom_arg;
+    if (ifile != "null")
+      opts.read_or_error(geom_arg, ifile);
+    geom.append(geom_arg);
+  }
+
+  vector<Status> warns;
+  Status stat = opts.apply_ops(geom, warns);
+  for (auto &warn : warns)
+    opts.print_status_or_exit(warn);
+  opts.print_status_or_exit(stat);
+
+  opts.write_or_error(geom, opts.ofile, opts.sig_digits);
 
   return 0;
 }
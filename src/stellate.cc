@@ -61,6 +61,7 @@ public:
   string output_parts;
   bool move_to_front;
   int projection_width;
+  string cache_dir;
 
   char vertex_coloring_method;
   char edge_coloring_method;
@@ -117,6 +118,8 @@ void stellate_opts::usage()
 "               F - highlighted faces only (when using D, S or R)\n"
 "  -z        move first diagram to face front (out of symmetry alignment)\n"
 "  -w <int>  width to project stellation diagram (default: 500)\n"
+"  -K <dir>  cache stellation diagrams in directory, to reuse in later runs\n"
+"            (default: $ANTIPRISM_STELLATION_CACHE, if set)\n"
 "  -l <lim>  minimum distance for unique vertex locations as negative exponent\n"
 "               (default: %d giving %.0e)\n"
 "  -o <file> write output to file (default: write to standard output)\n"
@@ -146,7 +149,7 @@ void stellate_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hf:s:MISRDrzw:O:V:E:F:T:m:l:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hf:s:MISRDrzw:K:O:V:E:F:T:m:l:o:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -195,6 +198,10 @@ void stellate_opts::process_command_line(int argc, char **argv)
         error("projection width must be greater than zero", c);
       break;
 
+    case 'K':
+      cache_dir = optarg;
+      break;
+
     case 'O':
       if (strspn(optarg, "sdiDSFR") != strlen(optarg))
         error(msg_str("output parts are '%s' must be any or all from "
@@ -614,12 +621,18 @@ int main(int argc, char *argv[])
     // will hold just 1 if it is just the stellation face
     if (idx_lists[i].size() > 1)
       display_diagrams_only = false;
+  }
 
-    // construct the diagrams
-    if (!diagrams[stellation_face_idx].verts().size())
-      diagrams[stellation_face_idx] =
-          make_stellation_diagram(geom, stellation_face_idx, opts.sym_str,
-                                  opts.projection_width, opts.epsilon);
+  // construct the diagrams
+  vector<int> stellation_face_idxs;
+  for (int i = 0; i < sz; i++)
+    stellation_face_idxs.push_back(idx_lists[i][0]);
+  set_stellation_diagram_cache(opts.cache_dir);
+  make_stellation_diagrams(geom, diagrams, stellation_face_idxs, opts.sym_str,
+                           opts.projection_width, opts.epsilon);
+
+  for (int i = 0; i < sz; i++) {
+    int stellation_face_idx = idx_lists[i][0];
 
     // check face index range. start from 1 since 0 is a placeholder for
     // stellation face